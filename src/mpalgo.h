@@ -0,0 +1,633 @@
+/* ****************************************************************
+ * Multiplatform parallel algorithm support; sort, prefix scan, and
+ * parallel copy and fill.
+ *  - mpalgo.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides data parallel algorithms over arrays of elements
+ * of any size, executed as tasks of a TaskScope on a ThreadPool.
+ *
+ * A parallel merge sort, psort(), has the interface of qsort(). The
+ * array is divided into one chunk per pool worker (of at least `grain`
+ * elements), chunks are sorted concurrently with qsort(), and sorted
+ * runs are merged pairwise, level by level, between the array and a
+ * temporary buffer. Every merge is split into pieces of roughly equal
+ * output, by binary search of the merge path (co-ranking), such that
+ * every level is executed by every worker.
+ *
+ * Parallel prefix scans, pscan_inclusive() and pscan_exclusive(), apply
+ * an associative operation (not necessarily commutative) in two passes;
+ * the total of every chunk is reduced concurrently, totals are scanned
+ * sequentially into chunk prefixes, and every chunk is then scanned
+ * concurrently from its prefix.
+ *
+ * Parallel copy and fill, pmemcpy() and pmemset(), split large ranges
+ * into cache line aligned blocks, one per thread of a ThreadGroup, with
+ * each thread pinned to a processor. Ranges exceeding the last level
+ * cache (which they would otherwise evict) are written with
+ * non-temporal stores, where available (SSE2), bypassing the caches and
+ * avoiding the read of destination lines before writing.
+ *
+ * The grain size is the minimum number of elements of a task; smaller
+ * arrays are processed on the calling thread. A pool may be NULL, in
+ * which case all processing is performed on the calling thread.
+ *
+ * NOTES:
+ * - The calling thread helps execute tasks while joining, and so
+ *   SHALL NOT hold locks required by other tasks of the pool.
+ * - psort() is not stable, as qsort() is not stable.
+ * - psort() requires a temporary buffer the size of the array.
+ * - A scan operation SHALL be of format:
+ *     // accumulate `elem` into `acc`, as acc = acc (op) elem
+ *     void scanop_functionname(void *acc, const void *elem);
+ * - Scans may be performed in place (in == out).
+ * - Copy and fill threads are created per call, and so are intended for
+ *   ranges of many megabytes; ranges of less than ALGO_MINCOPY bytes per
+ *   thread use fewer threads, down to the calling thread alone.
+ * - The last level cache size is queried once, on first use; where
+ *   unknown, ALGO_LLC bytes is assumed. Defining ALGO_STREAM before
+ *   inclusion fixes the minimum bytes of non-temporal stores instead.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial parallel merge sort and prefix scan implementation.
+ * Rev.2   2026-10-18
+ *   Added parallel copy and fill with non-temporal stores.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_ALGO_H_
+#define _MP_ALGO_H_  /* include guard */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "mppool.h"
+
+/* Default grain size, in elements, where a grain size of 0 is given */
+#define ALGO_GRAIN  4096
+
+/* Minimum bytes per thread of parallel copy and fill.
+ * May be overridden by defining ALGO_MINCOPY before inclusion. */
+#ifndef ALGO_MINCOPY
+#define ALGO_MINCOPY  (1L << 20)
+#endif
+
+/* Assumed last level cache size, in bytes, where unknown */
+#define ALGO_LLC  (16L << 20)
+
+/* Non-temporal (streaming) stores, where available */
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ALGO_SSE2
+#endif
+
+/* Scan operation function datatype */
+typedef void (ScanOp)(void *acc, const void *elem);
+
+/* A merge of two sorted runs of `src`, [a0, a1) and [b0, b1), into
+ * `dst` at `out` (element indices). A run copy has an empty b run. */
+typedef struct {
+   const char *src;
+   char *dst;
+   size_t size;
+   int (*cmp)(const void *, const void *);
+   size_t a0, a1, b0, b1, out;
+} ALGO_MERGE;
+
+/* A chunk of a sort or scan; the range [lo, hi) of elements, and for
+ * scans, the prefix (or NULL), accumulator and scratch element. */
+typedef struct {
+   const char *in;
+   char *out;
+   size_t size, lo, hi;
+   int (*cmp)(const void *, const void *);
+   ScanOp *op;
+   const char *prefix;
+   char *acc, *tmp;
+   int exclusive;
+} ALGO_CHUNK;
+
+/* A block of a parallel copy (src set) or fill (src NULL). */
+typedef struct {
+   char *dst;
+   const char *src;
+   size_t n;
+   int c;
+   int stream;          /* non-zero for non-temporal stores */
+   int done;
+} ALGO_BLOCK;
+
+/* Minimum bytes of a copy or fill using non-temporal stores; zero until
+ * first use. */
+static volatile size_t Stream_mpalgo;
+
+/* Execute `n` tasks of `func`, with arguments of `argsize` bytes at
+ * `args`, as tasks of a scope on a pool (or on the calling thread, if
+ * the pool is NULL or there is a single task). Tasks which cannot be
+ * spawned are executed on the calling thread.
+ * Returns 0 on success, else the first task error code. */
+static inline int algo_run(ThreadPool *pool, TaskFunc *func, void *args,
+   size_t n, size_t argsize)
+{
+   TaskScope scope;
+   size_t i;
+   int ecode, temp;
+
+   if(pool == NULL || n < 2 || scope_init(&scope, pool)) {
+      for(ecode = 0, i = 0; i < n; i++) {
+         temp = func((char *) args + (i * argsize));
+         if(temp && !ecode) ecode = temp;
+      }
+      return ecode;
+   }
+   /* the calling thread executes the last task, then helps */
+   for(ecode = 0, i = 0; i + 1 < n; i++) {
+      if(scope_spawn(&scope, func, (char *) args + (i * argsize))) {
+         temp = func((char *) args + (i * argsize));
+         if(temp && !ecode) ecode = temp;
+      }
+   }
+   temp = func((char *) args + (i * argsize));
+   if(temp && !ecode) ecode = temp;
+   temp = scope_join(&scope);
+   if(temp && !ecode) ecode = temp;
+
+   return ecode;
+}
+
+/* Determine the number of chunks of `n` elements, at most one per
+ * worker of a pool, of at least `grain` elements each. */
+static inline size_t algo_chunks(ThreadPool *pool, size_t n, size_t grain)
+{
+   size_t chunks;
+
+   chunks = pool ? (size_t) pool_threads(pool) : 1;
+   if(grain == 0) grain = ALGO_GRAIN;
+   if(chunks > n / grain) chunks = n / grain;
+
+   return chunks ? chunks : 1;
+}
+
+/* Task function sorting a chunk in place, with qsort(). */
+static inline int algo_sort_task(void *arg)
+{
+   ALGO_CHUNK *c = (ALGO_CHUNK *) arg;
+
+   qsort(c->out + (c->lo * c->size), c->hi - c->lo, c->size, c->cmp);
+
+   return 0;
+}
+
+/* Task function merging two sorted runs, preferring the `a` run on
+ * equal elements. */
+static inline int algo_merge_task(void *arg)
+{
+   ALGO_MERGE *m = (ALGO_MERGE *) arg;
+   const char *a, *ae, *b, *be;
+   char *d;
+   size_t size;
+
+   size = m->size;
+   a = m->src + (m->a0 * size);
+   ae = m->src + (m->a1 * size);
+   b = m->src + (m->b0 * size);
+   be = m->src + (m->b1 * size);
+   d = m->dst + (m->out * size);
+   while(a < ae && b < be) {
+      if(m->cmp(a, b) <= 0) {
+         memcpy(d, a, size);
+         a += size;
+      } else {
+         memcpy(d, b, size);
+         b += size;
+      }
+      d += size;
+   }
+   /* copy the remainder of either run */
+   if(a < ae) memcpy(d, a, (size_t) (ae - a));
+   if(b < be) memcpy(d, b, (size_t) (be - b));
+
+   return 0;
+}
+
+/* Find the co-rank of output position `k` of a merge of sorted runs
+ * `a` (`m` elements) and `b` (`n` elements), preferring `a` on equal
+ * elements. Returns the number of elements of `a` preceding position
+ * `k`; the remainder (k - result) precede it from `b`. */
+static inline size_t algo_corank(const char *a, size_t m, const char *b,
+   size_t n, size_t k, size_t size, int (*cmp)(const void *, const void *))
+{
+   size_t lo, hi, mid;
+
+   lo = k > n ? k - n : 0;
+   hi = k < m ? k : m;
+   while(lo < hi) {
+      mid = lo + ((hi - lo) / 2);
+      /* a[mid] precedes b[k - mid - 1]; more of `a` is required */
+      if(cmp(b + ((k - mid - 1) * size), a + (mid * size)) >= 0)
+         lo = mid + 1;
+      else hi = mid;
+   }
+
+   return lo;
+}
+
+/* Sort an array of `n` elements of `size` bytes, in parallel on a pool,
+ * as per qsort(), with chunks of at least `grain` elements (or 0 for
+ * ALGO_GRAIN). (BLOCKING)
+ * Returns 0 on success, else error code. */
+static inline int psort(ThreadPool *pool, void *base, size_t n, size_t size,
+   int (*cmp)(const void *, const void *), size_t grain)
+{
+   ALGO_CHUNK *chunk;
+   ALGO_MERGE *merge;
+   size_t *runs, chunks, threads, piece, nruns, nmerge, len, k, k1, q, i;
+   char *src, *dst, *tmp, *buf;
+   int ecode;
+
+   chunks = algo_chunks(pool, n, grain);
+   if(chunks < 2) {
+      if(n > 1) qsort(base, n, size, cmp);
+      return 0;
+   }
+   threads = (size_t) pool_threads(pool);
+
+   /* run boundaries, chunk tasks, merge tasks (fewer than two per
+    * worker, plus one per run, per level) and temporary buffer */
+   runs = (size_t *) malloc(sizeof(size_t) * (chunks + 1));
+   chunk = (ALGO_CHUNK *) malloc(sizeof(ALGO_CHUNK) * chunks);
+   merge = (ALGO_MERGE *)
+      malloc(sizeof(ALGO_MERGE) * ((threads * 2) + chunks + 1));
+   buf = (char *) malloc(n * size);
+   if(runs == NULL || chunk == NULL || merge == NULL || buf == NULL) {
+      ecode = ENOMEM;
+      goto FAIL;
+   }
+
+   /* sort chunks in place */
+   for(q = 0; q < chunks; q++) {
+      runs[q] = n * q / chunks;
+      chunk[q].out = (char *) base;
+      chunk[q].size = size;
+      chunk[q].lo = n * q / chunks;
+      chunk[q].hi = n * (q + 1) / chunks;
+      chunk[q].cmp = cmp;
+   }
+   runs[chunks] = n;
+   ecode = algo_run(pool, algo_sort_task, chunk, chunks, sizeof(ALGO_CHUNK));
+   if(ecode) goto FAIL;
+
+   /* merge pairs of runs, level by level, splitting merges into pieces
+    * of (about) equal output for every worker */
+   piece = n / threads;
+   if(piece < grain) piece = grain;
+   src = (char *) base;
+   dst = buf;
+   for(nruns = chunks; nruns > 1; nruns = (nruns + 1) / 2) {
+      for(nmerge = q = 0; q < nruns; q += 2) {
+         len = runs[q < nruns - 1 ? q + 2 : q + 1] - runs[q];
+         for(k = 0; k < len; k = k1) {
+            k1 = len - k > piece + (piece / 2) ? k + piece : len;
+            merge[nmerge].src = src;
+            merge[nmerge].dst = dst;
+            merge[nmerge].size = size;
+            merge[nmerge].cmp = cmp;
+            merge[nmerge].out = runs[q] + k;
+            if(q == nruns - 1) {
+               /* odd run; copied */
+               merge[nmerge].a0 = runs[q] + k;
+               merge[nmerge].a1 = runs[q] + k1;
+               merge[nmerge].b0 = merge[nmerge].b1 = 0;
+            } else {
+               i = algo_corank(src + (runs[q] * size),
+                  runs[q + 1] - runs[q], src + (runs[q + 1] * size),
+                  runs[q + 2] - runs[q + 1], k, size, cmp);
+               merge[nmerge].a0 = runs[q] + i;
+               merge[nmerge].b0 = runs[q + 1] + (k - i);
+               i = algo_corank(src + (runs[q] * size),
+                  runs[q + 1] - runs[q], src + (runs[q + 1] * size),
+                  runs[q + 2] - runs[q + 1], k1, size, cmp);
+               merge[nmerge].a1 = runs[q] + i;
+               merge[nmerge].b1 = runs[q + 1] + (k1 - i);
+            }
+            nmerge++;
+         }
+      }
+      ecode = algo_run(pool, algo_merge_task, merge, nmerge,
+         sizeof(ALGO_MERGE));
+      if(ecode) goto FAIL;
+      /* remove boundaries of merged runs */
+      for(q = 0; q < nruns; q += 2) runs[q / 2] = runs[q];
+      runs[(nruns + 1) / 2] = n;
+      tmp = src;
+      src = dst;
+      dst = tmp;
+   }
+
+   /* copy the result to the array, if in the temporary buffer */
+   if(src != (char *) base) {
+      for(nmerge = k = 0; k < n; k = k1, nmerge++) {
+         k1 = n - k > piece + (piece / 2) ? k + piece : n;
+         merge[nmerge].src = src;
+         merge[nmerge].dst = (char *) base;
+         merge[nmerge].size = size;
+         merge[nmerge].cmp = cmp;
+         merge[nmerge].out = merge[nmerge].a0 = k;
+         merge[nmerge].a1 = k1;
+         merge[nmerge].b0 = merge[nmerge].b1 = 0;
+      }
+      ecode = algo_run(pool, algo_merge_task, merge, nmerge,
+         sizeof(ALGO_MERGE));
+   }
+
+FAIL:
+   free(buf);
+   free(merge);
+   free(chunk);
+   free(runs);
+
+   return ecode;
+}
+
+/* Task function reducing a chunk into its accumulator (as the total of
+ * the chunk), or where `out` is set, scanning a chunk from its prefix. */
+static inline int algo_scan_task(void *arg)
+{
+   ALGO_CHUNK *c = (ALGO_CHUNK *) arg;
+   size_t i, size;
+
+   size = c->size;
+   i = c->lo;
+   if(c->prefix) memcpy(c->acc, c->prefix, size);
+   else {
+      /* the first element of an inclusive scan, without prefix */
+      memcpy(c->acc, c->in + (i * size), size);
+      if(c->out) memcpy(c->out + (i * size), c->acc, size);
+      i++;
+   }
+   if(c->out == NULL) {
+      for( ; i < c->hi; i++) c->op(c->acc, c->in + (i * size));
+   } else if(c->exclusive) {
+      for( ; i < c->hi; i++) {
+         /* read the element before writing, for in place scans */
+         memcpy(c->tmp, c->in + (i * size), size);
+         memcpy(c->out + (i * size), c->acc, size);
+         c->op(c->acc, c->tmp);
+      }
+   } else {
+      for( ; i < c->hi; i++) {
+         c->op(c->acc, c->in + (i * size));
+         memcpy(c->out + (i * size), c->acc, size);
+      }
+   }
+
+   return 0;
+}
+
+/* Scan an array of `n` elements of `size` bytes, in parallel on a pool,
+ * with an associative operation. An exclusive scan begins with `init`.
+ * Returns 0 on success, else error code. */
+static inline int algo_scan(ThreadPool *pool, const void *in, void *out,
+   size_t n, size_t size, ScanOp *op, const void *init, size_t grain)
+{
+   ALGO_CHUNK *chunk;
+   char *buf, *prefix;
+   size_t chunks, q;
+   int ecode;
+
+   if(n == 0) return 0;
+   chunks = algo_chunks(pool, n, grain);
+
+   /* chunk tasks, then per chunk: prefix, accumulator and scratch */
+   chunk = (ALGO_CHUNK *) malloc(sizeof(ALGO_CHUNK) * chunks);
+   buf = (char *) malloc(chunks * size * 3);
+   if(chunk == NULL || buf == NULL) {
+      free(buf);
+      free(chunk);
+      return ENOMEM;
+   }
+   for(q = 0; q < chunks; q++) {
+      chunk[q].in = (const char *) in;
+      chunk[q].out = NULL;
+      chunk[q].size = size;
+      chunk[q].lo = n * q / chunks;
+      chunk[q].hi = n * (q + 1) / chunks;
+      chunk[q].op = op;
+      chunk[q].prefix = NULL;
+      chunk[q].acc = buf + (((q * 3) + 1) * size);
+      chunk[q].tmp = buf + (((q * 3) + 2) * size);
+      chunk[q].exclusive = init != NULL;
+   }
+
+   /* reduce the totals of all chunks but the last */
+   ecode = algo_run(pool, algo_scan_task, chunk, chunks - 1,
+      sizeof(ALGO_CHUNK));
+   if(ecode == 0) {
+      /* scan totals into chunk prefixes */
+      for(q = 0; q < chunks; q++) {
+         prefix = buf + (q * 3 * size);
+         if(q == 0) {
+            if(init) memcpy(prefix, init, size);
+            else prefix = NULL;
+         } else if(chunk[q - 1].prefix) {
+            memcpy(prefix, chunk[q - 1].prefix, size);
+            op(prefix, chunk[q - 1].acc);
+         } else memcpy(prefix, chunk[q - 1].acc, size);
+         chunk[q].prefix = prefix;
+      }
+      /* scan every chunk from its prefix */
+      for(q = 0; q < chunks; q++) chunk[q].out = (char *) out;
+      ecode = algo_run(pool, algo_scan_task, chunk, chunks,
+         sizeof(ALGO_CHUNK));
+   }
+   free(buf);
+   free(chunk);
+
+   return ecode;
+}
+
+/* Inclusive scan (out[i] = in[0] op ... op in[i]), in parallel on a pool.
+ * (BLOCKING) Returns 0 on success, else error code. */
+#define pscan_inclusive(pool,in,out,n,size,op,grain) \
+   algo_scan(pool,in,out,n,size,op,NULL,grain)
+
+/* Exclusive scan (out[0] = init, out[i] = init op in[0] ... op in[i-1]),
+ * in parallel on a pool. (BLOCKING)
+ * Returns 0 on success, else error code. */
+#define pscan_exclusive(pool,in,out,n,size,op,init,grain) \
+   algo_scan(pool,in,out,n,size,op,init,grain)
+
+/* Copy (src set) or fill (src NULL) a block, with non-temporal stores
+ * to the 16 byte aligned body of the block, if `stream` is non-zero. */
+static inline void algo_block(ALGO_BLOCK *b)
+{
+   char *dst = b->dst;
+   const char *src = b->src;
+   size_t n = b->n, head;
+#ifdef ALGO_SSE2
+   __m128i v0, v1, v2, v3;
+
+   if(b->stream && n >= 128) {
+      head = (16 - ((size_t) dst & 15)) & 15;
+      if(src) {
+         memcpy(dst, src, head);
+         src += head;
+      } else memset(dst, b->c, head);
+      dst += head;
+      n -= head;
+      v0 = v1 = v2 = v3 = _mm_set1_epi8((char) b->c);
+      for( ; n >= 64; n -= 64, dst += 64) {
+         if(src) {
+            v0 = _mm_loadu_si128((const __m128i *) src);
+            v1 = _mm_loadu_si128((const __m128i *) (src + 16));
+            v2 = _mm_loadu_si128((const __m128i *) (src + 32));
+            v3 = _mm_loadu_si128((const __m128i *) (src + 48));
+            src += 64;
+         }
+         _mm_stream_si128((__m128i *) dst, v0);
+         _mm_stream_si128((__m128i *) (dst + 16), v1);
+         _mm_stream_si128((__m128i *) (dst + 32), v2);
+         _mm_stream_si128((__m128i *) (dst + 48), v3);
+      }
+      /* order streaming stores before any subsequent store */
+      _mm_sfence();
+   }
+#else
+   (void) head;
+#endif
+   if(src) memcpy(dst, src, n);
+   else memset(dst, b->c, n);
+   b->done = 1;
+}
+
+/* Thread function of a copy or fill block. */
+static inline Threaded algo_block_thread(void *arg)
+{
+   algo_block((ALGO_BLOCK *) arg);
+
+   return Treturn;
+}
+
+/* Obtain the size of the last level cache of the processor.
+ * Returns size in bytes, or 0 if unknown. */
+static inline size_t algo_cachesize(void)
+{
+   size_t size = 0;
+#ifdef _WIN32
+   SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info;
+   DWORD len = 0, i, level = 0;
+
+   GetLogicalProcessorInformation(NULL, &len);
+   info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION *) malloc(len);
+   if(info && GetLogicalProcessorInformation(info, &len)) {
+      for(i = 0; i < len / sizeof(*info); i++) {
+         if(info[i].Relationship != RelationCache) continue;
+         if(info[i].Cache.Level < level) continue;
+         level = info[i].Cache.Level;
+         size = info[i].Cache.Size;
+      }
+   }
+   free(info);
+#elif defined(_SC_LEVEL3_CACHE_SIZE)
+   long temp;
+
+   temp = sysconf(_SC_LEVEL3_CACHE_SIZE);
+   if(temp <= 0) temp = sysconf(_SC_LEVEL2_CACHE_SIZE);
+   if(temp > 0) size = (size_t) temp;
+#endif
+
+   return size;
+}
+
+/* Obtain the minimum bytes of a copy or fill using non-temporal stores;
+ * the last level cache size, unless ALGO_STREAM is defined. */
+static inline size_t algo_streamsize(void)
+{
+#ifdef ALGO_STREAM
+   return (size_t) ALGO_STREAM;
+#else
+   size_t size;
+
+   if(Stream_mpalgo == 0) {
+      size = algo_cachesize();
+      Stream_mpalgo = size ? size : (size_t) ALGO_LLC;
+   }
+
+   return Stream_mpalgo;
+#endif
+}
+
+/* Copy or fill `n` bytes with up to `threads` pinned threads (or 0 for
+ * one per processor). Blocks of threads that fail to spawn are completed
+ * by the calling thread, so the operation always completes. */
+static inline void algo_memory(void *dst, const void *src, int c,
+   size_t n, int threads)
+{
+   ThreadGroup group;
+   ThreadAttr attr;
+   ALGO_BLOCK single, *block = NULL;
+   size_t lo, hi;
+   int i, stream;
+
+   stream = n > algo_streamsize();
+   if(threads < 1) threads = thread_cpucount();
+   if((size_t) threads > n / ALGO_MINCOPY) {
+      threads = (int) (n / ALGO_MINCOPY);
+   }
+   if(threads > 1) {
+      block = (ALGO_BLOCK *) malloc(sizeof(ALGO_BLOCK) * (size_t) threads);
+   }
+   if(block == NULL) {
+      threads = 1;
+      block = &single;
+   }
+   /* split at cache line (64 byte) boundaries of the destination */
+   for(lo = 0, i = 0; i < threads; i++, lo = hi) {
+      hi = n * (size_t) (i + 1) / (size_t) threads;
+      if(i + 1 < threads) hi += (64 - (((size_t) dst + hi) & 63)) & 63;
+      if(hi > n) hi = n;
+      block[i].dst = (char *) dst + lo;
+      block[i].src = src ? (const char *) src + lo : NULL;
+      block[i].n = hi - lo;
+      block[i].c = c;
+      block[i].stream = stream;
+      block[i].done = 0;
+   }
+   if(threads > 1) {
+      attr.stacksize = 0;
+      attr.pin = 1;
+      /* spawn (or pinning) errors are recovered below */
+      thread_create_many(&group, threads, algo_block_thread, block,
+         sizeof(ALGO_BLOCK), &attr);
+      group_join(&group);
+   }
+   for(i = 0; i < threads; i++) {
+      if(!block[i].done) algo_block(&block[i]);
+   }
+   if(block != &single) free(block);
+}
+
+/* Copy `n` bytes from `src` to `dst` (which SHALL NOT overlap), with up
+ * to `threads` pinned threads, or 0 for one per processor. (BLOCKING) */
+#define pmemcpy(dst,src,n,threads)  algo_memory(dst,src,0,n,threads)
+
+/* Fill `n` bytes of `dst` with the byte `c`, with up to `threads` pinned
+ * threads, or 0 for one per processor. (BLOCKING) */
+#define pmemset(dst,c,n,threads)  algo_memory(dst,NULL,c,n,threads)
+
+
+#endif /* end _MP_ALGO_H_ */
@@ -0,0 +1,360 @@
+/* ****************************************************************
+ * Multiplatform micro-batching support; coalesce items from many
+ * threads into batches, flushed by count or by deadline.
+ *  - mpbatch.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a Batcher, which copies fixed size items appended
+ * by any number of threads into the current batch, and hands batches to
+ * a flush function on a background flusher thread. A batch is flushed
+ * when it holds `capacity` items, or `delay` microseconds (microseconds()
+ * of mptime.h) after its first item was appended, whichever is first,
+ * bounding the latency added by batching.
+ *
+ * An append reserves a slot of the current batch with a single atomic
+ * increment, copies the item, and commits it with a second; the thread
+ * reserving the last slot seals the batch. A batch is sealed early, by
+ * deadline or flush request, by swapping its reservation count for the
+ * capacity, such that subsequent reservations fail and retry with the
+ * next batch. The flusher waits for every reserved slot of a sealed
+ * batch to be committed before flushing it, then recycles the batch.
+ *
+ * NOTES:
+ * - Support functions requiring a Batcher param, SHALL be passed as
+ *   pointers.
+ * - A flush function SHALL be of format:
+ *     // flush `count` items, of the batcher item size, at `items`
+ *     void batchfunc_functionname(void *ctx, void *items, long count);
+ *   and is called by the flusher thread only, in order of sealing.
+ * - Appending is lock-free, except for the first and last item of each
+ *   batch, which lock to wake the flusher thread, and while every batch
+ *   is sealed (awaiting flush), where appending threads block until the
+ *   flusher recycles a batch.
+ * - Items of any single thread are flushed in order of appending.
+ * - The flusher thread waits on a millisecond timeout, and yields the
+ *   processor (spin_yield()) within the last millisecond of a deadline.
+ * - Items SHALL NOT be appended after, or during, batch_free().
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial Batcher implementation.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_BATCH_H_
+#define _MP_BATCH_H_  /* include guard */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpthread.h"
+#include "mptime.h"
+
+/* Number of batches of a Batcher (at least 2); one filling, the rest
+ * sealed or spare. May be overridden by defining BATCH_BUFFERS before
+ * inclusion. */
+#ifndef BATCH_BUFFERS
+#define BATCH_BUFFERS  4
+#endif
+
+/* Atomic operations on batch counters and the current batch pointer.
+ * MSVC volatile accesses carry acquire/release semantics by default
+ * (/volatile:ms). */
+#ifdef _MSC_VER
+#define batch_fetchadd(p,v)  InterlockedExchangeAdd((volatile LONG *) (p), v)
+#define batch_cas(p,old,v)  \
+   ( InterlockedCompareExchange((volatile LONG *) (p), v, old) == (old) )
+#define batch_acquire(p)     ( *(p) )
+#define batch_release(p,v)   ( *(p) = (v) )
+#else
+#define batch_fetchadd(p,v)  __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL)
+#define batch_cas(p,old,v)   __sync_bool_compare_and_swap(p, old, v)
+#define batch_acquire(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define batch_release(p,v)   __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+/* Flush function datatype */
+typedef void (BatchFunc)(void *ctx, void *items, long count);
+
+/* A batch of items. Reservations exceeding the capacity fail, and a
+ * spare batch holds a reservation count of the capacity. */
+typedef struct _BATCH {
+   volatile long reserved;    /* slots reserved */
+   char pad1[64 - sizeof(long)];
+   volatile long committed;   /* slots written */
+   char pad2[64 - sizeof(long)];
+   long count;          /* items at sealing */
+   long first;          /* microseconds() of the first append */
+   int started;         /* first append time is set */
+   int sealed;
+   struct _BATCH *next;
+   char *items;
+} BATCH;
+
+/* A micro-batcher. Batch lists, flush requests and statistics are
+ * guarded by `lock`. */
+typedef struct {
+   BATCH *volatile current;   /* batch being filled (or sealed) */
+   Mutex lock;
+   Condition wake;      /* signalled to wake the flusher thread */
+   Condition space;     /* signalled when a batch is installed */
+   Condition done;      /* signalled on completion of a flush request */
+   BATCH *spare;        /* recycled batches */
+   BATCH *full, *last;  /* sealed batches, in order of sealing */
+   BATCH batches[BATCH_BUFFERS];
+   BatchFunc *func;
+   void *ctx;
+   size_t size;
+   long capacity, delay;
+   unsigned long flushreq, flushed;
+   long long flushes;   /* batches flushed */
+   long long items;     /* items flushed */
+   long long deadlines; /* batches sealed by deadline */
+   ThreadID flusher;
+   int stop;
+} Batcher;
+
+/* Install a spare batch as the current batch, if the current batch is
+ * sealed. The Batcher lock SHALL be held. */
+static inline void batch_install(Batcher *b)
+{
+   BATCH *next = b->spare;
+
+   if(next == NULL || !b->current->sealed) return;
+   b->spare = next->next;
+   next->next = NULL;
+   next->started = next->sealed = 0;
+   batch_release(&next->committed, 0);
+   batch_release(&next->reserved, 0);
+   batch_release(&b->current, next);
+   condition_broadcast(&b->space);
+}
+
+/* Seal a batch, if it is the current batch, is not already sealed, and
+ * holds items, queueing it for the flusher thread. The Batcher lock
+ * SHALL be held. Returns non-zero if sealed. */
+static inline int batch_seal(Batcher *b, BATCH *batch)
+{
+   long r;
+
+   if(batch != b->current || batch->sealed) return 0;
+   do {
+      r = batch_acquire(&batch->reserved);
+      if(r <= 0) return 0;
+      if(r > b->capacity) r = b->capacity;
+   } while(r < b->capacity && !batch_cas(&batch->reserved, r, b->capacity));
+   batch->count = r;
+   batch->sealed = 1;
+   if(b->last) b->last->next = batch;
+   else b->full = batch;
+   b->last = batch;
+   batch_install(b);
+   condition_signal(&b->wake);
+
+   return 1;
+}
+
+/* Flush all sealed batches, recycling each. The Batcher lock SHALL be
+ * held, and is released while flushing. */
+static inline void batch_drain(Batcher *b)
+{
+   BATCH *batch;
+
+   while((batch = b->full) != NULL) {
+      b->full = batch->next;
+      if(b->full == NULL) b->last = NULL;
+      mutex_unlock(&b->lock);
+      /* wait for appends in progress to commit */
+      while(batch_acquire(&batch->committed) < batch->count) spin_yield();
+      b->func(b->ctx, batch->items, batch->count);
+      mutex_lock(&b->lock);
+      b->flushes++;
+      b->items += batch->count;
+      batch->next = b->spare;
+      b->spare = batch;
+      batch_install(b);
+   }
+}
+
+/* Batcher flusher thread. Seals batches by deadline or flush request,
+ * and flushes sealed batches, until the batcher is freed. */
+static inline Threaded batch_flusher(void *arg)
+{
+   Batcher *b;
+   BATCH *cur;
+   unsigned long req;
+   long remain;
+
+   b = (Batcher *) arg;
+   mutex_lock(&b->lock);
+   for( ; ; ) {
+      batch_drain(b);
+      req = b->flushreq;
+      if(req != b->flushed || b->stop) {
+         /* seal and flush everything appended before the request */
+         batch_seal(b, b->current);
+         batch_drain(b);
+         b->flushed = req;
+         condition_broadcast(&b->done);
+         if(b->stop) break;
+         continue;
+      }
+      cur = b->current;
+      if(cur->started && !cur->sealed) {
+         remain = cur->first + b->delay - microseconds();
+         if(remain <= 0) {
+            if(batch_seal(b, cur)) b->deadlines++;
+         } else if(remain >= 1000) {
+            condition_timedwait(&b->wake, &b->lock,
+               (unsigned long) (remain / 1000));
+         } else {
+            mutex_unlock(&b->lock);
+            spin_yield();
+            mutex_lock(&b->lock);
+         }
+      } else condition_wait(&b->wake, &b->lock);
+   }
+   mutex_unlock(&b->lock);
+
+   return Treturn;
+}
+
+/* Append an item of the batcher item size, copied from `item`, to the
+ * current batch. (BLOCKING, only while every batch is sealed)
+ * Returns 0 on success, else error code. */
+static inline int batch_append(Batcher *b, const void *item)
+{
+   BATCH *cur;
+   long i;
+
+   for( ; ; ) {
+      cur = batch_acquire(&b->current);
+      i = batch_fetchadd(&cur->reserved, 1);
+      if(i < b->capacity) break;
+      /* sealed; wait for the next batch, unless already installed */
+      mutex_lock(&b->lock);
+      while(batch_acquire(&b->current) == cur && cur->sealed)
+         condition_wait(&b->space, &b->lock);
+      mutex_unlock(&b->lock);
+   }
+   if(i == 0) {
+      /* first item starts the deadline */
+      mutex_lock(&b->lock);
+      cur->first = microseconds();
+      cur->started = 1;
+      condition_signal(&b->wake);
+      mutex_unlock(&b->lock);
+   }
+   memcpy(cur->items + (size_t) i * b->size, item, b->size);
+   batch_fetchadd(&cur->committed, 1);
+   if(i == b->capacity - 1) {
+      /* last item seals the batch */
+      mutex_lock(&b->lock);
+      batch_seal(b, cur);
+      mutex_unlock(&b->lock);
+   }
+
+   return 0;
+}
+
+/* Wait for all items appended before the call to be flushed. (BLOCKING)
+ * Returns 0 on success, else error code. */
+static inline int batch_flush(Batcher *b)
+{
+   unsigned long req;
+
+   mutex_lock(&b->lock);
+   req = ++b->flushreq;
+   condition_signal(&b->wake);
+   while((long) (req - b->flushed) > 0)
+      condition_wait(&b->done, &b->lock);
+
+   return mutex_unlock(&b->lock);
+}
+
+/* Initialize a batcher of items of `size` bytes, flushing batches of up
+ * to `capacity` items, at most `delay` microseconds after the first
+ * item of a batch, by calling `func` with `ctx`, and start its flusher
+ * thread. Returns 0 on success, else error code. */
+static inline int batch_init(Batcher *b, size_t size, long capacity,
+   long delay, BatchFunc *func, void *ctx)
+{
+   int i, ecode;
+
+   memset(b, 0, sizeof(*b));
+   if(size == 0 || capacity < 1 || delay < 0 || func == NULL)
+      return EINVAL;
+   b->size = size;
+   b->capacity = capacity;
+   b->delay = delay;
+   b->func = func;
+   b->ctx = ctx;
+   for(i = 0; i < BATCH_BUFFERS; i++) {
+      b->batches[i].items = (char *) malloc(size * (size_t) capacity);
+      if(b->batches[i].items == NULL) {
+         while(i--) free(b->batches[i].items);
+         return ENOMEM;
+      }
+      b->batches[i].reserved = capacity;
+      b->batches[i].sealed = 1;
+      if(i) {
+         b->batches[i].next = b->spare;
+         b->spare = &b->batches[i];
+      }
+   }
+   b->batches[0].reserved = 0;
+   b->batches[0].sealed = 0;
+   b->current = &b->batches[0];
+   mutex_init(&b->lock);
+   condition_init(&b->wake);
+   condition_init(&b->space);
+   condition_init(&b->done);
+
+   ecode = thread_create(&b->flusher, batch_flusher, b);
+   if(ecode) {
+      condition_free(&b->done);
+      condition_free(&b->space);
+      condition_free(&b->wake);
+      mutex_free(&b->lock);
+      for(i = 0; i < BATCH_BUFFERS; i++) free(b->batches[i].items);
+   }
+
+   return ecode;
+}
+
+/* Uninitialize a batcher, flushing all items appended before the call,
+ * and stopping its flusher thread.
+ * Returns 0 on success, else error code. */
+static inline int batch_free(Batcher *b)
+{
+   int i;
+
+   mutex_lock(&b->lock);
+   b->stop = 1;
+   condition_signal(&b->wake);
+   mutex_unlock(&b->lock);
+   thread_wait(&b->flusher);
+
+   for(i = 0; i < BATCH_BUFFERS; i++) free(b->batches[i].items);
+   condition_free(&b->done);
+   condition_free(&b->space);
+   condition_free(&b->wake);
+
+   return mutex_free(&b->lock);
+}
+
+
+#endif /* end _MP_BATCH_H_ */
@@ -0,0 +1,500 @@
+/* ****************************************************************
+ * Multiplatform cooperative cancellation support.
+ *  - mpcancel.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides cancellation tokens, used to request that a long
+ * running thread or pool task stop early. Cancellation is cooperative;
+ * a worker observes a request by either:
+ * - polling cancel_requested(), a single (volatile) read,
+ * - sleeping or waiting with cancel_sleep() or cancel_condwait(),
+ *   which return early, with ECANCELED, when cancellation is requested,
+ * - registering a CancelCallback, executed on cancellation request.
+ *
+ * A ThreadGroup spawns N identical threads with thread_create_many(),
+ * sharing attributes (stack size, processor pinning) and passed per
+ * index arguments. Threads spawn in a binary tree; each new thread
+ * spawns up to two further threads before running its function, such
+ * that the calling thread creates only the first. Spawning stops at
+ * the first error. A group is joined, or cancelled, as a whole; group
+ * threads observe cancellation through the CancelToken of the group,
+ * obtained with group_token().
+ *
+ * NOTES:
+ * - Support functions requiring a CancelToken or CancelCallback param,
+ *   SHALL be passed as pointers.
+ * - A CancelToken SHALL be initialized using cancel_init().
+ * - A CancelCallback is caller allocated, and SHALL remain valid until
+ *   it has either executed or been passed to cancel_unregister().
+ * - Callbacks are executed by the thread requesting cancellation, in
+ *   order of registration, without any token lock held. A callback
+ *   SHALL NOT unregister itself.
+ * - Every ThreadGroup passed to thread_create_many() SHALL be joined
+ *   with group_join(), even on error, which also frees the group.
+ *   Cancellation of a group is not considered an error of the group.
+ * - group_token() is process-wide; group functions observe the token
+ *   of their group in every translation unit.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial CancelToken implementation.
+ * Rev.2   2026-10-18
+ *   Added ThreadGroup and thread_create_many(), with group join/cancel.
+ * Rev.3   2026-10-18
+ *   The group token is now process-wide (ThreadShared storage).
+ *   Group spawning stops at the first error of the group.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_CANCEL_H_
+#define _MP_CANCEL_H_  /* include guard */
+
+
+#include <string.h>
+#include "mpthread.h"
+#include "mptime.h"
+
+#ifndef ECANCELED
+#define ECANCELED  125  /* cancelled error code, where undefined */
+#endif
+
+/* Cancellation callback function datatype */
+typedef void (CancelFunc)(void *arg);
+
+/* A cancellation callback registration, held by a token until either
+ * executed or unregistered. */
+typedef struct _CancelCallback {
+   CancelFunc *func;
+   void *arg;
+   struct _CancelCallback *next;
+} CancelCallback;
+
+/* A cancellation token. The `cancelled` flag is set once and never
+ * cleared, and may be read without acquiring the token lock. */
+typedef struct _CancelToken {
+   Mutex lock;
+   Condition cond;            /* signalled on cancel or callback return */
+   CancelCallback *head;      /* registered callbacks, in order */
+   CancelCallback *running;   /* callback currently executing */
+   volatile int cancelled;
+} CancelToken;
+
+/* Check the cancellation state of a token. (NON-BLOCKING)
+ * Returns non-zero if cancellation has been requested. */
+#define cancel_requested(token)  ( (token)->cancelled )
+
+/* Initialize a cancellation token.
+ * Returns 0 on success, else error code. */
+static inline int cancel_init(CancelToken *token)
+{
+   token->head = token->running = NULL;
+   token->cancelled = 0;
+   mutex_init(&token->lock);
+
+   return condition_init(&token->cond);
+}
+
+/* Uninitialize a cancellation token. Pending callbacks are discarded.
+ * Returns 0 on success, else error code. */
+static inline int cancel_free(CancelToken *token)
+{
+   token->head = NULL;
+   condition_free(&token->cond);
+
+   return mutex_free(&token->lock);
+}
+
+/* Request cancellation of a token, waking all threads waiting on the
+ * token and executing registered callbacks. Subsequent requests have
+ * no further effect. Always returns 0. */
+static inline int cancel_request(CancelToken *token)
+{
+   CancelCallback *cb;
+
+   mutex_lock(&token->lock);
+   if(token->cancelled) {
+      mutex_unlock(&token->lock);
+      return 0;
+   }
+   token->cancelled = 1;
+   condition_broadcast(&token->cond);
+   /* execute callbacks, without lock, allowing callbacks to block */
+   while((cb = token->head)) {
+      token->head = cb->next;
+      token->running = cb;
+      mutex_unlock(&token->lock);
+      cb->func(cb->arg);
+      mutex_lock(&token->lock);
+      token->running = NULL;
+      condition_broadcast(&token->cond);
+   }
+   mutex_unlock(&token->lock);
+
+   return 0;
+}
+
+/* Register a callback, executed on cancellation request of a token.
+ * Returns 0 on success, else ECANCELED if cancellation has already
+ * been requested, in which case the callback is NOT executed. */
+static inline int cancel_register(CancelToken *token, CancelCallback *cb,
+   CancelFunc *func, void *arg)
+{
+   CancelCallback **next;
+
+   cb->func = func;
+   cb->arg = arg;
+   cb->next = NULL;
+
+   mutex_lock(&token->lock);
+   if(token->cancelled) {
+      mutex_unlock(&token->lock);
+      return ECANCELED;
+   }
+   /* append callback, preserving order of registration */
+   for(next = &token->head; *next; next = &(*next)->next);
+   *next = cb;
+   mutex_unlock(&token->lock);
+
+   return 0;
+}
+
+/* Unregister a callback from a token. If the callback is currently
+ * executing, waits for it to complete. (BLOCKING)
+ * On return, the callback may be safely released. Always returns 0. */
+static inline int cancel_unregister(CancelToken *token, CancelCallback *cb)
+{
+   CancelCallback **next;
+
+   mutex_lock(&token->lock);
+   for(next = &token->head; *next; next = &(*next)->next) {
+      if(*next == cb) {
+         *next = cb->next;
+         break;
+      }
+   }
+   while(token->running == cb)
+      condition_wait(&token->cond, &token->lock);
+   mutex_unlock(&token->lock);
+
+   return 0;
+}
+
+/* Suspend the current thread for specified milliseconds, or until
+ * cancellation of a token is requested. (BLOCKING)
+ * Returns 0 on completion, else ECANCELED if cancelled. */
+static inline int cancel_sleep(CancelToken *token, unsigned long ms)
+{
+   long remaining, deadline;
+
+   deadline = milliseconds() + (long) ms;
+
+   mutex_lock(&token->lock);
+   while(!token->cancelled) {
+      remaining = deadline - milliseconds();
+      if(remaining <= 0) break;
+      condition_timedwait(&token->cond, &token->lock, remaining);
+   }
+   mutex_unlock(&token->lock);
+
+   return token->cancelled ? ECANCELED : 0;
+}
+
+/* Condition and Mutex pair woken by cancel_condwake(). */
+typedef struct _CANCEL_WAKE {
+   Condition *cond;
+   Mutex *mutex;
+} CANCEL_WAKE;
+
+/* Cancellation callback waking threads waiting in cancel_condwait().
+ * Acquiring the Mutex ensures a waiter cannot miss the wake up. */
+static inline void cancel_condwake(void *arg)
+{
+   CANCEL_WAKE *wake = (CANCEL_WAKE *) arg;
+
+   mutex_lock(wake->mutex);
+   condition_broadcast(wake->cond);
+   mutex_unlock(wake->mutex);
+}
+
+/* Wait on a Condition variable for at most `ms` milliseconds, or until
+ * cancellation of a token is requested. The Mutex SHALL be locked by
+ * the calling thread, and is locked again on return. As the Mutex may
+ * be released briefly on return, waiters SHALL recheck their predicate.
+ * (BLOCKING) Returns 0 on success, ETIMEDOUT on timeout, ECANCELED if
+ * cancelled, else error code. */
+static inline int cancel_condwait(CancelToken *token, Condition *cond,
+   Mutex *mutex, unsigned long ms)
+{
+   CancelCallback cb;
+   CANCEL_WAKE wake;
+   int ecode;
+
+   wake.cond = cond;
+   wake.mutex = mutex;
+   if(cancel_register(token, &cb, cancel_condwake, &wake))
+      return ECANCELED;
+   /* the Mutex is held from registration until waiting, hence a wake
+    * up from a concurrent cancellation request cannot be missed */
+   ecode = condition_timedwait(cond, mutex, ms);
+   /* the callback acquires the Mutex, so it cannot be held while
+    * waiting for a running callback to complete */
+   mutex_unlock(mutex);
+   cancel_unregister(token, &cb);
+   mutex_lock(mutex);
+
+   return token->cancelled ? ECANCELED : ecode;
+}
+
+/* Shared attributes of the threads of a ThreadGroup. */
+typedef struct _ThreadAttr {
+   size_t stacksize;    /* bytes, 0 for the default */
+   int pin;             /* non-zero pins thread i to processor i % cpus */
+} ThreadAttr;
+
+/* A member thread of a ThreadGroup. */
+typedef struct _GROUP_MEMBER {
+   struct _ThreadGroup *group;
+   void *arg;
+   int index;
+   int created;
+} GROUP_MEMBER;
+
+/* A group of identical threads, joined and cancelled as a whole.
+ * Spawning state is guarded by `lock`. */
+typedef struct _ThreadGroup {
+   Mutex lock;
+   Condition spawned;   /* signalled when no spawns remain pending */
+   CancelToken cancel;
+   ThreadFunc *func;
+   ThreadAttr attr;
+   ThreadID *tids;
+   GROUP_MEMBER *members;
+   int threads;
+   int pending;         /* threads not yet spawned (or failed) */
+   int cpus;
+   int error;           /* first spawn or pinning error */
+} ThreadGroup;
+
+#ifdef _WIN32
+
+/* Obtain the CancelToken held by the thread local storage index (+ 1)
+ * at `key`, 0 where not yet allocated.
+ * Returns pointer to token, else NULL if none. */
+static inline CancelToken *cancel_tlsget(volatile LONG *key)
+{
+   LONG idx = *key;
+
+   return idx ? (CancelToken *) TlsGetValue((DWORD) (idx - 1)) : NULL;
+}
+
+/* Hold a CancelToken in the thread local storage index (+ 1) at `key`,
+ * allocating the index on first use. */
+static inline void cancel_tlsset(volatile LONG *key, CancelToken *token)
+{
+   DWORD idx;
+
+   if(*key == 0) {
+      idx = TlsAlloc();
+      if(idx == TLS_OUT_OF_INDEXES) return;
+      /* another translation unit (or thread) may allocate first */
+      if(InterlockedCompareExchange(key, (LONG) idx + 1, 0) != 0)
+         TlsFree(idx);
+   }
+   TlsSetValue((DWORD) (*key - 1), token);
+}
+
+#endif
+
+/* CancelToken of the group of the current thread, if any. Process-wide
+ * (ThreadShared), such that group functions of every translation unit
+ * observe the token; thread local storage cannot be merged across
+ * translation units on Windows, where a TLS index is held instead. */
+#ifdef __cplusplus
+extern "C" {
+#endif
+#ifdef _WIN32
+ThreadShared volatile LONG Group_token_mpcancel = 0;
+#else
+ThreadShared ThreadLocal CancelToken *Group_token_mpcancel = NULL;
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+/* Obtain the CancelToken of the ThreadGroup of the current thread.
+ * Returns pointer to token, else NULL if not a group thread. */
+#ifdef _WIN32
+#define group_token()  cancel_tlsget(&Group_token_mpcancel)
+#else
+#define group_token()  ( Group_token_mpcancel )
+#endif
+
+/* Record an error against a group, requesting cancellation of the group
+ * on the first error. */
+static inline void group_error(ThreadGroup *group, int ecode)
+{
+   int first;
+
+   mutex_lock(&group->lock);
+   first = group->error == 0;
+   if(first) group->error = ecode;
+   mutex_unlock(&group->lock);
+   if(first) cancel_request(&group->cancel);
+}
+
+static inline Threaded group_thread(void *arg);
+
+/* Count the members of the spawn subtree rooted at member `idx`, of a
+ * group of `threads` members. */
+static inline int group_subtree(int idx, int threads)
+{
+   int lo, hi, count;
+
+   for(count = 0, lo = hi = idx; lo < threads; lo = 2 * lo + 1, hi = 2 * hi + 2)
+      count += (hi < threads ? hi : threads - 1) - lo + 1;
+
+   return count;
+}
+
+/* Spawn the member thread `idx` of a group, and account for the spawn.
+ * Failed spawns, and spawns after an error of the group (which are not
+ * attempted), also account for the subtree of the member. */
+static inline void group_spawn(ThreadGroup *group, int idx)
+{
+   GROUP_MEMBER *member = &group->members[idx];
+   int ecode, first;
+
+   mutex_lock(&group->lock);
+   ecode = group->error;
+   mutex_unlock(&group->lock);
+   if(ecode == 0) {
+      ecode = thread_create_stack(&group->tids[idx], group_thread, member,
+         group->attr.stacksize);
+   }
+   /* count the member, else its entire (never spawned) subtree */
+   mutex_lock(&group->lock);
+   if(ecode == 0) {
+      member->created = 1;
+      group->pending--;
+   } else group->pending -= group_subtree(idx, group->threads);
+   if(group->pending == 0) condition_broadcast(&group->spawned);
+   first = ecode && group->error == 0;
+   if(first) group->error = ecode;
+   mutex_unlock(&group->lock);
+   if(first) cancel_request(&group->cancel);
+}
+
+/* Thread function of a group member; spawns the children of the member,
+ * pins the thread if required, then executes the group function. */
+static inline Threaded group_thread(void *arg)
+{
+   GROUP_MEMBER *member = (GROUP_MEMBER *) arg;
+   ThreadGroup *group = member->group;
+   int child, ecode;
+
+   for(child = 2 * member->index + 1; child <= 2 * member->index + 2 &&
+      child < group->threads; child++) group_spawn(group, child);
+
+   if(group->attr.pin) {
+      ecode = thread_setaffinity(member->index % group->cpus);
+      if(ecode) group_error(group, ecode);
+   }
+#ifdef _WIN32
+   cancel_tlsset(&Group_token_mpcancel, &group->cancel);
+#else
+   Group_token_mpcancel = &group->cancel;
+#endif
+
+   return group->func(member->arg);
+}
+
+/* Spawn `threads` threads of a ThreadGroup, executing `func`, each with
+ * shared attributes `attr` (NULL for defaults). Thread i is passed the
+ * argument `(char *) args + (i * argsize)`; an `argsize` of zero passes
+ * `args` to every thread. Returns once every thread has been spawned.
+ * Returns 0 on success, else the first error code; threads spawned
+ * before an error are cancelled, and the group SHALL still be joined. */
+static inline int thread_create_many(ThreadGroup *group, int threads,
+   ThreadFunc *func, void *args, size_t argsize, const ThreadAttr *attr)
+{
+   int i, ecode;
+
+   memset(group, 0, sizeof(*group));
+   if(threads < 1) return EINVAL;
+   group->tids = (ThreadID *) calloc((size_t) threads, sizeof(ThreadID));
+   group->members = (GROUP_MEMBER *)
+      calloc((size_t) threads, sizeof(GROUP_MEMBER));
+   if(group->tids == NULL || group->members == NULL) {
+      free(group->tids);
+      free(group->members);
+      group->tids = NULL;
+      group->members = NULL;
+      return ENOMEM;
+   }
+   mutex_init(&group->lock);
+   condition_init(&group->spawned);
+   cancel_init(&group->cancel);
+   group->func = func;
+   if(attr) group->attr = *attr;
+   group->threads = group->pending = threads;
+   group->cpus = thread_cpucount();
+   for(i = 0; i < threads; i++) {
+      group->members[i].group = group;
+      group->members[i].index = i;
+      group->members[i].arg = (char *) args + (size_t) i * argsize;
+   }
+
+   /* spawn the root, then wait for the spawn tree */
+   group_spawn(group, 0);
+   mutex_lock(&group->lock);
+   while(group->pending > 0)
+      condition_wait(&group->spawned, &group->lock);
+   ecode = group->error;
+   mutex_unlock(&group->lock);
+
+   return ecode;
+}
+
+/* Request cancellation of every thread of a ThreadGroup.
+ * Always returns 0. */
+#define group_cancel(group)  cancel_request(&(group)->cancel)
+
+/* Wait for every thread of a ThreadGroup to complete, and free the
+ * group. (BLOCKING) Returns 0 on success, else the first spawn, pinning
+ * or join error code. */
+static inline int group_join(ThreadGroup *group)
+{
+   int i, ecode, temp;
+
+   if(group->tids == NULL) return EINVAL;
+   for(i = 0; i < group->threads; i++) {
+      if(!group->members[i].created) continue;
+      temp = thread_wait(&group->tids[i]);
+      if(temp) group_error(group, temp);
+   }
+   ecode = group->error;
+   cancel_free(&group->cancel);
+   condition_free(&group->spawned);
+   mutex_free(&group->lock);
+   free(group->tids);
+   free(group->members);
+   group->tids = NULL;
+   group->members = NULL;
+
+   return ecode;
+}
+
+
+#endif /* end _MP_CANCEL_H_ */
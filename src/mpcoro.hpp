@@ -0,0 +1,699 @@
+/* ****************************************************************
+ * Coroutine support for C++20; tasks, an executor over the ThreadPool
+ * of mppool.h, and timer, channel and mutex awaitables.
+ *  - mpcoro.hpp (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a small coroutine runtime, resuming coroutines as
+ * tasks of a ThreadPool, such that asynchronous request handlers may be
+ * written as sequential code:
+ *   mp::Task<int> handler(mp::Executor &ex, mp::Channel<Request> &ch)
+ *   {
+ *      std::optional<Request> req = co_await ch.recv();
+ *      co_await ex.sleep_for(std::chrono::milliseconds(5));
+ *      co_return respond(*req);
+ *   }
+ *
+ * A Task<T> is a lazily started coroutine, returning T. Awaiting a task
+ * starts it, and resumes the awaiting coroutine on completion, by
+ * symmetric transfer (no thread handoff, nor pool submission). Results
+ * and exceptions propagate to the awaiting coroutine.
+ *
+ * An Executor resumes coroutines on the worker threads of a ThreadPool.
+ * Awaiting schedule() moves a coroutine onto the pool. Awaiting
+ * sleep_until() or sleep_for() suspends a coroutine until a deadline,
+ * as a MonotonicClock (nanoseconds()) time point; deadlines are held by
+ * a timer thread of the executor, which submits expired coroutines to
+ * the pool. Tasks are started on the pool with spawn() (detached), with
+ * when_all() (concurrently, awaiting all), or with sync_wait() (blocking
+ * until complete, from outside the pool).
+ *
+ * A Channel<T> is a bounded FIFO queue between coroutines. Awaiting
+ * send() suspends while the channel is full, and awaiting recv()
+ * suspends while the channel is empty. An AsyncMutex is a mutually
+ * exclusive lock suspending, rather than blocking, awaiting coroutines.
+ * Suspended coroutines are resumed on the pool of the executor.
+ *
+ * NOTES:
+ * - An Executor SHALL outlive every coroutine it resumes, and the pool
+ *   of an Executor SHALL outlive the Executor.
+ * - Timers expire with the millisecond precision of
+ *   condition_timedwait(), plus pool queue wait.
+ * - Exceptions escaping a detached (spawned) task call std::terminate().
+ * - Symmetric transfer between tasks relies on tail calls; builds
+ *   without them (e.g. -fsanitize=address) consume stack for every
+ *   task completing synchronously within a single resumption.
+ * - Where pool submission fails (e.g. during pool shutdown), coroutines
+ *   are resumed on the calling thread.
+ * - Requires C++20 coroutine support.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial Task, Executor, Channel and AsyncMutex implementation.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_CORO_HPP_
+#define _MP_CORO_HPP_  /* include guard */
+
+
+#ifndef __cpp_impl_coroutine
+#error "mpcoro.hpp requires C++20 coroutine support"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "mppool.h"
+#include "mptime.hpp"
+
+namespace mp {
+
+template<class T = void> class Task;
+
+/* Promise state common to every Task; the awaiting coroutine, resumed
+ * on completion by symmetric transfer, and any escaped exception. */
+struct TaskPromiseBase {
+   std::coroutine_handle<> continuation;
+   std::exception_ptr error;
+
+   struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      template<class P>
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h)
+         noexcept
+      {
+         std::coroutine_handle<> c = h.promise().continuation;
+         return c ? c : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+   };
+
+   std::suspend_always initial_suspend() noexcept { return {}; }
+   FinalAwaiter final_suspend() noexcept { return {}; }
+   void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+/* Promise of a Task returning T. */
+template<class T>
+struct TaskPromise : TaskPromiseBase {
+   std::optional<T> value;
+
+   Task<T> get_return_object() noexcept;
+   template<class U>
+   void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+   T result()
+   {
+      if(error) std::rethrow_exception(error);
+      return std::move(*value);
+   }
+};
+
+/* Promise of a Task returning void. */
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+   Task<void> get_return_object() noexcept;
+   void return_void() noexcept {}
+   void result() { if(error) std::rethrow_exception(error); }
+};
+
+/* A lazily started coroutine returning T. Owns its coroutine frame. */
+template<class T>
+class Task {
+public:
+   typedef TaskPromise<T> promise_type;
+   typedef std::coroutine_handle<promise_type> handle_type;
+
+   Task() noexcept : h_() {}
+   explicit Task(handle_type h) noexcept : h_(h) {}
+   Task(Task &&t) noexcept : h_(std::exchange(t.h_, {})) {}
+   Task &operator=(Task &&t) noexcept
+   {
+      if(this != &t) {
+         if(h_) h_.destroy();
+         h_ = std::exchange(t.h_, {});
+      }
+      return *this;
+   }
+   Task(const Task &) = delete;
+   Task &operator=(const Task &) = delete;
+   ~Task() { if(h_) h_.destroy(); }
+
+   /* Awaiting a task starts it, resuming the awaiting coroutine with its
+    * result (or exception) on completion. */
+   bool await_ready() const noexcept { return h_.done(); }
+   std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller)
+      noexcept
+   {
+      h_.promise().continuation = caller;
+      return h_;
+   }
+   T await_resume() { return h_.promise().result(); }
+
+   /* Awaitable of task completion, without obtaining its result. */
+   struct Join {
+      handle_type h;
+      bool await_ready() const noexcept { return h.done(); }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller)
+         noexcept
+      {
+         h.promise().continuation = caller;
+         return h;
+      }
+      void await_resume() noexcept {}
+   };
+   Join join() const noexcept { return Join{ h_ }; }
+
+   /* Obtain the result of a completed task, rethrowing its exception. */
+   T get() { return h_.promise().result(); }
+
+   bool valid() const noexcept { return (bool) h_; }
+
+private:
+   handle_type h_;
+};
+
+template<class T>
+inline Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+   return Task<T>(Task<T>::handle_type::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+   return Task<void>(Task<void>::handle_type::from_promise(*this));
+}
+
+/* An eagerly started coroutine, destroying its own frame on completion.
+ * Used to start tasks from outside of a coroutine. */
+struct Detached {
+   struct promise_type {
+      Detached get_return_object() noexcept { return {}; }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept { std::terminate(); }
+   };
+};
+
+/* An executor resuming coroutines on the worker threads of a pool. */
+class Executor {
+public:
+   /* Create an executor over a pool, starting its timer thread.
+    * Throws std::system_error if the timer thread cannot be created. */
+   explicit Executor(ThreadPool *pool) : pool_(pool), shutdown_(0)
+   {
+      int ecode;
+
+      mutex_init(&lock_);
+      condition_init(&wake_);
+      ecode = thread_create(&tid_, timer_thread, this);
+      if(ecode) {
+         condition_free(&wake_);
+         mutex_free(&lock_);
+         throw std::system_error(ecode, std::generic_category(),
+            "timer thread");
+      }
+   }
+
+   /* Stop the timer thread. Pending timers SHALL NOT remain. */
+   ~Executor()
+   {
+      mutex_lock(&lock_);
+      shutdown_ = 1;
+      condition_signal(&wake_);
+      mutex_unlock(&lock_);
+      thread_wait(&tid_);
+      condition_free(&wake_);
+      mutex_free(&lock_);
+   }
+
+   Executor(const Executor &) = delete;
+   Executor &operator=(const Executor &) = delete;
+
+   ThreadPool *pool() const noexcept { return pool_; }
+
+   /* Resume a suspended coroutine on the pool, or on the calling thread
+    * if the pool does not accept tasks. */
+   void post(std::coroutine_handle<> h) noexcept
+   {
+      if(pool_submit(pool_, resume, h.address())) h.resume();
+   }
+
+   /* Awaitable moving the awaiting coroutine onto the pool. */
+   struct Schedule {
+      Executor *ex;
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> h) const noexcept
+      {
+         /* continue on the calling thread if the pool is unavailable */
+         return pool_submit(ex->pool_, resume, h.address()) == 0;
+      }
+      void await_resume() const noexcept {}
+   };
+   Schedule schedule() noexcept { return Schedule{ this }; }
+
+   /* Awaitable suspending the awaiting coroutine until a deadline. */
+   struct Sleep {
+      Executor *ex;
+      long long deadline;   /* nanoseconds() time stamp */
+      bool await_ready() const noexcept
+      {
+         return nanoseconds() >= deadline;
+      }
+      void await_suspend(std::coroutine_handle<> h) const
+      {
+         ex->add_timer(deadline, h);
+      }
+      void await_resume() const noexcept {}
+   };
+   Sleep sleep_until(MonotonicClock::time_point t) noexcept
+   {
+      return Sleep{ this, t.time_since_epoch().count() };
+   }
+   template<class Rep, class Period>
+   Sleep sleep_for(std::chrono::duration<Rep, Period> d) noexcept
+   {
+      return Sleep{ this, nanoseconds() + to_nanoseconds(d) };
+   }
+
+   /* Start a task on the pool, detached. */
+   void spawn(Task<void> t) { detach(*this, std::move(t)); }
+
+private:
+   /* A pending timer; the deadline and coroutine to resume. */
+   struct Timer {
+      long long deadline;
+      std::coroutine_handle<> h;
+      bool operator>(const Timer &t) const { return deadline > t.deadline; }
+   };
+
+   /* Pool task function resuming a coroutine. */
+   static int resume(void *arg)
+   {
+      std::coroutine_handle<>::from_address(arg).resume();
+      return 0;
+   }
+
+   static Detached detach(Executor &ex, Task<void> t)
+   {
+      co_await ex.schedule();
+      co_await t;
+   }
+
+   /* Add a timer, waking the timer thread if it is the earliest. */
+   void add_timer(long long deadline, std::coroutine_handle<> h)
+   {
+      mutex_lock(&lock_);
+      timers_.push_back(Timer{ deadline, h });
+      std::push_heap(timers_.begin(), timers_.end(), std::greater<Timer>());
+      if(timers_.front().h == h) condition_signal(&wake_);
+      mutex_unlock(&lock_);
+   }
+
+   /* Timer thread function, posting coroutines of expired timers. */
+   static Threaded timer_thread(void *arg)
+   {
+      Executor *ex = (Executor *) arg;
+      std::coroutine_handle<> h;
+      long long now, deadline;
+
+      mutex_lock(&ex->lock_);
+      while(!ex->shutdown_) {
+         if(ex->timers_.empty()) {
+            condition_wait(&ex->wake_, &ex->lock_);
+            continue;
+         }
+         now = nanoseconds();
+         deadline = ex->timers_.front().deadline;
+         if(deadline > now) {
+            /* round up, never waking early */
+            condition_timedwait(&ex->wake_, &ex->lock_,
+               (unsigned long) ((deadline - now + 999999) / 1000000));
+            continue;
+         }
+         h = ex->timers_.front().h;
+         std::pop_heap(ex->timers_.begin(), ex->timers_.end(),
+            std::greater<Timer>());
+         ex->timers_.pop_back();
+         mutex_unlock(&ex->lock_);
+         ex->post(h);
+         mutex_lock(&ex->lock_);
+      }
+      mutex_unlock(&ex->lock_);
+
+      return Treturn;
+   }
+
+   ThreadPool *pool_;
+   Mutex lock_;            /* guards timers_ and shutdown_ */
+   Condition wake_;        /* signalled on earlier timer, or shutdown */
+   ThreadID tid_;
+   std::vector<Timer> timers_;   /* min-heap, by deadline */
+   int shutdown_;
+};
+
+/* Completion state of sync_wait(). */
+struct SyncState {
+   Mutex lock;
+   Condition done;
+   int finished;
+};
+
+template<class T>
+Detached sync_run(Executor &ex, Task<T> &t, SyncState *s)
+{
+   co_await ex.schedule();
+   co_await t.join();
+   mutex_lock(&s->lock);
+   s->finished = 1;
+   condition_signal(&s->done);
+   mutex_unlock(&s->lock);
+}
+
+/* Start a task on the pool, blocking until it completes. SHALL NOT be
+ * called from a worker thread of the pool. (BLOCKING)
+ * Returns the result of the task, or rethrows its exception. */
+template<class T>
+T sync_wait(Executor &ex, Task<T> t)
+{
+   SyncState s;
+
+   s.finished = 0;
+   mutex_init(&s.lock);
+   condition_init(&s.done);
+   sync_run(ex, t, &s);
+   mutex_lock(&s.lock);
+   while(!s.finished) condition_wait(&s.done, &s.lock);
+   mutex_unlock(&s.lock);
+   condition_free(&s.done);
+   mutex_free(&s.lock);
+
+   return t.get();
+}
+
+/* Awaitable starting tasks concurrently on the pool, resuming the
+ * awaiting coroutine (on the pool) once every task has completed.
+ * Results are obtained from each task, with get(). */
+template<class T>
+class WhenAll {
+public:
+   WhenAll(Executor &ex, Task<T> *tasks, size_t n) noexcept
+      : ex_(ex), tasks_(tasks), n_(n), pending_(n) {}
+
+   bool await_ready() const noexcept { return n_ == 0; }
+   void await_suspend(std::coroutine_handle<> caller)
+   {
+      Task<T> *tasks = tasks_;
+      size_t i, n = n_;
+
+      /* the awaiter SHALL NOT be accessed once the last task starts */
+      caller_ = caller;
+      for(i = 0; i < n; i++) run(ex_, tasks[i], this);
+   }
+   void await_resume() const noexcept {}
+
+private:
+   static Detached run(Executor &ex, Task<T> &t, WhenAll *all)
+   {
+      co_await ex.schedule();
+      co_await t.join();
+      if(--all->pending_ == 0) ex.post(all->caller_);
+   }
+
+   Executor &ex_;
+   Task<T> *tasks_;
+   size_t n_;
+   std::atomic<size_t> pending_;
+   std::coroutine_handle<> caller_;
+};
+
+/* Start `n` tasks concurrently on the pool, awaiting completion of all. */
+template<class T>
+WhenAll<T> when_all(Executor &ex, Task<T> *tasks, size_t n) noexcept
+{
+   return WhenAll<T>(ex, tasks, n);
+}
+
+/* A bounded FIFO channel of T, between coroutines. */
+template<class T>
+class Channel {
+public:
+   struct Send;
+   struct Recv;
+
+   /* Create a channel of `capacity` (at least 1) buffered values. */
+   Channel(Executor &ex, size_t capacity)
+      : ex_(ex), cap_(capacity ? capacity : 1), senders_(NULL),
+      sendlast_(NULL), receivers_(NULL), recvlast_(NULL), closed_(0)
+   {
+      mutex_init(&lock_);
+   }
+   ~Channel() { mutex_free(&lock_); }
+   Channel(const Channel &) = delete;
+   Channel &operator=(const Channel &) = delete;
+
+   /* Awaitable sending a value, suspending while the channel is full.
+    * Resumes with true if sent, else false if the channel is closed. */
+   struct Send {
+      Channel *ch;
+      T value;
+      bool ok;
+      std::coroutine_handle<> h;
+      Send *next;
+
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> caller)
+      {
+         Channel *c = ch;
+         Recv *r;
+
+         mutex_lock(&c->lock_);
+         ok = !c->closed_;
+         if(ok && (r = c->receivers_)) {
+            /* hand the value to the longest waiting receiver */
+            if((c->receivers_ = r->next) == NULL) c->recvlast_ = NULL;
+            r->value.emplace(std::move(value));
+            mutex_unlock(&c->lock_);
+            c->ex_.post(r->h);
+            return false;
+         }
+         if(!ok || c->buffer_.size() < c->cap_) {
+            if(ok) c->buffer_.push_back(std::move(value));
+            mutex_unlock(&c->lock_);
+            return false;
+         }
+         h = caller;
+         next = NULL;
+         if(c->sendlast_) c->sendlast_->next = this;
+         else c->senders_ = this;
+         c->sendlast_ = this;
+         mutex_unlock(&c->lock_);
+         return true;
+      }
+      bool await_resume() const noexcept { return ok; }
+   };
+
+   /* Awaitable receiving a value, suspending while the channel is empty.
+    * Resumes with the value, else std::nullopt if the channel is closed
+    * and empty. */
+   struct Recv {
+      Channel *ch;
+      std::optional<T> value;
+      std::coroutine_handle<> h;
+      Recv *next;
+
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> caller)
+      {
+         Channel *c = ch;
+         std::coroutine_handle<> sh;
+         Send *s;
+
+         mutex_lock(&c->lock_);
+         if(!c->buffer_.empty()) {
+            value.emplace(std::move(c->buffer_.front()));
+            c->buffer_.pop_front();
+            /* refill from the longest waiting sender */
+            if((s = c->senders_)) {
+               if((c->senders_ = s->next) == NULL) c->sendlast_ = NULL;
+               c->buffer_.push_back(std::move(s->value));
+               sh = s->h;
+            }
+            mutex_unlock(&c->lock_);
+            if(sh) c->ex_.post(sh);
+            return false;
+         }
+         if(c->closed_) {
+            mutex_unlock(&c->lock_);
+            return false;
+         }
+         h = caller;
+         next = NULL;
+         if(c->recvlast_) c->recvlast_->next = this;
+         else c->receivers_ = this;
+         c->recvlast_ = this;
+         mutex_unlock(&c->lock_);
+         return true;
+      }
+      std::optional<T> await_resume() { return std::move(value); }
+   };
+
+   Send send(T value)
+   {
+      return Send{ this, std::move(value), false, {}, NULL };
+   }
+   Recv recv() noexcept { return Recv{ this, std::nullopt, {}, NULL }; }
+
+   /* Close a channel, resuming every suspended sender (unsent) and
+    * receiver (without a value). Buffered values remain receivable. */
+   void close()
+   {
+      Send *s;
+      Recv *r;
+
+      mutex_lock(&lock_);
+      closed_ = 1;
+      s = senders_;
+      r = receivers_;
+      senders_ = sendlast_ = NULL;
+      receivers_ = recvlast_ = NULL;
+      for(Send *p = s; p; p = p->next) p->ok = false;
+      mutex_unlock(&lock_);
+      /* read next before posting; a resumed awaiter is destroyed */
+      for(Send *p; (p = s); ) { s = s->next; ex_.post(p->h); }
+      for(Recv *p; (p = r); ) { r = r->next; ex_.post(p->h); }
+   }
+
+private:
+   Executor &ex_;
+   Mutex lock_;
+   std::deque<T> buffer_;
+   size_t cap_;
+   Send *senders_, *sendlast_;      /* suspended senders, FIFO */
+   Recv *receivers_, *recvlast_;    /* suspended receivers, FIFO */
+   int closed_;
+};
+
+/* A mutually exclusive lock of coroutines, suspending (rather than
+ * blocking) while the lock is held. Ownership passes directly to the
+ * longest waiting coroutine on unlock(). */
+class AsyncMutex {
+public:
+   explicit AsyncMutex(Executor &ex) : ex_(ex), locked_(0), waiters_(NULL)
+   {
+      mutex_init(&lock_);
+   }
+   ~AsyncMutex() { mutex_free(&lock_); }
+   AsyncMutex(const AsyncMutex &) = delete;
+   AsyncMutex &operator=(const AsyncMutex &) = delete;
+
+   /* Awaitable acquiring the lock. */
+   struct Lock {
+      AsyncMutex *m;
+      std::coroutine_handle<> h;
+      Lock *next;
+
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> caller)
+      {
+         AsyncMutex *am = m;
+         Lock **p;
+
+         mutex_lock(&am->lock_);
+         if(!am->locked_) {
+            am->locked_ = 1;
+            mutex_unlock(&am->lock_);
+            return false;
+         }
+         h = caller;
+         next = NULL;
+         for(p = &am->waiters_; *p; p = &(*p)->next);
+         *p = this;
+         mutex_unlock(&am->lock_);
+         return true;
+      }
+      void await_resume() const noexcept {}
+   };
+   Lock lock() noexcept { return Lock{ this, {}, NULL }; }
+
+   /* Acquire the lock, if not held. (NON-BLOCKING)
+    * Returns true if acquired, else false. */
+   bool try_lock()
+   {
+      bool ok;
+
+      mutex_lock(&lock_);
+      ok = !locked_;
+      locked_ = 1;
+      mutex_unlock(&lock_);
+
+      return ok;
+   }
+
+   /* Release the lock, passing ownership to the longest waiting
+    * coroutine, if any, resumed on the pool. */
+   void unlock()
+   {
+      Lock *w;
+
+      mutex_lock(&lock_);
+      w = waiters_;
+      if(w) waiters_ = w->next;
+      else locked_ = 0;
+      mutex_unlock(&lock_);
+      if(w) ex_.post(w->h);
+   }
+
+   /* A guard releasing an acquired AsyncMutex on destruction. */
+   class Guard {
+   public:
+      explicit Guard(AsyncMutex *m) noexcept : m_(m) {}
+      Guard(Guard &&g) noexcept : m_(g.m_) { g.m_ = NULL; }
+      Guard(const Guard &) = delete;
+      Guard &operator=(const Guard &) = delete;
+      ~Guard() { if(m_) m_->unlock(); }
+   private:
+      AsyncMutex *m_;
+   };
+
+   /* Awaitable acquiring the lock, resuming with a Guard. */
+   struct ScopedLock : Lock {
+      Guard await_resume() const noexcept { return Guard(this->m); }
+   };
+   ScopedLock scoped_lock() noexcept
+   {
+      return ScopedLock{ { this, {}, NULL } };
+   }
+
+private:
+   Executor &ex_;
+   Mutex lock_;
+   int locked_;
+   Lock *waiters_;      /* suspended lockers, FIFO */
+};
+
+}  /* end namespace mp */
+
+
+#endif /* end _MP_CORO_HPP_ */
@@ -0,0 +1,443 @@
+/* ****************************************************************
+ * Event loop support, with timers and cross-thread task posting.
+ *  - mpevent.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides an event loop, intended to be driven by a single
+ * thread (typically one loop and thread per core), which waits for:
+ * - readiness of watched file descriptors (sockets, pipes, etc.),
+ * - expiry of timers, held in a binary min-heap keyed on the monotonic
+ *   millisecond clock of mptime.h,
+ * - tasks posted from other threads, delivered via an eventfd.
+ * The loop sleeps in the kernel until the earliest of the above, and
+ * never polls or sleeps for a fixed interval.
+ *
+ * The implementation is based on the Linux epoll and eventfd APIs, and
+ * is unavailable on other platforms.
+ *
+ * NOTES:
+ * - Support functions requiring an EventLoop, EventWatch or EventTimer
+ *   param, SHALL be passed as pointers.
+ * - EventWatch and EventTimer are caller allocated, and SHALL remain
+ *   valid while added to a loop. Only event_post() and event_stop()
+ *   may be called from threads other than the thread running the loop.
+ * - A watch removed by a callback SHALL remain valid until the current
+ *   loop iteration completes, as events may already be pending for it.
+ * - Posting a task to an idle loop writes the eventfd once; posts to a
+ *   loop with tasks already pending are coalesced into that wake up.
+ *   Where event_post() fails, the task is not posted, such that it may
+ *   be posted again.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial EventLoop implementation.
+ * Rev.2   2026-10-18
+ *   Failure to wake a loop no longer leaves the task posted, which was
+ *   posted twice when retried, and stalled later posts.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_EVENT_H_
+#define _MP_EVENT_H_  /* include guard */
+
+
+#ifndef __linux__
+#error "mpevent.h requires the Linux epoll and eventfd APIs"
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "mpthread.h"
+#include "mptime.h"
+
+/* Maximum events retrieved per loop iteration */
+#ifndef EVENT_BATCH
+#define EVENT_BATCH  64
+#endif
+
+/* Event flags, for watches and callbacks */
+#define EVENT_IN   EPOLLIN    /* readable */
+#define EVENT_OUT  EPOLLOUT   /* writable */
+#define EVENT_ERR  EPOLLERR   /* error condition (always reported) */
+#define EVENT_HUP  EPOLLHUP   /* hang up (always reported) */
+#define EVENT_ET   EPOLLET    /* edge triggered, watch flag only */
+
+struct _EventLoop;
+struct _EventWatch;
+struct _EventTimer;
+
+/* Event callback function datatypes */
+typedef void (EventFunc)(struct _EventLoop *loop, struct _EventWatch *watch,
+   unsigned events);
+typedef void (TimerFunc)(struct _EventLoop *loop, struct _EventTimer *timer);
+typedef void (PostFunc)(void *arg);
+
+/* A watched file descriptor. */
+typedef struct _EventWatch {
+   int fd;
+   EventFunc *func;
+   void *arg;
+} EventWatch;
+
+/* A one-shot timer, expiring at a milliseconds() time stamp. */
+typedef struct _EventTimer {
+   long deadline;
+   int index;           /* position in timer heap, -1 if inactive */
+   TimerFunc *func;
+   void *arg;
+} EventTimer;
+
+/* A posted task, held in a loop's singly linked FIFO list. */
+typedef struct _EVENT_POST {
+   PostFunc *func;
+   void *arg;
+   struct _EVENT_POST *next;
+} EVENT_POST;
+
+/* An event loop. Posted task state is guarded by `lock`, all other
+ * state belongs to the thread running the loop. */
+typedef struct _EventLoop {
+   int epfd;            /* epoll instance */
+   int evfd;            /* eventfd, for cross-thread wake up */
+   Mutex lock;
+   EVENT_POST *head;    /* posted tasks, pending */
+   EVENT_POST *tail;
+   EVENT_POST *spare;   /* recycled post nodes */
+   EventTimer **heap;   /* active timers, by earliest deadline */
+   int len, cap;
+   volatile int stop;
+} EventLoop;
+
+/* Initialize an event loop, creating its epoll and eventfd instances.
+ * Returns 0 on success, else error code. */
+static inline int event_init(EventLoop *loop)
+{
+   struct epoll_event ev;
+   int ecode;
+
+   loop->head = loop->tail = loop->spare = NULL;
+   loop->heap = NULL;
+   loop->len = loop->cap = 0;
+   loop->stop = 0;
+
+   loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+   if(loop->epfd < 0)
+      return errno;
+   loop->evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if(loop->evfd < 0) {
+      ecode = errno;
+      close(loop->epfd);
+      return ecode;
+   }
+   /* the eventfd is identified by a NULL watch pointer */
+   ev.events = EPOLLIN;
+   ev.data.ptr = NULL;
+   if(epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->evfd, &ev)) {
+      ecode = errno;
+      close(loop->evfd);
+      close(loop->epfd);
+      return ecode;
+   }
+
+   return mutex_init(&loop->lock);
+}
+
+/* Uninitialize an event loop. Pending posted tasks are discarded.
+ * Returns 0 on success, else error code. */
+static inline int event_free(EventLoop *loop)
+{
+   EVENT_POST *post;
+
+   while((post = loop->head)) {
+      loop->head = post->next;
+      free(post);
+   }
+   while((post = loop->spare)) {
+      loop->spare = post->next;
+      free(post);
+   }
+   free(loop->heap);
+   loop->heap = NULL;
+   loop->len = loop->cap = 0;
+   close(loop->evfd);
+   close(loop->epfd);
+
+   return mutex_free(&loop->lock);
+}
+
+/* Watch a file descriptor for `events`, executing `func` on readiness.
+ * Returns 0 on success, else error code. */
+static inline int event_add(EventLoop *loop, EventWatch *watch, int fd,
+   unsigned events, EventFunc *func, void *arg)
+{
+   struct epoll_event ev;
+
+   watch->fd = fd;
+   watch->func = func;
+   watch->arg = arg;
+   ev.events = events;
+   ev.data.ptr = watch;
+   if(epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev))
+      return errno;
+
+   return 0;
+}
+
+/* Modify the events of a watched file descriptor.
+ * Returns 0 on success, else error code. */
+static inline int event_mod(EventLoop *loop, EventWatch *watch,
+   unsigned events)
+{
+   struct epoll_event ev;
+
+   ev.events = events;
+   ev.data.ptr = watch;
+   if(epoll_ctl(loop->epfd, EPOLL_CTL_MOD, watch->fd, &ev))
+      return errno;
+
+   return 0;
+}
+
+/* Stop watching a file descriptor.
+ * Returns 0 on success, else error code. */
+static inline int event_del(EventLoop *loop, EventWatch *watch)
+{
+   struct epoll_event ev;
+
+   if(epoll_ctl(loop->epfd, EPOLL_CTL_DEL, watch->fd, &ev))
+      return errno;
+
+   return 0;
+}
+
+/* Swap two timers within the timer heap, maintaining their index. */
+static inline void event_timerswap(EventLoop *loop, int a, int b)
+{
+   EventTimer *temp;
+
+   temp = loop->heap[a];
+   loop->heap[a] = loop->heap[b];
+   loop->heap[b] = temp;
+   loop->heap[a]->index = a;
+   loop->heap[b]->index = b;
+}
+
+/* Restore the heap order of the timer at position `i`. */
+static inline void event_timerfix(EventLoop *loop, int i)
+{
+   int parent, child;
+
+   /* sift up */
+   for( ; i > 0; i = parent) {
+      parent = (i - 1) / 2;
+      if(loop->heap[parent]->deadline - loop->heap[i]->deadline <= 0) break;
+      event_timerswap(loop, i, parent);
+   }
+   /* sift down */
+   for( ; (child = (i * 2) + 1) < loop->len; i = child) {
+      if(child + 1 < loop->len && (loop->heap[child + 1]->deadline -
+         loop->heap[child]->deadline) < 0) child++;
+      if(loop->heap[i]->deadline - loop->heap[child]->deadline <= 0) break;
+      event_timerswap(loop, i, child);
+   }
+}
+
+/* Stop a timer, if active. Always returns 0. */
+static inline int event_deltimer(EventLoop *loop, EventTimer *timer)
+{
+   int i = timer->index;
+
+   if(i < 0 || i >= loop->len || loop->heap[i] != timer)
+      return 0;
+
+   timer->index = -1;
+   if(i != --loop->len) {
+      loop->heap[i] = loop->heap[loop->len];
+      loop->heap[i]->index = i;
+      event_timerfix(loop, i);
+   }
+
+   return 0;
+}
+
+/* Start (or restart) a one-shot timer, executing `func` after `ms`
+ * milliseconds. A callback may restart its own timer for periodic use.
+ * Returns 0 on success, else ENOMEM. */
+static inline int event_settimer(EventLoop *loop, EventTimer *timer,
+   unsigned long ms, TimerFunc *func, void *arg)
+{
+   EventTimer **heap;
+   int cap;
+
+   event_deltimer(loop, timer);
+   if(loop->len == loop->cap) {
+      cap = loop->cap ? loop->cap * 2 : 16;
+      heap = (EventTimer **) realloc(loop->heap, sizeof(EventTimer *) * cap);
+      if(heap == NULL)
+         return ENOMEM;
+      loop->heap = heap;
+      loop->cap = cap;
+   }
+   timer->deadline = milliseconds() + (long) ms;
+   timer->func = func;
+   timer->arg = arg;
+   timer->index = loop->len;
+   loop->heap[loop->len++] = timer;
+   event_timerfix(loop, timer->index);
+
+   return 0;
+}
+
+/* Post a task for execution by the thread running a loop, waking the
+ * loop if required. Safe to call from any thread.
+ * Returns 0 on success, else error code, where the task is not posted. */
+static inline int event_post(EventLoop *loop, PostFunc *func, void *arg)
+{
+   EVENT_POST *post;
+   int ecode;
+
+   mutex_lock(&loop->lock);
+   post = loop->spare;
+   if(post) loop->spare = post->next;
+   else {
+      post = (EVENT_POST *) malloc(sizeof(EVENT_POST));
+      if(post == NULL) {
+         mutex_unlock(&loop->lock);
+         return ENOMEM;
+      }
+   }
+   post->func = func;
+   post->arg = arg;
+   post->next = NULL;
+   /* only the first pending post requires a wake up, written before the
+    * post is queued; a saturated eventfd (EAGAIN) is already signalled */
+   if(loop->tail == NULL && eventfd_write(loop->evfd, 1) &&
+      errno != EAGAIN) {
+      ecode = errno;
+      post->next = loop->spare;
+      loop->spare = post;
+      mutex_unlock(&loop->lock);
+      return ecode;
+   }
+   if(loop->tail) loop->tail->next = post;
+   else loop->head = post;
+   loop->tail = post;
+   mutex_unlock(&loop->lock);
+
+   return 0;
+}
+
+/* Request a loop to stop, from within a callback or any thread.
+ * event_run() returns after completing its current iteration.
+ * Returns 0 on success, else error code. */
+static inline int event_stop(EventLoop *loop)
+{
+   loop->stop = 1;
+   if(eventfd_write(loop->evfd, 1))
+      return errno;
+
+   return 0;
+}
+
+/* Execute all tasks posted to a loop, as of the time of calling. */
+static inline void event_runposts(EventLoop *loop)
+{
+   EVENT_POST *post, *first, *last;
+   eventfd_t value;
+
+   eventfd_read(loop->evfd, &value);
+   mutex_lock(&loop->lock);
+   first = loop->head;
+   loop->head = loop->tail = NULL;
+   mutex_unlock(&loop->lock);
+   if(first == NULL)
+      return;
+
+   for(last = post = first; post; post = post->next) {
+      post->func(post->arg);
+      last = post;
+   }
+
+   /* recycle post nodes */
+   mutex_lock(&loop->lock);
+   last->next = loop->spare;
+   loop->spare = first;
+   mutex_unlock(&loop->lock);
+}
+
+/* Execute a single loop iteration, waiting at most `ms` milliseconds
+ * (or indefinitely if negative) for watched events, timer expiry or
+ * posted tasks, and executing their callbacks. (BLOCKING)
+ * Returns the number of callbacks executed, else -1 with errno set. */
+static inline int event_runonce(EventLoop *loop, long ms)
+{
+   struct epoll_event ev[EVENT_BATCH];
+   EventWatch *watch;
+   EventTimer *timer;
+   long now, wait;
+   int i, n, count;
+
+   /* wait no longer than the earliest timer */
+   if(loop->len) {
+      wait = loop->heap[0]->deadline - milliseconds();
+      if(wait < 0) wait = 0;
+      if(ms < 0 || wait < ms) ms = wait;
+   }
+   if(ms > 0x7fffffffL) ms = 0x7fffffffL;
+
+   n = epoll_wait(loop->epfd, ev, EVENT_BATCH, (int) ms);
+   if(n < 0) {
+      if(errno != EINTR) return -1;
+      n = 0;
+   }
+
+   for(count = i = 0; i < n; i++) {
+      watch = (EventWatch *) ev[i].data.ptr;
+      if(watch == NULL) event_runposts(loop);
+      else watch->func(loop, watch, ev[i].events);
+      count++;
+   }
+
+   /* execute expired timers, in deadline order */
+   now = milliseconds();
+   while(loop->len && loop->heap[0]->deadline - now <= 0) {
+      timer = loop->heap[0];
+      event_deltimer(loop, timer);
+      timer->func(loop, timer);
+      count++;
+   }
+
+   return count;
+}
+
+/* Run a loop until event_stop() is called. (BLOCKING)
+ * Returns 0 on success, else error code. */
+static inline int event_run(EventLoop *loop)
+{
+   while(!loop->stop) {
+      if(event_runonce(loop, -1) < 0)
+         return errno;
+   }
+   loop->stop = 0;
+
+   return 0;
+}
+
+
+#endif /* end _MP_EVENT_H_ */
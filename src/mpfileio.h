@@ -0,0 +1,463 @@
+/* ****************************************************************
+ * Asynchronous file I/O support, with io_uring and thread pool backends.
+ *  - mpfileio.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides asynchronous positional file reads and writes, in
+ * three steps; requests are prepared with fileio_read() or fileio_write(),
+ * submitted as a batch with fileio_submit(), and their completions are
+ * polled (or waited for) with fileio_reap().
+ *
+ * Two backends are available:
+ * - FILEIO_URING; the Linux io_uring interface, driven directly through
+ *   its system calls and shared memory rings (liburing not required).
+ *   A batch of requests is submitted with a single system call, and
+ *   completions are reaped from shared memory without a system call.
+ * - FILEIO_POOL; a ThreadPool (mppool.h) of worker threads performing
+ *   blocking pread()/pwrite() calls, for systems (or sandboxes) lacking
+ *   io_uring support.
+ * FILEIO_AUTO selects io_uring where available, else the thread pool.
+ *
+ * NOTES:
+ * - Support functions requiring a FileIO or FileRequest param, SHALL be
+ *   passed as pointers.
+ * - A FileRequest, and its buffer, are caller allocated, and SHALL
+ *   remain valid until reaped.
+ * - A FileIO context is intended for use by a single thread.
+ * - Completed requests hold the bytes transferred in `result`, else a
+ *   negative error code (-errno).
+ * - A request transfers at most SSIZE_MAX bytes, else is refused with
+ *   EINVAL. Like pread()/pwrite(), a transfer may complete short of its
+ *   length (Linux transfers at most 0x7ffff000 bytes per request).
+ * - POSIX only; io_uring requires Linux 5.1 or later. Requests are
+ *   submitted as single vector IORING_OP_READV/WRITEV operations, the
+ *   IORING_OP_READ/WRITE operations requiring Linux 5.6.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial FileIO implementation.
+ * Rev.2   2026-10-18
+ *   io_uring requests submitted as single vector READV/WRITEV operations,
+ *   supported from Linux 5.1, and lengths no longer truncated to 32 bits.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_FILEIO_H_
+#define _MP_FILEIO_H_  /* include guard */
+
+
+#ifdef _WIN32
+#error "mpfileio.h requires POSIX pread/pwrite"
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "mppool.h"
+#include "mpthread.h"
+
+/* io_uring support is detected at compile time, and again at runtime */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define FILEIO_HAS_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+/* FileIO backends */
+#define FILEIO_AUTO   0
+#define FILEIO_URING  1
+#define FILEIO_POOL   2
+
+/* FileRequest operations */
+#define FILEIO_READ   0
+#define FILEIO_WRITE  1
+
+/* Number of worker threads of the thread pool backend */
+#ifndef FILEIO_THREADS
+#define FILEIO_THREADS  4
+#endif
+
+/* An asynchronous file I/O request. */
+typedef struct _FileRequest {
+   int op;
+   int fd;
+   void *buf;
+   size_t len;
+   off_t offset;
+   long result;         /* bytes transferred, else -errno */
+   void *arg;           /* caller defined */
+   struct _FileIO *io;
+   struct _FileRequest *next;
+#ifdef FILEIO_HAS_URING
+   struct iovec iov;    /* io_uring vector, read by the kernel on submit */
+#endif
+} FileRequest;
+
+/* An asynchronous file I/O context. */
+typedef struct _FileIO {
+   int backend;
+   unsigned depth;      /* maximum requests in flight */
+   unsigned inflight;   /* requests prepared but not yet reaped */
+   unsigned queued;     /* requests prepared but not yet submitted */
+#ifdef FILEIO_HAS_URING
+   /* io_uring backend */
+   int ringfd;
+   void *sqring, *cqring;
+   size_t sqsize, cqsize, sqesize;
+   struct io_uring_sqe *sqes;
+   struct io_uring_cqe *cqes;
+   unsigned *sqhead, *sqtail, *sqmask, *sqarray;
+   unsigned *cqhead, *cqtail, *cqmask;
+#endif
+   /* thread pool backend */
+   ThreadPool pool;
+   Mutex lock;
+   Condition cond;      /* signalled on request completion */
+   FileRequest *qhead, *qtail;  /* prepared requests */
+   FileRequest *dhead, *dtail;  /* completed requests */
+} FileIO;
+
+#ifdef FILEIO_HAS_URING
+
+/* Initialize the io_uring backend of a context.
+ * Returns 0 on success, else error code. */
+static inline int fileio_uringinit(FileIO *io)
+{
+   struct io_uring_params p;
+   unsigned char *sq, *cq;
+   int ecode;
+
+   memset(&p, 0, sizeof(p));
+   io->ringfd = (int) syscall(__NR_io_uring_setup, io->depth, &p);
+   if(io->ringfd < 0)
+      return errno;
+
+   io->sqsize = p.sq_off.array + (p.sq_entries * sizeof(unsigned));
+   io->cqsize = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+   io->sqesize = p.sq_entries * sizeof(struct io_uring_sqe);
+   /* rings may share a single mapping */
+   if(p.features & IORING_FEAT_SINGLE_MMAP) {
+      if(io->cqsize > io->sqsize) io->sqsize = io->cqsize;
+      io->cqsize = 0;
+   }
+   io->sqring = io->cqring = MAP_FAILED;
+   io->sqes = (struct io_uring_sqe *) MAP_FAILED;
+   io->sqring = mmap(NULL, io->sqsize, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, io->ringfd, IORING_OFF_SQ_RING);
+   if(io->sqring == MAP_FAILED) goto FAIL;
+   if(io->cqsize) {
+      io->cqring = mmap(NULL, io->cqsize, PROT_READ | PROT_WRITE,
+         MAP_SHARED | MAP_POPULATE, io->ringfd, IORING_OFF_CQ_RING);
+      if(io->cqring == MAP_FAILED) goto FAIL;
+   } else io->cqring = io->sqring;
+   io->sqes = (struct io_uring_sqe *) mmap(NULL, io->sqesize,
+      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ringfd,
+      IORING_OFF_SQES);
+   if(io->sqes == (struct io_uring_sqe *) MAP_FAILED) goto FAIL;
+
+   sq = (unsigned char *) io->sqring;
+   cq = (unsigned char *) io->cqring;
+   io->sqhead = (unsigned *) (sq + p.sq_off.head);
+   io->sqtail = (unsigned *) (sq + p.sq_off.tail);
+   io->sqmask = (unsigned *) (sq + p.sq_off.ring_mask);
+   io->sqarray = (unsigned *) (sq + p.sq_off.array);
+   io->cqhead = (unsigned *) (cq + p.cq_off.head);
+   io->cqtail = (unsigned *) (cq + p.cq_off.tail);
+   io->cqmask = (unsigned *) (cq + p.cq_off.ring_mask);
+   io->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+   /* the submission ring may be larger than requested */
+   if(io->depth > p.sq_entries) io->depth = p.sq_entries;
+
+   return 0;
+
+FAIL:
+   ecode = errno;
+   if(io->sqes != (struct io_uring_sqe *) MAP_FAILED)
+      munmap(io->sqes, io->sqesize);
+   if(io->cqsize && io->cqring != MAP_FAILED) munmap(io->cqring, io->cqsize);
+   if(io->sqring != MAP_FAILED) munmap(io->sqring, io->sqsize);
+   close(io->ringfd);
+
+   return ecode;
+}
+
+/* Release the io_uring backend of a context. */
+static inline void fileio_uringfree(FileIO *io)
+{
+   munmap(io->sqes, io->sqesize);
+   if(io->cqsize) munmap(io->cqring, io->cqsize);
+   munmap(io->sqring, io->sqsize);
+   close(io->ringfd);
+}
+
+#endif /* end FILEIO_HAS_URING */
+
+/* Thread pool backend task, performing a blocking request. */
+static inline int fileio_task(void *arg)
+{
+   FileRequest *req;
+   ssize_t res;
+   FileIO *io;
+
+   req = (FileRequest *) arg;
+   io = req->io;
+
+   if(req->op == FILEIO_READ)
+      res = pread(req->fd, req->buf, req->len, req->offset);
+   else res = pwrite(req->fd, req->buf, req->len, req->offset);
+   req->result = res < 0 ? -errno : (long) res;
+
+   /* append to completed requests */
+   mutex_lock(&io->lock);
+   req->next = NULL;
+   if(io->dtail) io->dtail->next = req;
+   else io->dhead = req;
+   io->dtail = req;
+   condition_signal(&io->cond);
+   mutex_unlock(&io->lock);
+
+   return 0;
+}
+
+/* Initialize an asynchronous file I/O context, with a `backend` of
+ * FILEIO_AUTO, FILEIO_URING or FILEIO_POOL, permitting at most `depth`
+ * requests in flight. Check io->backend for the backend in use.
+ * Returns 0 on success, else error code. */
+static inline int fileio_init(FileIO *io, int backend, unsigned depth)
+{
+   int ecode;
+
+   if(depth < 1)
+      return EINVAL;
+
+   io->depth = depth;
+   io->inflight = io->queued = 0;
+   io->qhead = io->qtail = io->dhead = io->dtail = NULL;
+
+   if(backend != FILEIO_POOL) {
+#ifdef FILEIO_HAS_URING
+      ecode = fileio_uringinit(io);
+#else
+      ecode = ENOSYS;
+#endif
+      if(ecode == 0) {
+         io->backend = FILEIO_URING;
+         return 0;
+      }
+      if(backend == FILEIO_URING)
+         return ecode;
+   }
+
+   io->backend = FILEIO_POOL;
+   ecode = pool_init(&io->pool, FILEIO_THREADS);
+   if(ecode) return ecode;
+   mutex_init(&io->lock);
+   condition_init(&io->cond);
+
+   return 0;
+}
+
+/* Prepare a request for submission by fileio_submit(). Not for direct
+ * use; see fileio_read() and fileio_write().
+ * Returns 0 on success, else EAGAIN if `depth` requests are in flight,
+ * or EINVAL if `len` exceeds SSIZE_MAX. */
+static inline int fileio_prep(FileIO *io, FileRequest *req, int op, int fd,
+   void *buf, size_t len, off_t offset)
+{
+#ifdef FILEIO_HAS_URING
+   struct io_uring_sqe *sqe;
+   unsigned tail, idx;
+#endif
+
+   if(len > (size_t) SSIZE_MAX) return EINVAL;
+   if(io->inflight >= io->depth)
+      return EAGAIN;
+
+   req->op = op;
+   req->fd = fd;
+   req->buf = buf;
+   req->len = len;
+   req->offset = offset;
+   req->result = 0;
+   req->io = io;
+   req->next = NULL;
+   io->inflight++;
+   io->queued++;
+
+#ifdef FILEIO_HAS_URING
+   if(io->backend == FILEIO_URING) {
+      /* this thread is the only producer of the submission ring */
+      tail = *io->sqtail;
+      idx = tail & *io->sqmask;
+      sqe = &io->sqes[idx];
+      memset(sqe, 0, sizeof(*sqe));
+      /* a single vector, of a length unbounded by the 32-bit sqe->len */
+      req->iov.iov_base = buf;
+      req->iov.iov_len = len;
+      sqe->opcode = op == FILEIO_READ ? IORING_OP_READV : IORING_OP_WRITEV;
+      sqe->fd = fd;
+      sqe->addr = (unsigned long) &req->iov;
+      sqe->len = 1;
+      sqe->off = (unsigned long long) offset;
+      sqe->user_data = (unsigned long long) (size_t) req;
+      io->sqarray[idx] = idx;
+      __atomic_store_n(io->sqtail, tail + 1, __ATOMIC_RELEASE);
+      return 0;
+   }
+#endif
+
+   if(io->qtail) io->qtail->next = req;
+   else io->qhead = req;
+   io->qtail = req;
+
+   return 0;
+}
+
+/* Prepare an asynchronous read of `len` bytes at `offset` of `fd`.
+ * Returns 0 on success, else EAGAIN if `depth` requests are in flight,
+ * or EINVAL if `len` exceeds SSIZE_MAX. */
+#define fileio_read(io,req,fd,buf,len,offset) \
+   fileio_prep(io,req,FILEIO_READ,fd,buf,len,offset)
+
+/* Prepare an asynchronous write of `len` bytes at `offset` of `fd`.
+ * Returns 0 on success, else EAGAIN if `depth` requests are in flight,
+ * or EINVAL if `len` exceeds SSIZE_MAX. */
+#define fileio_write(io,req,fd,buf,len,offset) \
+   fileio_prep(io,req,FILEIO_WRITE,fd,buf,len,offset)
+
+/* Submit all prepared requests, as a single batch.
+ * Returns 0 on success, else error code. */
+static inline int fileio_submit(FileIO *io)
+{
+   FileRequest *req, *next;
+   int ecode;
+
+#ifdef FILEIO_HAS_URING
+   int res;
+
+   if(io->backend == FILEIO_URING) {
+      while(io->queued) {
+         res = (int) syscall(__NR_io_uring_enter, io->ringfd, io->queued,
+            0, 0, NULL, 0);
+         if(res < 0) {
+            if(errno == EINTR) continue;
+            return errno;
+         }
+         io->queued -= (unsigned) res;
+      }
+      return 0;
+   }
+#endif
+
+   /* a submitted request may complete (reusing `next`) immediately */
+   while((req = io->qhead)) {
+      next = req->next;
+      ecode = pool_submit(&io->pool, fileio_task, req);
+      if(ecode) return ecode;
+      io->qhead = next;
+      io->queued--;
+   }
+   io->qtail = NULL;
+
+   return 0;
+}
+
+/* Reap up to `max` completed requests into `done`, waiting until at
+ * least `min` requests (limited to those in flight) have completed.
+ * A `min` of zero polls for completions without blocking.
+ * Returns the number of requests reaped, else -1 with errno set. */
+static inline int fileio_reap(FileIO *io, FileRequest **done, int max,
+   int min)
+{
+   FileRequest *req;
+   int count;
+
+#ifdef FILEIO_HAS_URING
+   struct io_uring_cqe *cqe;
+   unsigned head, tail;
+#endif
+
+   if(min > (int) io->inflight) min = (int) io->inflight;
+   if(min > max) min = max;
+   count = 0;
+
+#ifdef FILEIO_HAS_URING
+   if(io->backend == FILEIO_URING) {
+      for( ;; ) {
+         /* this thread is the only consumer of the completion ring */
+         head = *io->cqhead;
+         tail = __atomic_load_n(io->cqtail, __ATOMIC_ACQUIRE);
+         for( ; head != tail && count < max; head++) {
+            cqe = &io->cqes[head & *io->cqmask];
+            req = (FileRequest *) (size_t) cqe->user_data;
+            req->result = cqe->res;
+            done[count++] = req;
+         }
+         __atomic_store_n(io->cqhead, head, __ATOMIC_RELEASE);
+         if(count >= min) break;
+         if(syscall(__NR_io_uring_enter, io->ringfd, 0, min - count,
+            IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR) {
+            io->inflight -= (unsigned) count;
+            return count ? count : -1;
+         }
+      }
+      io->inflight -= (unsigned) count;
+      return count;
+   }
+#endif
+
+   mutex_lock(&io->lock);
+   for( ;; ) {
+      while(count < max && (req = io->dhead)) {
+         io->dhead = req->next;
+         if(io->dhead == NULL) io->dtail = NULL;
+         done[count++] = req;
+      }
+      if(count >= min) break;
+      condition_wait(&io->cond, &io->lock);
+   }
+   mutex_unlock(&io->lock);
+   io->inflight -= (unsigned) count;
+
+   return count;
+}
+
+/* Uninitialize an asynchronous file I/O context. Requests in flight
+ * SHALL be reaped beforehand.
+ * Returns 0 on success, else error code. */
+static inline int fileio_free(FileIO *io)
+{
+#ifdef FILEIO_HAS_URING
+   if(io->backend == FILEIO_URING) {
+      fileio_uringfree(io);
+      return 0;
+   }
+#endif
+
+   pool_free(&io->pool);
+   condition_free(&io->cond);
+
+   return mutex_free(&io->lock);
+}
+
+
+#endif /* end _MP_FILEIO_H_ */
@@ -0,0 +1,502 @@
+/* ****************************************************************
+ * Asynchronous batched logging support, with per-thread buffers.
+ *  - mplog.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a logger that takes formatting, and stdio's stream
+ * lock, off of the logging thread. A call to log_printf() records only
+ * a binary record; a walltime() time stamp, the format pointer, and
+ * the format arguments, into a single-producer/single-consumer ring
+ * buffer owned by the calling thread. A background writer thread merges
+ * the records of all thread buffers in time stamp order, formats them,
+ * and writes them to the output stream in batches.
+ *
+ * Each output line is of the form "[YYYY-MM-DDThh:mm:ss.nnnnnnnnnZ] message",
+ * where the time stamp is the ISO-8601 (UTC) wall clock time of logging.
+ *
+ * NOTES:
+ * - Support functions requiring a Logger param, SHALL be passed as
+ *   pointers.
+ * - Format strings are recorded by reference, and SHALL be string
+ *   literals (or otherwise remain valid until the logger is freed).
+ *   String arguments (%s) are copied into the record, up to LOG_STRLEN
+ *   bytes per record in total, and are silently truncated beyond that.
+ * - Up to LOG_ARGS arguments (including '*' widths) are recorded. The
+ *   remainder of the format string following the last recorded argument,
+ *   or an unsupported conversion (%n, %ls, %Lf, or more than two '*'
+ *   arguments), is written verbatim.
+ * - A newline is appended to every record; format strings SHOULD NOT
+ *   end with one.
+ * - Logging threads are registered with the (process-wide) thread
+ *   registry (mpthread.h), such that each thread buffer has a single
+ *   producer, whichever translation unit logs, and a thread buffer is
+ *   recycled by the next thread assigned the same registry index. When
+ *   a thread buffer is full, the logging thread blocks until the writer
+ *   thread makes room.
+ * - Records are written in time stamp order within each writer batch,
+ *   and in order of logging for any single thread.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial Logger implementation.
+ * Rev.2   2026-10-18
+ *   Time stamps are now fast wall clock time, formatted as ISO-8601.
+ * Rev.3   2026-10-18
+ *   Specifications of more than two '*' arguments are unsupported, and
+ *   bounded when expanded, fixing an overflow of the expansion buffer.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_LOG_H_
+#define _MP_LOG_H_  /* include guard */
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpthread.h"
+#include "mptime.h"
+
+/* Number of records held by each thread buffer, SHALL be a power of 2.
+ * May be overridden by defining LOG_SLOTS before inclusion. */
+#ifndef LOG_SLOTS
+#define LOG_SLOTS  1024
+#endif
+
+#define LOG_ARGS      8      /* maximum recorded arguments per record */
+#define LOG_STRLEN    48     /* string argument bytes per record */
+#define LOG_LINE      512    /* maximum formatted line length */
+#define LOG_BATCH     65536  /* writer output batch size, in bytes */
+#define LOG_FLUSH_MS  10     /* writer thread idle period */
+
+/* Ring buffer index load/store, with acquire/release semantics.
+ * MSVC volatile accesses carry these semantics by default (/volatile:ms). */
+#ifdef _MSC_VER
+#define log_acquire(p)    ( *(volatile unsigned *) (p) )
+#define log_release(p,v)  ( *(volatile unsigned *) (p) = (v) )
+#else
+#define log_acquire(p)    __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define log_release(p,v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+/* Recorded argument classes */
+#define LOG_INT     0
+#define LOG_LONG    1
+#define LOG_LLONG   2
+#define LOG_SIZE    3
+#define LOG_DOUBLE  4
+#define LOG_PTR     5
+#define LOG_STR     6
+#define LOG_NONE    7  /* no argument, "%%" */
+#define LOG_BAD     8  /* unsupported conversion */
+
+/* A recorded argument. String arguments hold an offset into `str`. */
+typedef union {
+   long long i;
+   double d;
+   const void *p;
+} LOG_ARG;
+
+/* A binary log record. */
+typedef struct {
+   long long ns;        /* walltime() time stamp */
+   const char *fmt;
+   int nargs;
+   LOG_ARG arg[LOG_ARGS];
+   char str[LOG_STRLEN];
+} LOG_RECORD;
+
+/* A thread buffer. The `head` is advanced only by the writer thread,
+ * and the `tail` only by the owning thread, each on its own cache line. */
+typedef struct {
+   unsigned head;
+   char pad1[64 - sizeof(unsigned)];
+   unsigned tail;
+   char pad2[64 - sizeof(unsigned)];
+   LOG_RECORD ring[LOG_SLOTS];
+} LOG_BUFFER;
+
+/* An asynchronous logger. */
+typedef struct {
+   FILE *stream;
+   Mutex lock;
+   Condition wake;      /* signalled to wake the writer thread */
+   Condition done;      /* signalled on completion of a writer batch */
+   LOG_BUFFER *bufs[THREAD_REGISTRY_MAX];
+   int nbufs;           /* registry index high water mark (+1) */
+   unsigned long flushreq, flushed;
+   char *batch;         /* writer output batch */
+   TimeCache cache;     /* writer time stamp formatting */
+   ThreadID writer;
+   int stop;
+} Logger;
+
+/* Parse a conversion specification following its '%' character, and
+ * obtain the class of its argument and number of '*' arguments.
+ * Returns a pointer to the character following the specification. */
+static inline const char *log_spec(const char *fmt, int *cls, int *stars)
+{
+   int longs, size, ldbl;
+
+   /* flags, width and precision */
+   for(*stars = 0; *fmt && strchr("-+ #0'123456789.*", *fmt); fmt++)
+      if(*fmt == '*') (*stars)++;
+   /* length modifiers */
+   for(longs = size = ldbl = 0; *fmt && strchr("hlqjztL", *fmt); fmt++) {
+      if(*fmt == 'l' || *fmt == 'q') longs++;
+      else if(*fmt == 'j') longs = 2;
+      else if(*fmt == 'z' || *fmt == 't') size = 1;
+      else if(*fmt == 'L') ldbl = 1;
+   }
+   /* conversion */
+   switch(*fmt) {
+      case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+         if(size) *cls = LOG_SIZE;
+         else if(longs > 1) *cls = LOG_LLONG;
+         else if(longs) *cls = LOG_LONG;
+         else *cls = LOG_INT;
+         break;
+      case 'f': case 'F': case 'e': case 'E':
+      case 'g': case 'G': case 'a': case 'A':
+         *cls = ldbl ? LOG_BAD : LOG_DOUBLE;
+         break;
+      case 's': *cls = longs ? LOG_BAD : LOG_STR; break;
+      case 'p': *cls = LOG_PTR; break;
+      case '%': *cls = LOG_NONE; break;
+      default: *cls = LOG_BAD;
+   }
+   /* at most a width and a precision argument */
+   if(*stars > 2) *cls = LOG_BAD;
+   if(*fmt) fmt++;
+
+   return fmt;
+}
+
+/* Record the format arguments of a log record, as directed by its
+ * format string. Recording stops at LOG_ARGS or an unsupported
+ * conversion, either of which are reported by the writer thread. */
+static inline void log_capture(LOG_RECORD *rec, va_list ap)
+{
+   const char *fmt, *s;
+   int cls, stars, n, used;
+
+   n = used = 0;
+   for(fmt = rec->fmt; *fmt; ) {
+      if(*fmt++ != '%') continue;
+      fmt = log_spec(fmt, &cls, &stars);
+      if(cls == LOG_NONE) continue;
+      if(cls == LOG_BAD || n + stars >= LOG_ARGS) break;
+      while(stars--) rec->arg[n++].i = va_arg(ap, int);
+      switch(cls) {
+         case LOG_INT: rec->arg[n].i = va_arg(ap, int); break;
+         case LOG_LONG: rec->arg[n].i = va_arg(ap, long); break;
+         case LOG_LLONG: rec->arg[n].i = va_arg(ap, long long); break;
+         case LOG_SIZE: rec->arg[n].i = (long long) va_arg(ap, size_t); break;
+         case LOG_DOUBLE: rec->arg[n].d = va_arg(ap, double); break;
+         case LOG_PTR: rec->arg[n].p = va_arg(ap, void *); break;
+         case LOG_STR:
+            s = va_arg(ap, const char *);
+            if(s == NULL) s = "(null)";
+            /* copy string, sharing the final terminator when full */
+            rec->arg[n].i = used;
+            while(used < LOG_STRLEN - 1 && *s) rec->str[used++] = *s++;
+            rec->str[used] = '\0';
+            if(used < LOG_STRLEN - 1) used++;
+            break;
+      }
+      n++;
+   }
+   rec->nargs = n;
+}
+
+/* Format a log record as a line, including newline, into `out`.
+ * Returns the length of the formatted line (less than `size`). */
+static inline int log_format(char *out, int size, LOG_RECORD *rec,
+   TimeCache *cache)
+{
+   const char *fmt, *start, *p;
+   char spec[16 + (2 * 11) + 1];  /* specification, stars expanded */
+   int cls, stars, a, j, n, len;
+   LOG_ARG *arg;
+
+   size -= 1;  /* reserve newline */
+   out[0] = '[';
+   len = 1 + iso8601(cache, out + 1, rec->ns, 9);
+   out[len++] = ']';
+   out[len++] = ' ';
+   for(a = 0, fmt = rec->fmt; *fmt && len < size - 1; ) {
+      if(*fmt != '%') {
+         out[len++] = *fmt++;
+         continue;
+      }
+      start = fmt;
+      fmt = log_spec(fmt + 1, &cls, &stars);
+      if(cls == LOG_NONE) {
+         out[len++] = '%';
+         continue;
+      }
+      /* unrecorded arguments, write the remainder verbatim */
+      if(cls == LOG_BAD || a + stars >= rec->nargs || fmt - start > 16) {
+         for(fmt = start; *fmt && len < size - 1; ) out[len++] = *fmt++;
+         break;
+      }
+      /* substitute recorded '*' arguments into the specification */
+      for(j = 0, p = start; p < fmt; p++) {
+         if(*p == '*') {
+            j += snprintf(spec + j, sizeof(spec) - j, "%d",
+               (int) rec->arg[a++].i);
+         } else spec[j++] = *p;
+      }
+      spec[j] = '\0';
+      arg = &rec->arg[a++];
+      switch(cls) {
+         case LOG_INT:
+            n = snprintf(out + len, (size_t) (size - len), spec, (int) arg->i);
+            break;
+         case LOG_LONG:
+            n = snprintf(out + len, (size_t) (size - len), spec, (long) arg->i);
+            break;
+         case LOG_LLONG:
+            n = snprintf(out + len, (size_t) (size - len), spec, arg->i);
+            break;
+         case LOG_SIZE:
+            n = snprintf(out + len, (size_t) (size - len), spec,
+               (size_t) arg->i);
+            break;
+         case LOG_DOUBLE:
+            n = snprintf(out + len, (size_t) (size - len), spec, arg->d);
+            break;
+         case LOG_PTR:
+            n = snprintf(out + len, (size_t) (size - len), spec, arg->p);
+            break;
+         default:
+            n = snprintf(out + len, (size_t) (size - len), spec,
+               rec->str + arg->i);
+      }
+      /* account for truncated output */
+      if(n > 0) len += n < size - len ? n : size - len - 1;
+   }
+   out[len++] = '\n';
+
+   return len;
+}
+
+/* Format and write the records of all thread buffers, up to the tail of
+ * each buffer observed on entry, in time stamp order.
+ * Returns the number of records written. */
+static inline long log_drain(Logger *logger, LOG_BUFFER **bufs, int nbufs)
+{
+   unsigned heads[THREAD_REGISTRY_MAX], tails[THREAD_REGISTRY_MAX];
+   LOG_RECORD *rec, *best;
+   long count;
+   int i, b, len;
+
+   for(i = 0; i < nbufs; i++) {
+      heads[i] = tails[i] = 0;
+      if(bufs[i] == NULL) continue;
+      heads[i] = bufs[i]->head;
+      tails[i] = log_acquire(&bufs[i]->tail);
+   }
+   for(count = len = 0; ; count++) {
+      /* select the earliest pending record */
+      for(best = NULL, b = i = 0; i < nbufs; i++) {
+         if(heads[i] == tails[i]) continue;
+         rec = &bufs[i]->ring[heads[i] & (LOG_SLOTS - 1)];
+         if(best == NULL || rec->ns < best->ns) {
+            best = rec;
+            b = i;
+         }
+      }
+      if(best == NULL) break;
+      if(LOG_BATCH - len < LOG_LINE) {
+         fwrite(logger->batch, 1, (size_t) len, logger->stream);
+         len = 0;
+      }
+      len += log_format(logger->batch + len, LOG_LINE, best, &logger->cache);
+      /* release the record slot to its thread */
+      log_release(&bufs[b]->head, ++heads[b]);
+   }
+   if(len) fwrite(logger->batch, 1, (size_t) len, logger->stream);
+   if(count) fflush(logger->stream);
+
+   return count;
+}
+
+/* Logger writer thread. Writes batches until the logger is freed,
+ * sleeping up to LOG_FLUSH_MS while no records are pending. */
+static inline Threaded log_writer(void *arg)
+{
+   LOG_BUFFER *bufs[THREAD_REGISTRY_MAX];
+   Logger *logger;
+   unsigned long req;
+   int nbufs, stop;
+   long count;
+
+   logger = (Logger *) arg;
+   mutex_lock(&logger->lock);
+   for( ; ; ) {
+      /* observe requests, and thread buffers, before writing a batch */
+      req = logger->flushreq;
+      stop = logger->stop;
+      nbufs = logger->nbufs;
+      memcpy(bufs, logger->bufs, nbufs * sizeof(*bufs));
+      mutex_unlock(&logger->lock);
+      count = log_drain(logger, bufs, nbufs);
+      mutex_lock(&logger->lock);
+      logger->flushed = req;
+      condition_broadcast(&logger->done);
+      if(stop) break;
+      if(count == 0 && logger->flushreq == req && !logger->stop)
+         condition_timedwait(&logger->wake, &logger->lock, LOG_FLUSH_MS);
+   }
+   mutex_unlock(&logger->lock);
+
+   return Treturn;
+}
+
+/* Obtain the buffer of the current thread, registering the thread
+ * with the thread registry and allocating a buffer where necessary.
+ * Returns a pointer to the buffer, else NULL on error. */
+static inline LOG_BUFFER *log_buffer(Logger *logger)
+{
+   LOG_BUFFER *buf;
+   int idx;
+
+   idx = thread_register();
+   if(idx < 0) return NULL;
+
+   mutex_lock(&logger->lock);
+   buf = logger->bufs[idx];
+   if(buf == NULL) {
+      buf = (LOG_BUFFER *) malloc(sizeof(LOG_BUFFER));
+      if(buf) {
+         buf->head = buf->tail = 0;
+         logger->bufs[idx] = buf;
+         if(logger->nbufs <= idx) logger->nbufs = idx + 1;
+      }
+   }
+   mutex_unlock(&logger->lock);
+
+   return buf;
+}
+
+/* Record a log message, formatted as per printf(), for writing by the
+ * writer thread. A newline is appended. (BLOCKING, only while the
+ * thread buffer is full)
+ * Returns 0 on success, else error code. */
+static inline int log_printf(Logger *logger, const char *fmt, ...)
+{
+   LOG_BUFFER *buf;
+   LOG_RECORD *rec;
+   va_list ap;
+   unsigned tail;
+   int idx;
+
+   idx = thread_index();
+   if(idx < 0 || (buf = logger->bufs[idx]) == NULL) {
+      buf = log_buffer(logger);
+      if(buf == NULL) return ENOMEM;
+   }
+
+   tail = buf->tail;
+   if(tail - log_acquire(&buf->head) >= LOG_SLOTS) {
+      /* buffer full, wake writer and wait for a batch */
+      mutex_lock(&logger->lock);
+      while(tail - log_acquire(&buf->head) >= LOG_SLOTS) {
+         condition_signal(&logger->wake);
+         condition_timedwait(&logger->done, &logger->lock, LOG_FLUSH_MS);
+      }
+      mutex_unlock(&logger->lock);
+   }
+
+   rec = &buf->ring[tail & (LOG_SLOTS - 1)];
+   rec->ns = walltime();
+   rec->fmt = fmt;
+   va_start(ap, fmt);
+   log_capture(rec, ap);
+   va_end(ap);
+   /* publish record to writer thread */
+   log_release(&buf->tail, tail + 1);
+
+   return 0;
+}
+
+/* Wait for all records logged before the call to be written, and
+ * the output stream flushed. (BLOCKING)
+ * Returns 0 on success, else error code. */
+static inline int log_flush(Logger *logger)
+{
+   unsigned long req;
+
+   mutex_lock(&logger->lock);
+   req = ++logger->flushreq;
+   condition_signal(&logger->wake);
+   while((long) (req - logger->flushed) > 0)
+      condition_wait(&logger->done, &logger->lock);
+
+   return mutex_unlock(&logger->lock);
+}
+
+/* Initialize a logger, writing to `stream`, and start its writer thread.
+ * Returns 0 on success, else error code. */
+static inline int log_init(Logger *logger, FILE *stream)
+{
+   int ecode;
+
+   memset(logger, 0, sizeof(*logger));
+   logger->stream = stream;
+   logger->batch = (char *) malloc(LOG_BATCH);
+   if(logger->batch == NULL) return ENOMEM;
+   mutex_init(&logger->lock);
+   condition_init(&logger->wake);
+   condition_init(&logger->done);
+
+   ecode = thread_create(&logger->writer, log_writer, logger);
+   if(ecode) {
+      condition_free(&logger->done);
+      condition_free(&logger->wake);
+      mutex_free(&logger->lock);
+      free(logger->batch);
+   }
+
+   return ecode;
+}
+
+/* Uninitialize a logger, writing all records logged before the call,
+ * and stopping its writer thread. The stream is flushed, not closed.
+ * Returns 0 on success, else error code. */
+static inline int log_free(Logger *logger)
+{
+   int i;
+
+   mutex_lock(&logger->lock);
+   logger->stop = 1;
+   condition_signal(&logger->wake);
+   mutex_unlock(&logger->lock);
+   thread_wait(&logger->writer);
+
+   for(i = 0; i < logger->nbufs; i++)
+      free(logger->bufs[i]);
+   free(logger->batch);
+   condition_free(&logger->done);
+   condition_free(&logger->wake);
+
+   return mutex_free(&logger->lock);
+}
+
+
+#endif /* end _MP_LOG_H_ */
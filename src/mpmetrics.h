@@ -0,0 +1,370 @@
+/* ****************************************************************
+ * Shared memory metrics support, in a memory-mapped file.
+ *  - mpmetrics.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a metrics registry of counters, gauges and
+ * histograms, whose values live in a memory-mapped file. Metric values
+ * are updated in place with atomic operations, and are read by another
+ * process attaching the same file (read-only), such that exporting
+ * metrics costs the instrumented process no formatting, no locks and
+ * no thread of its own.
+ *
+ * The file holds a header, followed by an array of fixed size, cache
+ * line aligned, metric slots. A metric is published by writing its slot,
+ * then its type, then the count of metrics in the header, and is never
+ * removed; readers need only read the count, then the slots before it.
+ * metrics_dump() writes all metrics in the Prometheus text format.
+ *
+ * NOTES:
+ * - Support functions requiring a Metrics or Metric param, SHALL be
+ *   passed as pointers.
+ * - Metrics are registered by name, which SHALL be a valid Prometheus
+ *   metric name (shorter than METRIC_NAMELEN). Registering an existing
+ *   name obtains the existing metric, if of the same type.
+ * - Each value is read atomically, but a histogram (buckets, sum and
+ *   count) is not read as a consistent snapshot while being updated.
+ * - Metric files are read on the same architecture as written.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial Metrics implementation.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_METRICS_H_
+#define _MP_METRICS_H_  /* include guard */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mpthread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define METRICS_MAGIC    "MPMETRIC"
+#define METRICS_VERSION  1
+#define METRIC_NAMELEN   48
+#define METRIC_BUCKETS   16  /* maximum histogram bucket bounds */
+
+/* Metric types, 0 is an unpublished metric slot */
+#define METRIC_COUNTER    1
+#define METRIC_GAUGE      2
+#define METRIC_HISTOGRAM  3
+
+/* Atomic metric value operations, and metric publication. Under MSVC,
+ * aligned volatile 64-bit loads and stores are atomic on 64-bit targets,
+ * and read-only mappings SHALL NOT be read with interlocked functions. */
+#ifdef _MSC_VER
+#define metric_fetchadd(p,v)  \
+   InterlockedExchangeAdd64((volatile LONG64 *) (p), (LONG64) (v))
+#define metric_load(p)        ( *(volatile long long *) (p) )
+#define metric_store(p,v)     ( *(volatile long long *) (p) = (v) )
+#define metric_acquire(p)     ( *(volatile unsigned *) (p) )
+#define metric_release(p,v)   ( *(volatile unsigned *) (p) = (v) )
+#else
+#define metric_fetchadd(p,v)  __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+#define metric_load(p)        __atomic_load_n(p, __ATOMIC_RELAXED)
+#define metric_store(p,v)     __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define metric_acquire(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define metric_release(p,v)   __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+/* Metrics file header. */
+typedef struct {
+   char magic[8];
+   unsigned version;
+   unsigned capacity;   /* metric slots */
+   unsigned count;      /* published metrics */
+   char pad[64 - 8 - (3 * sizeof(unsigned))];
+} METRICS_HEADER;
+
+/* A metric slot. Histogram bucket counts are not cumulative, the final
+ * bucket counts observations above every bound (+Inf). */
+typedef struct {
+   char name[METRIC_NAMELEN];
+   unsigned type;
+   unsigned buckets;    /* histogram bucket bounds */
+   long long value;     /* counter, gauge, or histogram sum */
+   long long count;     /* histogram observations */
+   long long bound[METRIC_BUCKETS];       /* inclusive upper bounds */
+   long long bucket[METRIC_BUCKETS + 1];
+   char pad[48];        /* cache line (64 byte) multiple */
+} Metric;
+
+/* A metrics file, mapped for update (metrics_open) or read-only reading
+ * (metrics_attach). */
+typedef struct {
+   METRICS_HEADER *hdr;
+   Metric *metric;
+   size_t size;
+   Mutex lock;          /* metric registration */
+#ifdef _WIN32
+   HANDLE file, map;
+#else
+   int fd;
+#endif
+} Metrics;
+
+/* Increment a counter (or gauge) by 1. */
+#define metric_inc(metric)     metric_add(metric, 1)
+/* Add to a counter (or gauge) a value. */
+#define metric_add(metric,v)   ( (void) metric_fetchadd(&(metric)->value, v) )
+/* Set a gauge to a value. */
+#define metric_set(metric,v)   ( (void) metric_store(&(metric)->value, v) )
+/* Obtain the value of a counter or gauge, or the sum of a histogram. */
+#define metric_value(metric)   ( metric_load(&(metric)->value) )
+
+/* Register (publish) a metric, or obtain an existing metric of the same
+ * name and type. Not for direct use; see metric_counter(), metric_gauge()
+ * and metric_histogram().
+ * Returns a pointer to the metric, else NULL on error. */
+static inline Metric *metric_register(Metrics *m, const char *name,
+   unsigned type, const long long *bounds, unsigned n)
+{
+   Metric *metric;
+   unsigned i;
+
+   if(n > METRIC_BUCKETS || strlen(name) >= METRIC_NAMELEN) return NULL;
+
+   mutex_lock(&m->lock);
+   for(i = 0; i < m->hdr->count; i++) {
+      if(strcmp(m->metric[i].name, name) == 0) {
+         metric = m->metric[i].type == type ? &m->metric[i] : NULL;
+         mutex_unlock(&m->lock);
+         return metric;
+      }
+   }
+   metric = NULL;
+   if(i < m->hdr->capacity) {
+      metric = &m->metric[i];
+      strcpy(metric->name, name);
+      metric->buckets = n;
+      if(n) memcpy(metric->bound, bounds, n * sizeof(*bounds));
+      /* publish the metric, then its slot */
+      metric_release(&metric->type, type);
+      metric_release(&m->hdr->count, i + 1);
+   }
+   mutex_unlock(&m->lock);
+
+   return metric;
+}
+
+/* Register a counter, a monotonically increasing value.
+ * Returns a pointer to the metric, else NULL on error. */
+#define metric_counter(m,name)  \
+   metric_register(m, name, METRIC_COUNTER, NULL, 0)
+
+/* Register a gauge, a value that may increase and decrease.
+ * Returns a pointer to the metric, else NULL on error. */
+#define metric_gauge(m,name)  \
+   metric_register(m, name, METRIC_GAUGE, NULL, 0)
+
+/* Register a histogram, of `n` (ascending) bucket bounds.
+ * Returns a pointer to the metric, else NULL on error. */
+#define metric_histogram(m,name,bounds,n)  \
+   metric_register(m, name, METRIC_HISTOGRAM, bounds, n)
+
+/* Record an observation of a value in a histogram. */
+static inline void metric_observe(Metric *metric, long long v)
+{
+   unsigned i;
+
+   for(i = 0; i < metric->buckets && v > metric->bound[i]; i++);
+   metric_fetchadd(&metric->bucket[i], 1);
+   metric_fetchadd(&metric->value, v);
+   metric_fetchadd(&metric->count, 1);
+}
+
+/* Map a metrics file, creating it, or attaching it read-only where
+ * `capacity` is zero. Not for direct use; see metrics_open() and
+ * metrics_attach().
+ * Returns 0 on success, else error code. */
+static inline int metrics_map(Metrics *m, const char *path,
+   unsigned capacity)
+{
+#ifdef _WIN32
+   LARGE_INTEGER size;
+#else
+   struct stat st;
+#endif
+   int ecode;
+
+   memset(m, 0, sizeof(*m));
+   m->size = sizeof(METRICS_HEADER) + (capacity * sizeof(Metric));
+
+#ifdef _WIN32
+   if(capacity) {
+      m->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+         FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+   } else m->file = CreateFileA(path, GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL, NULL);
+   if(m->file == INVALID_HANDLE_VALUE) return GetLastError();
+   if(capacity == 0) {
+      GetFileSizeEx(m->file, &size);
+      m->size = (size_t) size.QuadPart;
+   }
+   m->map = CreateFileMappingA(m->file, NULL, capacity ? PAGE_READWRITE :
+      PAGE_READONLY, (DWORD) ((unsigned long long) m->size >> 32),
+      (DWORD) m->size, NULL);
+   if(m->map == NULL) {
+      ecode = GetLastError();
+      CloseHandle(m->file);
+      return ecode;
+   }
+   m->hdr = (METRICS_HEADER *) MapViewOfFile(m->map, capacity ?
+      FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, m->size);
+   if(m->hdr == NULL) {
+      ecode = GetLastError();
+      CloseHandle(m->map);
+      CloseHandle(m->file);
+      return ecode;
+   }
+#else
+   if(capacity) m->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   else m->fd = open(path, O_RDONLY);
+   if(m->fd < 0) return errno;
+   /* a sized file reads as zeros, all values and slots are clear */
+   if(capacity) ecode = ftruncate(m->fd, (off_t) m->size) ? errno : 0;
+   else if(fstat(m->fd, &st)) ecode = errno;
+   else {
+      m->size = (size_t) st.st_size;
+      ecode = m->size < sizeof(METRICS_HEADER) ? EINVAL : 0;
+   }
+   if(ecode == 0) {
+      m->hdr = (METRICS_HEADER *) mmap(NULL, m->size, capacity ?
+         PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m->fd, 0);
+      if(m->hdr == (METRICS_HEADER *) MAP_FAILED) ecode = errno;
+   }
+   if(ecode) {
+      m->hdr = NULL;
+      close(m->fd);
+      return ecode;
+   }
+#endif
+
+   m->metric = (Metric *) (m->hdr + 1);
+
+   return mutex_init(&m->lock);
+}
+
+/* Unmap and close a metrics file. The file is retained.
+ * Returns 0 on success, else error code. */
+static inline int metrics_close(Metrics *m)
+{
+#ifdef _WIN32
+   UnmapViewOfFile(m->hdr);
+   CloseHandle(m->map);
+   CloseHandle(m->file);
+#else
+   munmap(m->hdr, m->size);
+   close(m->fd);
+#endif
+   m->hdr = NULL;
+
+   return mutex_free(&m->lock);
+}
+
+/* Create (or truncate) and map a metrics file, of `capacity` metrics,
+ * for registration and update of metrics.
+ * Returns 0 on success, else error code. */
+static inline int metrics_open(Metrics *m, const char *path,
+   unsigned capacity)
+{
+   int ecode;
+
+   if(capacity == 0) return EINVAL;
+   ecode = metrics_map(m, path, capacity);
+   if(ecode) return ecode;
+
+   m->hdr->version = METRICS_VERSION;
+   m->hdr->capacity = capacity;
+   memcpy(m->hdr->magic, METRICS_MAGIC, sizeof(m->hdr->magic));
+
+   return 0;
+}
+
+/* Attach (map read-only) an existing metrics file, for reading with
+ * metrics_dump(). Values are read as they are updated.
+ * Returns 0 on success, else error code. */
+static inline int metrics_attach(Metrics *m, const char *path)
+{
+   int ecode;
+
+   ecode = metrics_map(m, path, 0);
+   if(ecode) return ecode;
+
+   if(memcmp(m->hdr->magic, METRICS_MAGIC, sizeof(m->hdr->magic)) ||
+      m->hdr->version != METRICS_VERSION) {
+      metrics_close(m);
+      return EINVAL;
+   }
+
+   return 0;
+}
+
+/* Write all published metrics of a metrics file to `out`, in the
+ * Prometheus text exposition format (cumulative histogram buckets).
+ * Returns the number of metrics written. */
+static inline int metrics_dump(Metrics *m, FILE *out)
+{
+   static const char *types[] = { "", "counter", "gauge", "histogram" };
+   long long cumulative;
+   Metric *metric;
+   unsigned i, j, count, type;
+
+   /* published metrics, within the bounds of the mapping */
+   count = metric_acquire(&m->hdr->count);
+   if(count > (m->size - sizeof(METRICS_HEADER)) / sizeof(Metric))
+      count = (unsigned) ((m->size - sizeof(METRICS_HEADER)) / sizeof(Metric));
+   for(i = 0; i < count; i++) {
+      metric = &m->metric[i];
+      type = metric_acquire(&metric->type);
+      if(type < METRIC_COUNTER || type > METRIC_HISTOGRAM) continue;
+      fprintf(out, "# TYPE %.*s %s\n", METRIC_NAMELEN, metric->name,
+         types[type]);
+      if(type != METRIC_HISTOGRAM) {
+         fprintf(out, "%.*s %lld\n", METRIC_NAMELEN, metric->name,
+            (long long) metric_load(&metric->value));
+         continue;
+      }
+      for(cumulative = j = 0; j <= metric->buckets && j <= METRIC_BUCKETS;
+         j++) {
+         cumulative += metric_load(&metric->bucket[j]);
+         fprintf(out, "%.*s_bucket{le=\"", METRIC_NAMELEN, metric->name);
+         if(j < metric->buckets) fprintf(out, "%lld", metric->bound[j]);
+         else fprintf(out, "+Inf");
+         fprintf(out, "\"} %lld\n", cumulative);
+      }
+      fprintf(out, "%.*s_sum %lld\n", METRIC_NAMELEN, metric->name,
+         (long long) metric_load(&metric->value));
+      fprintf(out, "%.*s_count %lld\n", METRIC_NAMELEN, metric->name,
+         (long long) metric_load(&metric->count));
+   }
+
+   return (int) count;
+}
+
+
+#endif /* end _MP_METRICS_H_ */
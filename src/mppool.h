@@ -0,0 +1,726 @@
+/* ****************************************************************
+ * Multiplatform thread pool and structured task scope support.
+ *  - mppool.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a pool of worker threads, executing submitted
+ * tasks in FIFO order, built entirely on the multiplatform threading
+ * primitives of mpthread.h.
+ *
+ * A TaskScope groups tasks spawned onto a pool. Joining the scope waits
+ * for every task it spawned, returning the first error encountered.
+ * The first error also cancels the scope, such that sibling tasks which
+ * have not yet started are skipped, and running tasks may observe the
+ * CancelToken of the scope to stop early. While waiting, the joining
+ * thread helps execute queued tasks, so scopes may be safely nested
+ * within tasks running on the same pool.
+ *
+ * Running tasks obtain their CancelToken with task_token(); the token
+ * of the scope for scoped tasks, else the token of the pool. Cancelling
+ * a pool with pool_cancel() also cancels every scope of the pool.
+ *
+ * A pool may instead schedule tasks by priority lane and deadline, by
+ * calling pool_schedule() before any task is submitted. Lane 0 has the
+ * highest priority, and tasks within a lane are executed in order of
+ * earliest deadline first (EDF), as microseconds() time stamps. Tasks
+ * submitted without a deadline, with pool_submit() or scope_spawn(),
+ * are queued to lane 0 and are due on submission. To protect lower
+ * priority lanes from starvation, a non-empty lane not dispatched from
+ * within the starvation period of the pool takes precedence.
+ *
+ * A pool initialized with pool_init_elastic() scales its worker count
+ * between minimum and maximum bounds, driven by queue wait time (the
+ * time between submission and execution of a task). While no worker
+ * is idle and the average wait exceeds the growth threshold, a worker
+ * is added, at most once per growth threshold period. A worker idle
+ * for longer than the idle period retires, down to the minimum. The
+ * asymmetric signals (latency to grow, sustained idleness to shrink)
+ * provide hysteresis, avoiding oscillation under steady load.
+ *
+ * NOTES:
+ * - Support functions requiring a ThreadPool or TaskScope param,
+ *   SHALL be passed as pointers.
+ * - A function designed to run as a pool task SHALL be of format:
+ *     // If multiple arguments are required, use a struct.
+ *     int task_functionname(void *arg)
+ *     {
+ *        ... task routine ...
+ *        return 0;  // or non-zero error code
+ *     }
+ * - Every initialized TaskScope SHALL be joined with scope_join().
+ * - Tasks returning ECANCELED are considered cancelled, not failed.
+ * - task_token() is process-wide; tasks observe the token of their scope
+ *   (or pool) in every translation unit.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial ThreadPool and TaskScope implementation.
+ * Rev.2   2026-10-18
+ *   Replaced scope cancellation flag with CancelToken support.
+ *   Added pool_cancel() and task_token().
+ * Rev.3   2026-10-18
+ *   Added priority lane and earliest deadline first scheduling mode.
+ * Rev.4   2026-10-18
+ *   Added elastic pool mode, scaling workers on queue wait time.
+ * Rev.5   2026-10-18
+ *   The task token is now process-wide (ThreadShared storage).
+ *
+ * ****************************************************************/
+
+#ifndef _MP_POOL_H_
+#define _MP_POOL_H_  /* include guard */
+
+
+#include <stdlib.h>
+#include "mpcancel.h"
+#include "mpthread.h"
+#include "mptime.h"
+
+/* Pool task execution function datatype */
+typedef int (TaskFunc)(void *arg);
+
+/* Queued task, held in a pool's singly linked FIFO queue, or in the
+ * deadline ordered heap of a priority lane. */
+typedef struct _POOL_TASK {
+   TaskFunc *func;
+   void *arg;
+   struct _TaskScope *scope;
+   struct _POOL_TASK *next;
+   unsigned long seq;   /* submission order, breaking deadline ties */
+   long deadline;       /* microseconds() time stamp */
+   long queued;         /* microseconds() time stamp, elastic mode only */
+} POOL_TASK;
+
+/* A priority lane; a binary min-heap of tasks, ordered by deadline. */
+typedef struct _POOL_LANE {
+   POOL_TASK **heap;
+   int len, cap;
+   long served;         /* time stamp of last dispatch, or of non-empty */
+} POOL_LANE;
+
+/* A worker thread slot of a pool. */
+typedef struct _POOL_WORKER {
+   struct _ThreadPool *pool;
+   ThreadID tid;
+   int state;           /* 0 = unused, 1 = running, 2 = retired */
+} POOL_WORKER;
+
+/* A pool of worker threads. All pool state, including the state of
+ * any TaskScope spawning onto the pool, is guarded by `lock`.
+ * Completed task nodes are retained in `spare` for reuse. */
+typedef struct _ThreadPool {
+   Mutex lock;
+   Condition work;      /* signalled on task submission or shutdown */
+   POOL_TASK *head;     /* next task to execute */
+   POOL_TASK *tail;     /* last task submitted */
+   POOL_TASK *spare;    /* recycled task nodes */
+   POOL_LANE *lanes;    /* priority lanes, NULL in FIFO mode */
+   int nlanes;
+   long starve;         /* lane starvation period, in microseconds */
+   unsigned long seq;
+   POOL_WORKER *workers;
+   CancelToken cancel;  /* token of detached tasks */
+   int threads;         /* running workers */
+   int idle;            /* running workers waiting for tasks */
+   int min, max;        /* worker bounds, equal in fixed size mode */
+   long wait;           /* average queue wait, in microseconds */
+   long grow;           /* growth threshold, in microseconds */
+   long grown;          /* time stamp of last growth */
+   unsigned long idle_ms;  /* idle period before a worker retires */
+   int shutdown;
+} ThreadPool;
+
+/* Obtain the number of running workers of a pool. (NON-BLOCKING) */
+#define pool_threads(pool)  ( (pool)->threads )
+
+/* A group of tasks spawned onto a ThreadPool, joined as one. */
+typedef struct _TaskScope {
+   ThreadPool *pool;
+   Condition done;      /* signalled when pending reaches zero */
+   CancelToken cancel;  /* token of scoped tasks */
+   CancelCallback link; /* pool cancellation registration */
+   int pending;         /* tasks spawned but not yet completed */
+   int error;           /* first task error, excluding ECANCELED */
+} TaskScope;
+
+/* CancelToken of the task executing on the current thread, if any.
+ * Process-wide (ThreadShared), such that tasks of every translation unit
+ * observe the token; a TLS index on Windows (see cancel_tlsset()). */
+#ifdef __cplusplus
+extern "C" {
+#endif
+#ifdef _WIN32
+ThreadShared volatile LONG Task_token_mppool = 0;
+#else
+ThreadShared ThreadLocal CancelToken *Task_token_mppool = NULL;
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+/* Obtain the CancelToken of the task executing on the current thread.
+ * Returns pointer to token, else NULL if not executing a pool task.
+ * task_settoken() sets it, and is not for direct use. */
+#ifdef _WIN32
+#define task_token()  cancel_tlsget(&Task_token_mppool)
+#define task_settoken(token)  cancel_tlsset(&Task_token_mppool, token)
+#else
+#define task_token()  ( Task_token_mppool )
+#define task_settoken(token)  ( Task_token_mppool = (token) )
+#endif
+
+/* Execute a task removed from the queue of a pool, recording the
+ * result against the scope of the task, if any.
+ * The pool lock SHALL be held, and is released during execution. */
+static inline void pool_execute(ThreadPool *pool, POOL_TASK *task)
+{
+   CancelToken *token, *prev;
+   TaskScope *scope;
+   TaskFunc *func;
+   void *arg;
+   int ecode;
+
+   func = task->func;
+   arg = task->arg;
+   scope = task->scope;
+   token = scope ? &scope->cancel : &pool->cancel;
+   /* recycle task node */
+   task->next = pool->spare;
+   pool->spare = task;
+
+   mutex_unlock(&pool->lock);
+   /* tasks of a cancelled token are skipped */
+   if(cancel_requested(token))
+      ecode = ECANCELED;
+   else {
+      prev = task_token();
+      task_settoken(token);
+      ecode = func(arg);
+      task_settoken(prev);
+   }
+   /* any error cancels remaining tasks of the scope */
+   if(scope && ecode)
+      cancel_request(token);
+   mutex_lock(&pool->lock);
+
+   if(scope) {
+      if(ecode && ecode != ECANCELED && !scope->error)
+         scope->error = ecode;
+      if(--scope->pending == 0)
+         condition_broadcast(&scope->done);
+   }
+}
+
+/* Compare the order of two queued tasks, by deadline then submission.
+ * Deadline comparison is tolerant of time stamp wrap around.
+ * Returns non-zero if task `a` is due before task `b`. */
+#define pool_before(a,b)  ( (a)->deadline != (b)->deadline ? \
+   ((a)->deadline - (b)->deadline) < 0 : ((a)->seq - (b)->seq) > (~0UL >> 1) )
+
+/* Push a task onto the heap of a priority lane.
+ * The pool lock SHALL be held.
+ * Returns 0 on success, else ENOMEM. */
+static inline int pool_lanepush(POOL_LANE *lane, POOL_TASK *task)
+{
+   POOL_TASK **heap;
+   int i, parent;
+
+   if(lane->len == lane->cap) {
+      i = lane->cap ? lane->cap * 2 : 64;
+      heap = (POOL_TASK **) realloc(lane->heap, sizeof(POOL_TASK *) * i);
+      if(heap == NULL)
+         return ENOMEM;
+      lane->heap = heap;
+      lane->cap = i;
+   }
+   /* sift up */
+   for(i = lane->len++; i > 0; i = parent) {
+      parent = (i - 1) / 2;
+      if(!pool_before(task, lane->heap[parent])) break;
+      lane->heap[i] = lane->heap[parent];
+   }
+   lane->heap[i] = task;
+
+   return 0;
+}
+
+/* Pop the earliest deadline task from the heap of a priority lane.
+ * The pool lock SHALL be held, and the lane SHALL NOT be empty.
+ * Returns pointer to task. */
+static inline POOL_TASK *pool_lanepop(POOL_LANE *lane)
+{
+   POOL_TASK *task, *last;
+   int i, child;
+
+   task = lane->heap[0];
+   last = lane->heap[--lane->len];
+   /* sift down */
+   for(i = 0; (child = (i * 2) + 1) < lane->len; i = child) {
+      if(child + 1 < lane->len &&
+         pool_before(lane->heap[child + 1], lane->heap[child])) child++;
+      if(!pool_before(lane->heap[child], last)) break;
+      lane->heap[i] = lane->heap[child];
+   }
+   lane->heap[i] = last;
+
+   return task;
+}
+
+/* Remove the next task from the priority lanes of a pool. The highest
+ * priority non-empty lane is chosen, unless a lower priority lane has
+ * starved, in which case the longest starved lane is chosen.
+ * The pool lock SHALL be held.
+ * Returns pointer to task, else NULL if all lanes are empty. */
+static inline POOL_TASK *pool_lanedequeue(ThreadPool *pool)
+{
+   POOL_LANE *lane;
+   long now, wait, starved;
+   int i;
+
+   lane = NULL;
+   now = microseconds();
+   /* find the longest starved lane, if any */
+   for(starved = pool->starve, i = 1; i < pool->nlanes; i++) {
+      if(pool->lanes[i].len == 0) continue;
+      wait = now - pool->lanes[i].served;
+      if(wait > starved) {
+         lane = &pool->lanes[i];
+         starved = wait;
+      }
+   }
+   /* else find the highest priority non-empty lane */
+   for(i = 0; lane == NULL && i < pool->nlanes; i++) {
+      if(pool->lanes[i].len) lane = &pool->lanes[i];
+   }
+   if(lane == NULL)
+      return NULL;
+
+   lane->served = now;
+
+   return pool_lanepop(lane);
+}
+
+static inline Threaded pool_worker(void *arg);
+
+/* Add a worker thread to a pool, reusing the slot of a retired worker.
+ * The pool lock SHALL be held.
+ * Returns 0 on success, else error code. */
+static inline int pool_grow(ThreadPool *pool)
+{
+   POOL_WORKER *worker;
+   int i, ecode;
+
+   for(i = 0; i < pool->max; i++) {
+      worker = &pool->workers[i];
+      if(worker->state == 1) continue;
+      /* a retired worker no longer requires the pool lock */
+      if(worker->state == 2) thread_wait(&worker->tid);
+      worker->state = 0;
+      ecode = thread_create(&worker->tid, pool_worker, worker);
+      if(ecode) return ecode;
+      worker->state = 1;
+      pool->threads++;
+      pool->grown = microseconds();
+      return 0;
+   }
+
+   return EAGAIN;
+}
+
+/* Record a queue wait time sample of an elastic pool, adding a worker
+ * if warranted. The pool lock SHALL be held. */
+static inline void pool_sample(ThreadPool *pool, long wait)
+{
+   pool->wait += (wait - pool->wait) / 4;
+   if(pool->wait > pool->grow && pool->idle == 0 &&
+      pool->threads < pool->max && !pool->shutdown &&
+      (microseconds() - pool->grown) > pool->grow) pool_grow(pool);
+}
+
+/* Remove the next task from the queue of a pool.
+ * The pool lock SHALL be held.
+ * Returns pointer to task, else NULL if the queue is empty. */
+static inline POOL_TASK *pool_dequeue(ThreadPool *pool)
+{
+   POOL_TASK *task;
+
+   if(pool->lanes)
+      task = pool_lanedequeue(pool);
+   else {
+      task = pool->head;
+      if(task) {
+         pool->head = task->next;
+         if(pool->head == NULL)
+            pool->tail = NULL;
+      }
+   }
+   if(task && pool->max > pool->min)
+      pool_sample(pool, microseconds() - task->queued);
+
+   return task;
+}
+
+/* Worker thread function, executing pool tasks until shutdown, or, in
+ * elastic mode, until idle for the idle period of the pool.
+ * Tasks queued before shutdown are always executed. */
+static inline Threaded pool_worker(void *arg)
+{
+   POOL_WORKER *worker;
+   ThreadPool *pool;
+   POOL_TASK *task;
+   int timedout;
+
+   worker = (POOL_WORKER *) arg;
+   pool = worker->pool;
+   timedout = 0;
+
+   mutex_lock(&pool->lock);
+   for( ;; ) {
+      task = pool_dequeue(pool);
+      if(task) {
+         pool_execute(pool, task);
+         timedout = 0;
+         continue;
+      }
+      if(pool->shutdown) break;
+      if(pool->threads > pool->min) {
+         if(timedout) {
+            /* retire; joined by pool_grow() or pool_free() */
+            worker->state = 2;
+            pool->threads--;
+            break;
+         }
+         pool->idle++;
+         timedout = condition_timedwait(&pool->work, &pool->lock,
+            pool->idle_ms) == ETIMEDOUT;
+         pool->idle--;
+      } else {
+         pool->idle++;
+         condition_wait(&pool->work, &pool->lock);
+         pool->idle--;
+      }
+   }
+   mutex_unlock(&pool->lock);
+
+   return Treturn;
+}
+
+/* Queue a task for execution by a pool, on behalf of a scope (or NULL).
+ * Lane and deadline are ignored in FIFO mode, and a deadline of zero
+ * is replaced with the time of submission.
+ * Returns 0 on success, else error code. */
+static inline int pool_enqueue(ThreadPool *pool, TaskScope *scope,
+   int lane, long deadline, TaskFunc *func, void *arg)
+{
+   POOL_LANE *plane;
+   POOL_TASK *task;
+
+   mutex_lock(&pool->lock);
+   if(pool->shutdown) {
+      mutex_unlock(&pool->lock);
+      return EINVAL;
+   }
+   /* obtain task node, recycled if available */
+   task = pool->spare;
+   if(task) pool->spare = task->next;
+   else {
+      task = (POOL_TASK *) malloc(sizeof(POOL_TASK));
+      if(task == NULL) {
+         mutex_unlock(&pool->lock);
+         return ENOMEM;
+      }
+   }
+   task->func = func;
+   task->arg = arg;
+   task->scope = scope;
+   task->next = NULL;
+   task->seq = pool->seq++;
+   if(pool->max > pool->min) {
+      task->queued = microseconds();
+      /* with no idle worker, the oldest queued task is a wait sample */
+      if(pool->idle == 0 && pool->head)
+         pool_sample(pool, task->queued - pool->head->queued);
+   }
+   if(pool->lanes) {
+      /* push task to priority lane, clamped to lowest priority */
+      if(lane < 0) lane = 0;
+      if(lane >= pool->nlanes) lane = pool->nlanes - 1;
+      plane = &pool->lanes[lane];
+      task->deadline = deadline ? deadline : microseconds();
+      if(plane->len == 0)
+         plane->served = microseconds();
+      if(pool_lanepush(plane, task)) {
+         task->next = pool->spare;
+         pool->spare = task;
+         mutex_unlock(&pool->lock);
+         return ENOMEM;
+      }
+   } else {
+      /* append task to queue */
+      if(pool->tail) pool->tail->next = task;
+      else pool->head = task;
+      pool->tail = task;
+   }
+   if(scope) scope->pending++;
+   condition_signal(&pool->work);
+   mutex_unlock(&pool->lock);
+
+   return 0;
+}
+
+/* Submit a detached task for execution by a pool.
+ * The return value of a detached task is ignored.
+ * Returns 0 on success, else error code. */
+static inline int pool_submit(ThreadPool *pool, TaskFunc *func, void *arg)
+{
+   return pool_enqueue(pool, NULL, 0, 0, func, arg);
+}
+
+/* Submit a detached task for execution by a pool, to a priority lane
+ * with a deadline (as a microseconds() time stamp, or zero if due on
+ * submission). Lane and deadline are ignored in FIFO mode.
+ * Returns 0 on success, else error code. */
+static inline int pool_submit_at(ThreadPool *pool, int lane, long deadline,
+   TaskFunc *func, void *arg)
+{
+   return pool_enqueue(pool, NULL, lane, deadline, func, arg);
+}
+
+/* Switch a pool to priority lane and earliest deadline first scheduling,
+ * with `lanes` priority lanes (lane 0 the highest priority), and a lane
+ * starvation period of `starve_us` microseconds. SHALL be called before
+ * any task is submitted to the pool.
+ * Returns 0 on success, else error code. */
+static inline int
+pool_schedule(ThreadPool *pool, int lanes, unsigned long starve_us)
+{
+   POOL_LANE *plane;
+   int ecode;
+
+   if(lanes < 1)
+      return EINVAL;
+
+   ecode = 0;
+   mutex_lock(&pool->lock);
+   if(pool->lanes || pool->head) ecode = EINVAL;
+   else {
+      plane = (POOL_LANE *) calloc((size_t) lanes, sizeof(POOL_LANE));
+      if(plane == NULL) ecode = ENOMEM;
+      else {
+         pool->lanes = plane;
+         pool->nlanes = lanes;
+         pool->starve = (long) starve_us;
+      }
+   }
+   mutex_unlock(&pool->lock);
+
+   return ecode;
+}
+
+/* Shutdown a pool, executing all queued tasks and waiting for worker
+ * threads to complete, before releasing pool resources. (BLOCKING)
+ * Returns 0 on success, else the first thread_wait() error code. */
+static inline int pool_free(ThreadPool *pool)
+{
+   POOL_TASK *task;
+   int i, temp, ecode;
+
+   mutex_lock(&pool->lock);
+   pool->shutdown = 1;
+   condition_broadcast(&pool->work);
+   mutex_unlock(&pool->lock);
+
+   /* wait for running and retired workers */
+   for(ecode = i = 0; i < pool->max; i++) {
+      if(pool->workers[i].state == 0) continue;
+      temp = thread_wait(&pool->workers[i].tid);
+      if(temp && !ecode)
+         ecode = temp;
+      pool->workers[i].state = 0;
+   }
+
+   /* release recycled task nodes and priority lanes */
+   while((task = pool->spare)) {
+      pool->spare = task->next;
+      free(task);
+   }
+   for(i = 0; i < pool->nlanes; i++)
+      free(pool->lanes[i].heap);
+   free(pool->lanes);
+   pool->lanes = NULL;
+   pool->nlanes = 0;
+   cancel_free(&pool->cancel);
+   condition_free(&pool->work);
+   mutex_free(&pool->lock);
+   free(pool->workers);
+   pool->workers = NULL;
+   pool->threads = 0;
+
+   return ecode;
+}
+
+/* Initialize an elastic pool, creating `min` worker threads, scaling
+ * up to `max` worker threads while the average queue wait exceeds
+ * `grow_us` microseconds, and retiring workers idle for `idle_ms`
+ * milliseconds, down to `min` worker threads.
+ * Returns 0 on success, else error code. */
+static inline int pool_init_elastic(ThreadPool *pool, int min, int max,
+   unsigned long grow_us, unsigned long idle_ms)
+{
+   int i, ecode;
+
+   if(min < 1 || max < min)
+      return EINVAL;
+
+   pool->head = pool->tail = pool->spare = NULL;
+   pool->lanes = NULL;
+   pool->nlanes = 0;
+   pool->starve = 0;
+   pool->seq = 0;
+   pool->threads = pool->idle = pool->shutdown = 0;
+   pool->min = min;
+   pool->max = max;
+   pool->wait = 0;
+   pool->grow = (long) grow_us;
+   pool->grown = microseconds();
+   pool->idle_ms = idle_ms;
+   pool->workers = (POOL_WORKER *) calloc((size_t) max, sizeof(POOL_WORKER));
+   if(pool->workers == NULL)
+      return ENOMEM;
+   for(i = 0; i < max; i++)
+      pool->workers[i].pool = pool;
+
+   mutex_init(&pool->lock);
+   condition_init(&pool->work);
+   cancel_init(&pool->cancel);
+   mutex_lock(&pool->lock);
+   for(ecode = i = 0; i < min && ecode == 0; i++)
+      ecode = pool_grow(pool);
+   mutex_unlock(&pool->lock);
+
+   /* release partially created pool on failure */
+   if(ecode) {
+      pool_free(pool);
+      return ecode;
+   }
+
+   return 0;
+}
+
+/* Initialize a fixed size pool and create `threads` worker threads.
+ * Returns 0 on success, else error code. */
+#define pool_init(pool,threads)  pool_init_elastic(pool,threads,threads,0,0)
+
+/* Cancel a pool, such that queued tasks which have not yet started are
+ * skipped, and running tasks observe cancellation of their token. The
+ * pool remains usable until pool_free(), but all scopes (present and
+ * future) are cancelled. Always returns 0. */
+#define pool_cancel(pool)  cancel_request(&(pool)->cancel)
+
+/* Cancellation callback propagating pool cancellation to a scope. */
+static inline void scope_cancel_link(void *arg)
+{
+   cancel_request(&((TaskScope *) arg)->cancel);
+}
+
+/* Initialize a scope for spawning tasks onto a pool.
+ * Returns 0 on success, else error code. */
+static inline int scope_init(TaskScope *scope, ThreadPool *pool)
+{
+   int ecode;
+
+   scope->pool = pool;
+   scope->pending = 0;
+   scope->error = 0;
+
+   ecode = cancel_init(&scope->cancel);
+   if(ecode) return ecode;
+   ecode = condition_init(&scope->done);
+   if(ecode) {
+      cancel_free(&scope->cancel);
+      return ecode;
+   }
+   /* a scope of a cancelled pool begins cancelled */
+   if(cancel_register(&pool->cancel, &scope->link, scope_cancel_link, scope))
+      cancel_request(&scope->cancel);
+
+   return 0;
+}
+
+/* Spawn a task onto the pool of a scope. Tasks SHALL NOT be spawned
+ * onto a scope after it has been joined.
+ * Returns 0 on success, ECANCELED if the scope has been cancelled,
+ * else error code. */
+static inline int scope_spawn(TaskScope *scope, TaskFunc *func, void *arg)
+{
+   if(cancel_requested(&scope->cancel))
+      return ECANCELED;
+
+   return pool_enqueue(scope->pool, scope, 0, 0, func, arg);
+}
+
+/* Spawn a task onto the pool of a scope, to a priority lane with a
+ * deadline, as per pool_submit_at().
+ * Returns 0 on success, ECANCELED if the scope has been cancelled,
+ * else error code. */
+static inline int scope_spawn_at(TaskScope *scope, int lane, long deadline,
+   TaskFunc *func, void *arg)
+{
+   if(cancel_requested(&scope->cancel))
+      return ECANCELED;
+
+   return pool_enqueue(scope->pool, scope, lane, deadline, func, arg);
+}
+
+/* Cancel a scope, such that spawned tasks which have not yet started
+ * are skipped and further spawns are refused. Always returns 0. */
+#define scope_cancel(scope)     cancel_request(&(scope)->cancel)
+
+/* Check the cancellation state of a scope. (NON-BLOCKING)
+ * Returns non-zero if the scope has been cancelled. */
+#define scope_cancelled(scope)  cancel_requested(&(scope)->cancel)
+
+/* Wait for all tasks spawned by a scope to complete, helping execute
+ * queued pool tasks while waiting, and release scope resources.
+ * (BLOCKING) Returns 0 on success, else the first task error code, or
+ * ECANCELED if the scope was cancelled without error. */
+static inline int scope_join(TaskScope *scope)
+{
+   ThreadPool *pool;
+   POOL_TASK *task;
+   int ecode;
+
+   pool = scope->pool;
+
+   mutex_lock(&pool->lock);
+   while(scope->pending) {
+      task = pool_dequeue(pool);
+      if(task) pool_execute(pool, task);
+      else condition_wait(&scope->done, &pool->lock);
+   }
+   ecode = scope->error;
+   if(ecode == 0 && cancel_requested(&scope->cancel))
+      ecode = ECANCELED;
+   mutex_unlock(&pool->lock);
+
+   cancel_unregister(&pool->cancel, &scope->link);
+   cancel_free(&scope->cancel);
+   condition_free(&scope->done);
+
+   return ecode;
+}
+
+
+#endif /* end _MP_POOL_H_ */
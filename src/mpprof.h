@@ -0,0 +1,500 @@
+/* ****************************************************************
+ * In-process sampling profiler, with per-thread CPU time timers.
+ *  - mpprof.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a sampling profiler for processes that cannot be
+ * attached to by an external profiler (perf, etc.). Each profiled thread
+ * owns a POSIX timer on its own CPU time clock (CLOCK_THREAD_CPUTIME_ID),
+ * delivering SIGPROF to that thread alone at the sampling frequency, such
+ * that idle or blocked threads are never sampled. The signal handler
+ * captures a backtrace of the interrupted thread into a single-producer/
+ * single-consumer ring buffer owned by that thread; it never locks, nor
+ * allocates, and drops (counts) samples when the ring is full.
+ *
+ * Samples are collected from all thread rings, and aggregated by unique
+ * stack, by prof_collect(). The aggregate is written by prof_write() in
+ * the "folded stack" format, one stack per line, root frame first:
+ *   main;worker;compute 123
+ * suitable for flame graph tools (flamegraph.pl, inferno, speedscope).
+ *
+ * NOTES:
+ * - Support functions requiring a Profiler param, SHALL be passed as
+ *   pointers. A single Profiler may be active per process, as it owns
+ *   the SIGPROF signal disposition until freed; the active Profiler is
+ *   held in process-wide (ThreadShared) storage, such that the guard
+ *   holds across translation units.
+ * - prof_free() waits for signal handlers in flight to return before
+ *   freeing thread rings; handlers are counted in and out of the active
+ *   Profiler by a process-wide counter.
+ * - Threads are profiled from prof_register() until prof_unregister(),
+ *   or thread exit. Profiled threads are registered with the thread
+ *   registry (mpthread.h), and a thread ring is recycled by the next
+ *   thread assigned the same registry index.
+ * - Rings SHOULD be collected more often than PROF_SLOTS samples per
+ *   thread are taken, else samples are dropped.
+ * - Frames are named by dladdr() when _GNU_SOURCE is defined before
+ *   inclusion, else (or when unnamed) as "module+0xoffset", resolvable
+ *   offline with addr2line. Functions of the executable are only named
+ *   by dladdr() when linked with -rdynamic.
+ * - backtrace() is preloaded by prof_init(), as its first call may
+ *   allocate. Samples interrupting the dynamic loader (dlopen) may block
+ *   on the loader lock; profiling SHOULD start after libraries load.
+ * - CPU time timers expire on the scheduler tick, and expirations of a
+ *   frequency exceeding the tick rate are coalesced; each sample is
+ *   weighted by its timer overrun count, such that sample counts remain
+ *   proportional to CPU time.
+ * - Time spent in the signal handler is accumulated per thread, and
+ *   reported in `handler_ns`, to measure the cost of profiling.
+ * - Linux only; requires SIGEV_THREAD_ID thread directed timers.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial Profiler implementation.
+ * Rev.2   2026-10-18
+ *   The active Profiler is now process-wide (ThreadShared storage), and
+ *   prof_free() waits for signal handlers in flight before freeing rings.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_PROF_H_
+#define _MP_PROF_H_  /* include guard */
+
+
+#ifndef __linux__
+#error "mpprof.h requires Linux thread directed CPU time timers"
+#endif
+
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifdef _GNU_SOURCE
+#include <dlfcn.h>
+#endif
+
+#include "mpthread.h"
+#include "mptime.h"
+
+/* Number of samples held by each thread ring, SHALL be a power of 2.
+ * May be overridden by defining PROF_SLOTS before inclusion. */
+#ifndef PROF_SLOTS
+#define PROF_SLOTS  1024
+#endif
+
+/* Maximum frames captured per sample.
+ * May be overridden by defining PROF_DEPTH before inclusion. */
+#ifndef PROF_DEPTH
+#define PROF_DEPTH  32
+#endif
+
+#define PROF_SKIP     2    /* frames of the signal handler and trampoline */
+#define PROF_HZ       99   /* default sampling frequency, per CPU second */
+#define PROF_SYMLEN   128  /* maximum frame name length */
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id  _sigev_un._tid
+#endif
+
+/* Ring buffer index load/store, with acquire/release semantics. */
+#define prof_acquire(p)    __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define prof_release(p,v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+/* A captured sample; the backtrace of an interrupted thread, weighted
+ * by the number of timer expirations it represents. */
+typedef struct {
+   int depth;
+   int weight;
+   void *pc[PROF_DEPTH];
+} PROF_SAMPLE;
+
+/* A thread ring buffer. The head is owned by the collector, the tail and
+ * counters by the signal handler of the owning thread. */
+typedef struct {
+   unsigned head;
+   char pad1[60];
+   unsigned tail;
+   unsigned long dropped;
+   long long handler_ns;
+   char pad2[40];
+   timer_t timer;
+   int armed;
+   PROF_SAMPLE ring[PROF_SLOTS];
+} PROF_RING;
+
+/* An aggregated unique stack, frames held leaf first. */
+typedef struct {
+   unsigned long count;
+   unsigned hash;
+   int depth;
+   void *pc[PROF_DEPTH - PROF_SKIP];
+} PROF_STACK;
+
+/* A sampling profiler. Sample counters and the stack table are updated
+ * by prof_collect(), and may be read (under lock) by the caller. */
+typedef struct {
+   Mutex lock;
+   unsigned hz;
+   PROF_RING *rings[THREAD_REGISTRY_MAX];
+   int nrings;
+   PROF_STACK *stacks;  /* open addressed hash table of unique stacks */
+   unsigned nstacks;
+   unsigned cap;        /* capacity of the stack table, a power of 2 */
+   unsigned long samples, dropped;
+   long long handler_ns;
+   struct sigaction oldact;
+} Profiler;
+
+/* Process-wide profiler state; the active profiler of the process,
+ * targeted by the signal handler, and the count of handlers in flight. */
+#ifdef __cplusplus
+extern "C" {
+#endif
+ThreadShared Profiler *volatile Active_mpprof = NULL;
+ThreadShared volatile int Inflight_mpprof = 0;
+#ifdef __cplusplus
+}
+#endif
+
+/* SIGPROF handler, capturing the backtrace of the interrupted thread.
+ * Async-signal-safe, except as noted for backtrace(). */
+static inline void prof_handler(int sig, siginfo_t *info, void *uctx)
+{
+   Profiler *prof;
+   PROF_RING *ring;
+   long long start;
+   unsigned tail;
+   int idx, saved;
+
+   /* count in before loading the profiler, such that prof_free() either
+    * sees this handler in flight, or this handler sees no profiler */
+   __atomic_add_fetch(&Inflight_mpprof, 1, __ATOMIC_SEQ_CST);
+   prof = __atomic_load_n(&Active_mpprof, __ATOMIC_SEQ_CST);
+   idx = thread_index();
+   if(prof == NULL || idx < 0) goto out;
+   ring = prof->rings[idx];
+   if(ring == NULL || !prof_acquire(&ring->armed)) goto out;
+
+   saved = errno;
+   start = nanoseconds();
+   tail = ring->tail;
+   if(tail - prof_acquire(&ring->head) >= PROF_SLOTS) ring->dropped++;
+   else {
+      PROF_SAMPLE *s = &ring->ring[tail & (PROF_SLOTS - 1)];
+      s->depth = backtrace(s->pc, PROF_DEPTH);
+      s->weight = timer_getoverrun(ring->timer);
+      s->weight = s->weight > 0 ? s->weight + 1 : 1;
+      prof_release(&ring->tail, tail + 1);
+   }
+   ring->handler_ns += nanoelapsed(start);
+   errno = saved;
+
+out:
+   __atomic_sub_fetch(&Inflight_mpprof, 1, __ATOMIC_RELEASE);
+}
+
+/* FNV-1a hash of a stack of frames. */
+static inline unsigned prof_hash(void **pc, int depth)
+{
+   unsigned char *p = (unsigned char *) pc;
+   size_t i, len = (size_t) depth * sizeof(*pc);
+   unsigned hash = 2166136261u;
+
+   for(i = 0; i < len; i++) hash = (hash ^ p[i]) * 16777619u;
+
+   return hash;
+}
+
+/* Add `count` samples of a stack (leaf first) to the stack table,
+ * growing the table at half capacity. Caller holds the lock.
+ * Returns 0 on success, else error code. */
+static inline int prof_add(Profiler *prof, void **pc, int depth,
+   unsigned long count)
+{
+   PROF_STACK *st, *old;
+   unsigned i, hash, oldcap;
+
+   if(prof->nstacks >= prof->cap / 2) {
+      old = prof->stacks;
+      oldcap = prof->cap;
+      st = (PROF_STACK *) calloc(oldcap ? oldcap * 2 : 256, sizeof(*st));
+      if(st == NULL) return ENOMEM;
+      prof->stacks = st;
+      prof->cap = oldcap ? oldcap * 2 : 256;
+      prof->nstacks = 0;
+      for(i = 0; i < oldcap; i++) {
+         if(old[i].count) prof_add(prof, old[i].pc, old[i].depth, old[i].count);
+      }
+      free(old);
+   }
+   hash = prof_hash(pc, depth);
+   for(i = hash; ; i++) {
+      st = &prof->stacks[i & (prof->cap - 1)];
+      if(st->count == 0) {
+         st->hash = hash;
+         st->depth = depth;
+         memcpy(st->pc, pc, (size_t) depth * sizeof(*pc));
+         prof->nstacks++;
+         break;
+      }
+      if(st->hash == hash && st->depth == depth &&
+         memcmp(st->pc, pc, (size_t) depth * sizeof(*pc)) == 0) break;
+   }
+   st->count += count;
+
+   return 0;
+}
+
+/* Write the name of a frame, as a symbol name, else as "module+0xoffset",
+ * else as a raw address. Return addresses of caller frames are adjusted
+ * into their call instruction with `caller` != 0.
+ * Returns the length of the name written. */
+static inline int prof_symbol(void *pc, int caller, char *buf, size_t len)
+{
+#ifdef _GNU_SOURCE
+   const char *base;
+   Dl_info info;
+
+   if(dladdr((char *) pc - (caller != 0), &info)) {
+      if(info.dli_sname) return snprintf(buf, len, "%s", info.dli_sname);
+      if(info.dli_fname && info.dli_fname[0]) {
+         base = strrchr(info.dli_fname, '/');
+         base = base ? base + 1 : info.dli_fname;
+         return snprintf(buf, len, "%s+0x%lx", base,
+            (unsigned long) ((char *) pc - (char *) info.dli_fbase));
+      }
+   }
+#endif
+
+   return snprintf(buf, len, "%p", pc);
+}
+
+/* Initialize a Profiler, sampling profiled threads at `hz` samples per
+ * CPU second of each thread (0 selects PROF_HZ), and install its SIGPROF
+ * handler. Threads are not profiled until registered.
+ * Returns 0 on success, else error code. */
+static inline int prof_init(Profiler *prof, unsigned hz)
+{
+   struct sigaction act;
+   Profiler *active;
+   void *pc[PROF_SKIP];
+   int ecode;
+
+   if(Active_mpprof) return EBUSY;
+   memset(prof, 0, sizeof(*prof));
+   prof->hz = hz ? hz : PROF_HZ;
+   if(mutex_init(&prof->lock)) return EINVAL;
+
+   /* claim the process, before owning the SIGPROF disposition */
+   active = NULL;
+   if(!__atomic_compare_exchange_n(&Active_mpprof, &active, prof, 0,
+      __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+      mutex_free(&prof->lock);
+      return EBUSY;
+   }
+
+   /* preload the unwinder, as a first backtrace() may allocate */
+   backtrace(pc, PROF_SKIP);
+
+   memset(&act, 0, sizeof(act));
+   act.sa_sigaction = prof_handler;
+   act.sa_flags = SA_SIGINFO | SA_RESTART;
+   sigemptyset(&act.sa_mask);
+   if(sigaction(SIGPROF, &act, &prof->oldact)) {
+      ecode = errno;
+      __atomic_store_n(&Active_mpprof, NULL, __ATOMIC_SEQ_CST);
+      mutex_free(&prof->lock);
+      return ecode;
+   }
+
+   return 0;
+}
+
+/* Start profiling the current thread, creating and arming a timer on
+ * its CPU time clock, directed at the thread.
+ * Returns 0 on success, else error code. */
+static inline int prof_register(Profiler *prof)
+{
+   struct itimerspec its;
+   struct sigevent sev;
+   PROF_RING *ring;
+   long period;
+   int idx, ecode;
+
+   idx = thread_register();
+   if(idx < 0) return EAGAIN;
+
+   mutex_lock(&prof->lock);
+   ring = prof->rings[idx];
+   if(ring == NULL) {
+      ring = (PROF_RING *) calloc(1, sizeof(PROF_RING));
+      if(ring == NULL) {
+         mutex_unlock(&prof->lock);
+         return ENOMEM;
+      }
+      prof->rings[idx] = ring;
+      if(prof->nrings <= idx) prof->nrings = idx + 1;
+   } else if(ring->armed) {
+      /* timer of an exited thread, previously holding the index */
+      prof_release(&ring->armed, 0);
+      timer_delete(ring->timer);
+   }
+   mutex_unlock(&prof->lock);
+
+   memset(&sev, 0, sizeof(sev));
+   sev.sigev_notify = SIGEV_THREAD_ID;
+   sev.sigev_signo = SIGPROF;
+   sev.sigev_notify_thread_id = (pid_t) syscall(SYS_gettid);
+   if(timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &ring->timer))
+      return errno;
+   prof_release(&ring->armed, 1);
+
+   period = 1000000000L / (long) prof->hz;
+   its.it_interval.tv_sec = its.it_value.tv_sec = period / 1000000000L;
+   its.it_interval.tv_nsec = its.it_value.tv_nsec = period % 1000000000L;
+   if(timer_settime(ring->timer, 0, &its, NULL)) {
+      ecode = errno;
+      prof_release(&ring->armed, 0);
+      timer_delete(ring->timer);
+      return ecode;
+   }
+
+   return 0;
+}
+
+/* Stop profiling the current thread, deleting its timer. Samples already
+ * captured remain in the thread ring until collected.
+ * Returns 0 on success, else EINVAL if the thread is not profiled. */
+static inline int prof_unregister(Profiler *prof)
+{
+   PROF_RING *ring;
+   int idx;
+
+   idx = thread_index();
+   if(idx < 0 || (ring = prof->rings[idx]) == NULL || !ring->armed)
+      return EINVAL;
+
+   mutex_lock(&prof->lock);
+   prof_release(&ring->armed, 0);
+   timer_delete(ring->timer);
+   mutex_unlock(&prof->lock);
+
+   return 0;
+}
+
+/* Collect the samples of all thread rings into the stack table, and
+ * update the sample counters. (NON-BLOCKING for profiled threads)
+ * Returns 0 on success, else error code. */
+static inline int prof_collect(Profiler *prof)
+{
+   PROF_SAMPLE *s;
+   PROF_RING *ring;
+   unsigned head, tail;
+   int i, ecode;
+
+   ecode = 0;
+   mutex_lock(&prof->lock);
+   prof->dropped = 0;
+   prof->handler_ns = 0;
+   for(i = 0; i < prof->nrings; i++) {
+      ring = prof->rings[i];
+      if(ring == NULL) continue;
+      tail = prof_acquire(&ring->tail);
+      for(head = ring->head; head != tail && ecode == 0; head++) {
+         s = &ring->ring[head & (PROF_SLOTS - 1)];
+         if(s->depth <= PROF_SKIP) continue;
+         ecode = prof_add(prof, s->pc + PROF_SKIP, s->depth - PROF_SKIP,
+            (unsigned long) s->weight);
+         if(ecode == 0) prof->samples += (unsigned long) s->weight;
+      }
+      prof_release(&ring->head, head);
+      /* counters are read racily, but only ever increase */
+      prof->dropped += ring->dropped;
+      prof->handler_ns += ring->handler_ns;
+   }
+   mutex_unlock(&prof->lock);
+
+   return ecode;
+}
+
+/* Collect samples, and write all unique stacks in the folded stack
+ * format, root frame first, with their sample counts.
+ * Returns the number of stacks written, else -1 on error. */
+static inline long prof_write(Profiler *prof, FILE *out)
+{
+   char name[PROF_SYMLEN];
+   PROF_STACK *st;
+   unsigned i;
+   long count;
+   int j;
+
+   if(prof_collect(prof)) return -1;
+
+   mutex_lock(&prof->lock);
+   for(count = 0, i = 0; i < prof->cap; i++) {
+      st = &prof->stacks[i];
+      if(st->count == 0) continue;
+      for(j = st->depth - 1; j >= 0; j--) {
+         prof_symbol(st->pc[j], j > 0, name, sizeof(name));
+         fprintf(out, j ? "%s;" : "%s", name);
+      }
+      fprintf(out, " %lu\n", st->count);
+      count++;
+   }
+   mutex_unlock(&prof->lock);
+
+   return ferror(out) ? -1 : count;
+}
+
+/* Free a Profiler, deleting the timers of all profiled threads, and
+ * restoring the previous SIGPROF disposition. Rings are freed once no
+ * signal handler is in flight. Uncollected samples are discarded.
+ * Returns 0 on success, else error code. */
+static inline int prof_free(Profiler *prof)
+{
+   int i;
+
+   mutex_lock(&prof->lock);
+   for(i = 0; i < prof->nrings; i++) {
+      if(prof->rings[i] && prof->rings[i]->armed) {
+         prof_release(&prof->rings[i]->armed, 0);
+         timer_delete(prof->rings[i]->timer);
+      }
+   }
+   mutex_unlock(&prof->lock);
+
+   /* a pending signal is ignored, rather than killing the process */
+   signal(SIGPROF, SIG_IGN);
+   __atomic_store_n(&Active_mpprof, NULL, __ATOMIC_SEQ_CST);
+   /* handlers in flight may still hold the rings */
+   while(__atomic_load_n(&Inflight_mpprof, __ATOMIC_SEQ_CST)) spin_yield();
+   sigaction(SIGPROF, &prof->oldact, NULL);
+
+   for(i = 0; i < prof->nrings; i++) free(prof->rings[i]);
+   free(prof->stacks);
+   mutex_free(&prof->lock);
+   memset(prof, 0, sizeof(*prof));
+
+   return 0;
+}
+
+
+#endif /* end _MP_PROF_H_ */
@@ -0,0 +1,264 @@
+/* ****************************************************************
+ * Multiplatform lock-free rate support; sliding window counters and
+ * exponentially weighted moving average (EWMA) meters.
+ *  - mprate.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides event rates, incremented and queried from any
+ * thread without locks.
+ *
+ * A RateWindow counts events within a sliding window of time, as a ring
+ * of buckets of `width` milliseconds, keyed off milliseconds(). Each
+ * bucket is a single 64-bit word holding the epoch (the bucket's index
+ * in time, modulo 2^32) and count (32 bits) of the bucket, such that an
+ * increment is a single atomic addition, and a stale bucket (of a
+ * previous lap of the ring) is reset and incremented by a single
+ * compare-and-swap. Buckets of epochs outside of the window are ignored
+ * by queries, so idle periods require no maintenance.
+ *
+ * A Meter is an EWMA of an event rate, with time constant `tau`
+ * milliseconds. Marking an event is a single atomic addition to a
+ * pending count; decay is applied lazily, by whichever thread queries
+ * the rate, blending the rate of events pending since the previous decay
+ * with weight 1 - e^(-elapsed/tau). The result is independent of the
+ * frequency of queries.
+ *
+ * NOTES:
+ * - Support functions requiring a RateWindow or Meter param, SHALL be
+ *   passed as pointers.
+ * - A bucket SHALL NOT count more than 2^32 - 1 events.
+ * - The rate of a window is the count of the window divided by its span,
+ *   where the span is the full buckets plus the elapsed part of the
+ *   current bucket; a window younger than its span under-reports.
+ * - Meter events pending since the previous decay are assumed uniform
+ *   over the elapsed interval. A query racing the decay of another
+ *   thread returns the rate prior to that decay.
+ * - A Meter starts at a rate of 0, and converges over a few `tau`.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial RateWindow and Meter implementation.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_RATE_H_
+#define _MP_RATE_H_  /* include guard */
+
+
+#include <string.h>
+
+#include "mpthread.h"
+#include "mptime.h"
+
+/* Maximum buckets of a RateWindow.
+ * May be overridden by defining RATE_BUCKETS before inclusion. */
+#ifndef RATE_BUCKETS
+#define RATE_BUCKETS  64
+#endif
+
+/* Atomic 64-bit operations. Under MSVC, an interlocked compare exchange
+ * of equal values is an atomic load on 32-bit targets. */
+#ifdef _MSC_VER
+#define rate_fetchadd(p,v)  \
+   InterlockedExchangeAdd64((volatile LONG64 *) (p), (LONG64) (v))
+#define rate_exchange(p,v)  \
+   InterlockedExchange64((volatile LONG64 *) (p), (LONG64) (v))
+#define rate_cas(p,old,v)  ( InterlockedCompareExchange64( \
+   (volatile LONG64 *) (p), (LONG64) (v), (LONG64) (old)) == (LONG64) (old) )
+#define rate_load(p)  \
+   InterlockedCompareExchange64((volatile LONG64 *) (p), 0, 0)
+#define rate_store(p,v)  rate_exchange(p,v)
+#else
+#define rate_fetchadd(p,v)  __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+#define rate_exchange(p,v)  __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL)
+#define rate_cas(p,old,v)   __sync_bool_compare_and_swap(p, old, v)
+#define rate_load(p)        __atomic_load_n(p, __ATOMIC_RELAXED)
+#define rate_store(p,v)     __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#endif
+
+/* Bucket word epoch and count */
+#define rate_epoch(w)  ( (unsigned) ((w) >> 32) )
+#define rate_count32(w)  ( (unsigned) ((w) & 0xFFFFFFFFULL) )
+
+/* A sliding window event counter. */
+typedef struct {
+   volatile unsigned long long bucket[RATE_BUCKETS];
+   unsigned long width;       /* milliseconds per bucket */
+   unsigned buckets;
+} RateWindow;
+
+/* An EWMA event rate meter. */
+typedef struct {
+   volatile long long pending;   /* events since the last decay */
+   char pad[64 - sizeof(long long)];
+   volatile long long rate;      /* events per second, as double bits */
+   volatile long long last;      /* milliseconds() of the last decay */
+   volatile long busy;           /* decay in progress */
+   double tau;                   /* time constant, milliseconds */
+} Meter;
+
+/* Returns the epoch of the current bucket of a window. */
+#define rate_now(w)  \
+   ( (unsigned) ((unsigned long) milliseconds() / (w)->width) )
+
+/* Initialize a RateWindow of `buckets` buckets of `width` milliseconds,
+ * spanning `buckets * width` milliseconds.
+ * Returns 0 on success, else EINVAL for invalid buckets or width. */
+static inline int rate_init(RateWindow *w, int buckets, long width)
+{
+   unsigned long long stale;
+   unsigned i;
+
+   memset(w, 0, sizeof(*w));
+   if(buckets < 1 || buckets > RATE_BUCKETS || width < 1) return EINVAL;
+   w->buckets = (unsigned) buckets;
+   w->width = (unsigned long) width;
+   /* epoch of a full lap ago; every bucket is outside of the window */
+   stale = (unsigned long long) (rate_now(w) - w->buckets) << 32;
+   for(i = 0; i < w->buckets; i++) w->bucket[i] = stale;
+
+   return 0;
+}
+
+/* Count `n` events at the current time. Lock-free. */
+static inline void rate_add(RateWindow *w, unsigned n)
+{
+   volatile unsigned long long *p;
+   unsigned long long cur;
+   unsigned epoch;
+
+   epoch = rate_now(w);
+   p = &w->bucket[epoch % w->buckets];
+   cur = rate_fetchadd(p, (unsigned long long) n);
+   /* current bucket (or newer, where this thread was delayed) */
+   if((int) (rate_epoch(cur) - epoch) >= 0) return;
+
+   /* stale bucket; the addition is discarded by any reset, so reset it
+    * to this epoch and count, or add again once reset by another */
+   for( ; ; ) {
+      cur = rate_load(p);
+      if((int) (rate_epoch(cur) - epoch) >= 0) {
+         rate_fetchadd(p, (unsigned long long) n);
+         return;
+      }
+      if(rate_cas(p, cur, ((unsigned long long) epoch << 32) | n)) return;
+   }
+}
+
+/* Increment a RateWindow by 1. Lock-free. */
+#define rate_inc(w)  rate_add(w, 1)
+
+/* Obtain the count of events within the window. Lock-free.
+ * Returns count of events. */
+static inline unsigned long long rate_count(RateWindow *w)
+{
+   unsigned long long cur, sum;
+   unsigned epoch, i;
+
+   epoch = rate_now(w);
+   for(sum = 0, i = 0; i < w->buckets; i++) {
+      cur = rate_load(&w->bucket[i]);
+      if(epoch - rate_epoch(cur) < w->buckets) sum += rate_count32(cur);
+   }
+
+   return sum;
+}
+
+/* Obtain the rate of events within the window. Lock-free.
+ * Returns events per second. */
+static inline double rate_persecond(RateWindow *w)
+{
+   unsigned long now, span;
+   unsigned long long count;
+
+   now = (unsigned long) milliseconds();
+   count = rate_count(w);
+   span = (w->buckets - 1) * w->width + now % w->width + 1;
+
+   return (double) count * 1000.0 / (double) span;
+}
+
+/* Returns e^-x, for x >= 0, by halving into the range of a short Taylor
+ * series and squaring back (avoids linking the math library). */
+static inline double rate_expneg(double x)
+{
+   double y, term;
+   int k, i;
+
+   if(x > 700.0) return 0.0;
+   for(k = 0; x > 0.125; k++) x *= 0.5;
+   for(y = term = 1.0, i = 1; i < 8; i++) {
+      term *= -x / i;
+      y += term;
+   }
+   while(k--) y *= y;
+
+   return y;
+}
+
+/* Returns the double value of a Meter rate word. */
+static inline double meter_bits(long long bits)
+{
+   double rate;
+
+   memcpy(&rate, &bits, sizeof(rate));
+   return rate;
+}
+
+/* Initialize a Meter with time constant `tau` milliseconds (e.g. 1000
+ * for a rate of about the last second).
+ * Returns 0 on success, else EINVAL for an invalid time constant. */
+static inline int meter_init(Meter *m, long tau)
+{
+   /* a rate of all zero bits is 0.0 */
+   memset(m, 0, sizeof(*m));
+   if(tau < 1) return EINVAL;
+   m->tau = (double) tau;
+   m->last = milliseconds();
+
+   return 0;
+}
+
+/* Mark `n` events of a Meter. Lock-free. */
+#define meter_mark(m,n)  ( (void) rate_fetchadd(&(m)->pending, n) )
+
+/* Obtain the rate of a Meter, first applying decay for the time elapsed
+ * since the previous decay, unless another thread is doing so.
+ * Lock-free. Returns events per second. */
+static inline double meter_rate(Meter *m)
+{
+   long long count, bits, now, dt;
+   double rate, weight;
+
+   now = milliseconds();
+   if(now != rate_load(&m->last) && spin_xchg(&m->busy, 1) == 0) {
+      dt = now - m->last;
+      if(dt > 0) {
+         count = rate_exchange(&m->pending, 0);
+         rate = meter_bits(rate_load(&m->rate));
+         weight = 1.0 - rate_expneg((double) dt / m->tau);
+         rate += weight * ((double) count * 1000.0 / (double) dt - rate);
+         memcpy(&bits, &rate, sizeof(bits));
+         rate_store(&m->rate, bits);
+         rate_store(&m->last, now);
+      }
+      spin_release(&m->busy, 0);
+   }
+
+   return meter_bits(rate_load(&m->rate));
+}
+
+
+#endif /* end _MP_RATE_H_ */
@@ -0,0 +1,472 @@
+/* ****************************************************************
+ * Multiplatform statistics kernels for arrays of samples, vectorized
+ * with SSE2 and AVX2, selected at runtime.
+ *  - mpstats.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides the reductions of benchmark samples (min, max,
+ * mean and variance), each with a scalar, SSE2 and AVX2 kernel, and
+ * histogram binning. The widest kernel supported by both the compiler
+ * and the processor is selected on first use, by stats_level(), and may
+ * be lowered with stats_setlevel() (e.g. to compare kernels).
+ *
+ * stats_summary() computes min, max and sum in a single pass, and the
+ * variance in a second pass of squared deviations from the mean, which
+ * is numerically stable (unlike the sum of squares). stats_histogram()
+ * accumulates counts of uniform bins, from which stats_binpercentile()
+ * approximates a percentile without sorting; to about a bin width,
+ * where bins are densely populated and samples are within range.
+ * stats_percentile() selects an exact percentile in expected O(n).
+ *
+ * NOTES:
+ * - Samples SHALL NOT be NaN.
+ * - Vector kernels sum in a different order than the scalar kernel, and
+ *   so mean and variance may differ in the least significant bits; min,
+ *   max and histogram counts are identical at every level.
+ * - Histogram binning is scalar at every level; the cost of binning is
+ *   the scattered increment of counts, which vector kernels only add
+ *   lane extraction to (and per-lane sub-histograms add a merge to).
+ * - The variance is the sample variance (divisor n - 1), or 0 where
+ *   fewer than 2 samples are given.
+ * - Percentiles are in the range [0, 100], and are linearly
+ *   interpolated between the closest ranks.
+ * - AVX2 kernels are compiled with a target attribute (GCC, Clang) or
+ *   natively (MSVC), such that no compiler flags are required; SSE2
+ *   kernels require SSE2 at compile time (default on x86_64).
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial statistics kernel implementation.
+ * Rev.2   2026-10-18
+ *   Histogram binning is scalar at every kernel level.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_STATS_H_
+#define _MP_STATS_H_  /* include guard */
+
+
+#include <errno.h>
+#include <stddef.h>
+
+/* Kernel levels */
+#define STATS_SCALAR  0
+#define STATS_SSE2    1
+#define STATS_AVX2    2
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STATS_HAVE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#define STATS_HAVE_AVX2
+#define STATS_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__GNUC__)
+#define STATS_HAVE_AVX2
+#define STATS_TARGET_AVX2  __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+/* Summary statistics of an array of samples. */
+typedef struct {
+   size_t count;
+   double min, max;
+   double mean;
+   double variance;     /* sample variance */
+} Stats;
+
+/* Processor kernel level, and selected kernel level; -1 until first
+ * use. */
+static volatile int Cpu_mpstats = -1;
+static volatile int Level_mpstats = -1;
+
+/* Fold a sample into a running min, max and sum. */
+#define stats_fold(v,mn,mx,sum) \
+   do { \
+      if((v) < (mn)) (mn) = (v); \
+      if((v) > (mx)) (mx) = (v); \
+      (sum) += (v); \
+   } while(0)
+
+/* Compute the clamped bin index of a sample. */
+#define stats_bindex(v,lo,scale,top) \
+   stats_clamp(((v) - (lo)) * (scale), top)
+
+/* Clamp a bin position to [0, top], truncated to a bin index. */
+static inline int stats_clamp(double t, double top)
+{
+   if(t < 0.0) t = 0.0;
+   if(t > top) t = top;
+
+   return (int) t;
+}
+
+/****************************************************************/
+/* ---------------- Scalar kernels ---------------- */
+
+/* Fold `n` samples into a running min, max and sum. */
+static inline void stats_reduce_scalar(const double *x, size_t n,
+   double *min, double *max, double *sum)
+{
+   double mn = *min, mx = *max, s = *sum;
+   size_t i;
+
+   for(i = 0; i < n; i++) stats_fold(x[i], mn, mx, s);
+   *min = mn;
+   *max = mx;
+   *sum = s;
+}
+
+/* Returns the sum of squared deviations of `n` samples from `mean`. */
+static inline double stats_sqdev_scalar(const double *x, size_t n,
+   double mean)
+{
+   double d, s = 0.0;
+   size_t i;
+
+   for(i = 0; i < n; i++) {
+      d = x[i] - mean;
+      s += d * d;
+   }
+
+   return s;
+}
+
+/* Accumulate `n` samples into bins of `counts`. */
+static inline void stats_bin_scalar(const double *x, size_t n, double lo,
+   double scale, double top, size_t *counts)
+{
+   size_t i;
+
+   for(i = 0; i < n; i++) counts[stats_bindex(x[i], lo, scale, top)]++;
+}
+
+#ifdef STATS_HAVE_SSE2
+/****************************************************************/
+/* ---------------- SSE2 kernels ---------------- */
+
+static inline void stats_reduce_sse2(const double *x, size_t n,
+   double *min, double *max, double *sum)
+{
+   __m128d mn, mx, s0, s1, v0, v1;
+   double lane[2];
+   size_t i;
+
+   if(n < 4) {
+      stats_reduce_scalar(x, n, min, max, sum);
+      return;
+   }
+   mn = mx = _mm_loadu_pd(x);
+   s0 = s1 = _mm_setzero_pd();
+   for(i = 0; i + 4 <= n; i += 4) {
+      v0 = _mm_loadu_pd(x + i);
+      v1 = _mm_loadu_pd(x + i + 2);
+      mn = _mm_min_pd(mn, _mm_min_pd(v0, v1));
+      mx = _mm_max_pd(mx, _mm_max_pd(v0, v1));
+      s0 = _mm_add_pd(s0, v0);
+      s1 = _mm_add_pd(s1, v1);
+   }
+   _mm_storeu_pd(lane, mn);
+   if(lane[0] < *min) *min = lane[0];
+   if(lane[1] < *min) *min = lane[1];
+   _mm_storeu_pd(lane, mx);
+   if(lane[0] > *max) *max = lane[0];
+   if(lane[1] > *max) *max = lane[1];
+   _mm_storeu_pd(lane, _mm_add_pd(s0, s1));
+   *sum += lane[0] + lane[1];
+   stats_reduce_scalar(x + i, n - i, min, max, sum);
+}
+
+static inline double stats_sqdev_sse2(const double *x, size_t n,
+   double mean)
+{
+   __m128d m, d0, d1, s0, s1;
+   double lane[2];
+   size_t i;
+
+   m = _mm_set1_pd(mean);
+   s0 = s1 = _mm_setzero_pd();
+   for(i = 0; i + 4 <= n; i += 4) {
+      d0 = _mm_sub_pd(_mm_loadu_pd(x + i), m);
+      d1 = _mm_sub_pd(_mm_loadu_pd(x + i + 2), m);
+      s0 = _mm_add_pd(s0, _mm_mul_pd(d0, d0));
+      s1 = _mm_add_pd(s1, _mm_mul_pd(d1, d1));
+   }
+   _mm_storeu_pd(lane, _mm_add_pd(s0, s1));
+
+   return lane[0] + lane[1] + stats_sqdev_scalar(x + i, n - i, mean);
+}
+
+#endif
+
+#ifdef STATS_HAVE_AVX2
+/****************************************************************/
+/* ---------------- AVX2 kernels ---------------- */
+
+STATS_TARGET_AVX2
+static inline void stats_reduce_avx2(const double *x, size_t n,
+   double *min, double *max, double *sum)
+{
+   __m256d mn, mx, s0, s1, v0, v1;
+   double lane[4];
+   size_t i;
+   int j;
+
+   if(n < 8) {
+      stats_reduce_scalar(x, n, min, max, sum);
+      return;
+   }
+   mn = mx = _mm256_loadu_pd(x);
+   s0 = s1 = _mm256_setzero_pd();
+   for(i = 0; i + 8 <= n; i += 8) {
+      v0 = _mm256_loadu_pd(x + i);
+      v1 = _mm256_loadu_pd(x + i + 4);
+      mn = _mm256_min_pd(mn, _mm256_min_pd(v0, v1));
+      mx = _mm256_max_pd(mx, _mm256_max_pd(v0, v1));
+      s0 = _mm256_add_pd(s0, v0);
+      s1 = _mm256_add_pd(s1, v1);
+   }
+   _mm256_storeu_pd(lane, mn);
+   for(j = 0; j < 4; j++) if(lane[j] < *min) *min = lane[j];
+   _mm256_storeu_pd(lane, mx);
+   for(j = 0; j < 4; j++) if(lane[j] > *max) *max = lane[j];
+   _mm256_storeu_pd(lane, _mm256_add_pd(s0, s1));
+   *sum += (lane[0] + lane[1]) + (lane[2] + lane[3]);
+   stats_reduce_scalar(x + i, n - i, min, max, sum);
+}
+
+STATS_TARGET_AVX2
+static inline double stats_sqdev_avx2(const double *x, size_t n,
+   double mean)
+{
+   __m256d m, d0, d1, s0, s1;
+   double lane[4];
+   size_t i;
+
+   m = _mm256_set1_pd(mean);
+   s0 = s1 = _mm256_setzero_pd();
+   for(i = 0; i + 8 <= n; i += 8) {
+      d0 = _mm256_sub_pd(_mm256_loadu_pd(x + i), m);
+      d1 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), m);
+      s0 = _mm256_add_pd(s0, _mm256_mul_pd(d0, d0));
+      s1 = _mm256_add_pd(s1, _mm256_mul_pd(d1, d1));
+   }
+   _mm256_storeu_pd(lane, _mm256_add_pd(s0, s1));
+
+   return (lane[0] + lane[1]) + (lane[2] + lane[3]) +
+      stats_sqdev_scalar(x + i, n - i, mean);
+}
+
+#endif
+
+/****************************************************************/
+/* ---------------- Dispatch ---------------- */
+
+/* Detect the widest kernel level supported by the processor (and the
+ * operating system, for AVX2 register state).
+ * Returns kernel level. */
+static inline int stats_cpulevel(void)
+{
+#if defined(STATS_HAVE_AVX2) && defined(_MSC_VER)
+   int info[4];
+
+   __cpuid(info, 0);
+   if(info[0] >= 7) {
+      __cpuid(info, 1);
+      /* OSXSAVE and AVX, with XMM and YMM state enabled by the OS */
+      if((info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+         (_xgetbv(0) & 6) == 6) {
+         __cpuidex(info, 7, 0);
+         if(info[1] & (1 << 5)) return STATS_AVX2;
+      }
+   }
+   return STATS_SSE2;
+#elif defined(STATS_HAVE_AVX2)
+   __builtin_cpu_init();
+   if(__builtin_cpu_supports("avx2")) return STATS_AVX2;
+   return STATS_SSE2;
+#elif defined(STATS_HAVE_SSE2)
+   return STATS_SSE2;
+#else
+   return STATS_SCALAR;
+#endif
+}
+
+/* Obtain the selected kernel level, detecting the processor kernel
+ * level on first use.
+ * Returns kernel level. */
+static inline int stats_level(void)
+{
+   if(Level_mpstats < 0) {
+      if(Cpu_mpstats < 0) Cpu_mpstats = stats_cpulevel();
+      Level_mpstats = Cpu_mpstats;
+   }
+
+   return Level_mpstats;
+}
+
+/* Select a kernel `level`, limited to the processor kernel level.
+ * Returns the selected kernel level. */
+static inline int stats_setlevel(int level)
+{
+   if(Cpu_mpstats < 0) Cpu_mpstats = stats_cpulevel();
+   if(level > Cpu_mpstats) level = Cpu_mpstats;
+   if(level < STATS_SCALAR) level = STATS_SCALAR;
+   Level_mpstats = level;
+
+   return level;
+}
+
+/* Compute summary statistics of `n` samples at `x`, into `stats`.
+ * Where `n` is 0, every statistic is 0. */
+static inline void stats_summary(const double *x, size_t n, Stats *stats)
+{
+   double mn, mx, sum, sq;
+   int level;
+
+   stats->count = n;
+   stats->min = stats->max = stats->mean = stats->variance = 0.0;
+   if(n == 0) return;
+
+   level = stats_level();
+   mn = mx = x[0];
+   sum = 0.0;
+   switch(level) {
+#ifdef STATS_HAVE_AVX2
+      case STATS_AVX2: stats_reduce_avx2(x, n, &mn, &mx, &sum); break;
+#endif
+#ifdef STATS_HAVE_SSE2
+      case STATS_SSE2: stats_reduce_sse2(x, n, &mn, &mx, &sum); break;
+#endif
+      default: stats_reduce_scalar(x, n, &mn, &mx, &sum);
+   }
+   stats->min = mn;
+   stats->max = mx;
+   stats->mean = sum / (double) n;
+   if(n < 2) return;
+
+   switch(level) {
+#ifdef STATS_HAVE_AVX2
+      case STATS_AVX2: sq = stats_sqdev_avx2(x, n, stats->mean); break;
+#endif
+#ifdef STATS_HAVE_SSE2
+      case STATS_SSE2: sq = stats_sqdev_sse2(x, n, stats->mean); break;
+#endif
+      default: sq = stats_sqdev_scalar(x, n, stats->mean);
+   }
+   stats->variance = sq / (double) (n - 1);
+}
+
+/* Accumulate `n` samples at `x` into `counts` of `bins` uniform bins,
+ * over the range [lo, hi). Samples outside of the range are counted in
+ * the first or last bin. `counts` is NOT cleared beforehand.
+ * Returns 0 on success, else EINVAL for an invalid range or bins. */
+static inline int stats_histogram(const double *x, size_t n, double lo,
+   double hi, size_t *counts, int bins)
+{
+   double scale, top;
+
+   if(bins < 1 || !(hi > lo)) return EINVAL;
+   scale = (double) bins / (hi - lo);
+   top = (double) (bins - 1);
+   stats_bin_scalar(x, n, lo, scale, top, counts);
+
+   return 0;
+}
+
+/* Approximate the percentile `p` of the samples of `counts` of `bins`
+ * uniform bins over [lo, hi), assuming samples are uniform within bins.
+ * Returns percentile, or `lo` if no samples are counted. */
+static inline double stats_binpercentile(const size_t *counts, int bins,
+   double lo, double hi, double p)
+{
+   double rank, width, below;
+   size_t total;
+   int i;
+
+   for(total = 0, i = 0; i < bins; i++) total += counts[i];
+   if(total == 0) return lo;
+   if(p < 0.0) p = 0.0;
+   if(p > 100.0) p = 100.0;
+   rank = p / 100.0 * (double) total;
+   width = (hi - lo) / (double) bins;
+   for(below = 0.0, i = 0; i < bins - 1; i++) {
+      if(below + (double) counts[i] >= rank && counts[i]) break;
+      below += (double) counts[i];
+   }
+   if(counts[i] == 0) return lo + width * (double) i;
+
+   return lo + width * ((double) i + (rank - below) / (double) counts[i]);
+}
+
+/* Select the k-th smallest of `n` samples at `x`, partially reordering
+ * the samples, such that x[k] is the k-th smallest, and samples before
+ * (after) it are no greater (no less). Returns x[k]. */
+static inline double stats_select(double *x, size_t n, size_t k)
+{
+   ptrdiff_t lo, hi, i, j, kk = (ptrdiff_t) k;
+   double pivot, temp;
+
+   for(lo = 0, hi = (ptrdiff_t) n - 1; lo < hi; ) {
+      /* median of three pivot, Hoare partition */
+      i = lo + (hi - lo) / 2;
+      if(x[i] < x[lo]) { temp = x[i]; x[i] = x[lo]; x[lo] = temp; }
+      if(x[hi] < x[lo]) { temp = x[hi]; x[hi] = x[lo]; x[lo] = temp; }
+      if(x[hi] < x[i]) { temp = x[hi]; x[hi] = x[i]; x[i] = temp; }
+      pivot = x[i];
+      for(i = lo, j = hi; i <= j; ) {
+         while(x[i] < pivot) i++;
+         while(x[j] > pivot) j--;
+         if(i <= j) {
+            temp = x[i];
+            x[i++] = x[j];
+            x[j--] = temp;
+         }
+      }
+      /* [lo, j] <= pivot, (j, i) == pivot, [i, hi] >= pivot */
+      if(kk <= j) hi = j;
+      else if(kk >= i) lo = i;
+      else break;
+   }
+
+   return x[k];
+}
+
+/* Select the exact percentile `p` of `n` samples at `x`, partially
+ * reordering the samples. Returns percentile, or 0 if `n` is 0. */
+static inline double stats_percentile(double *x, size_t n, double p)
+{
+   double rank, frac, a, b;
+   size_t k, i;
+
+   if(n == 0) return 0.0;
+   if(p < 0.0) p = 0.0;
+   if(p > 100.0) p = 100.0;
+   rank = p / 100.0 * (double) (n - 1);
+   k = (size_t) rank;
+   frac = rank - (double) k;
+   a = stats_select(x, n, k);
+   if(frac == 0.0 || k + 1 >= n) return a;
+   /* the next rank is the least of the samples after x[k] */
+   for(b = x[k + 1], i = k + 2; i < n; i++) if(x[i] < b) b = x[i];
+
+   return a + (b - a) * frac;
+}
+
+
+#endif /* end _MP_STATS_H_ */
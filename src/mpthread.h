@@ -27,7 +27,21 @@
  * - Support functions requiring a ThreadID, Mutex or RWLock param,
  *   SHALL be passed as pointers.
  * - A Mutex can be statically initialized using MUTEX_INITIALIZER,
- *   RWLock can be statically initialized using RWLOCK_INITIALIZER.
+ *   RWLock can be statically initialized using RWLOCK_INITIALIZER,
+ *   Spinlock can be statically initialized using SPINLOCK_INITIALIZER.
+ * - A Spinlock never sleeps, yielding the processor only after spinning
+ *   for some time, and SHOULD only guard short critical sections.
+ * - A Condition SHALL be initialized using condition_init(), as timed
+ *   waits are measured against a monotonic clock where available.
+ * - Registry state (thread_register() and friends) is process-wide,
+ *   held in ThreadShared storage; weak symbols (GCC/Clang), or
+ *   selectany data (MSVC), defined by every translation unit and merged
+ *   by the linker, such that thread indexes are unique per process.
+ * - A ThreadReserve holds pre-spawned threads, parked until handed a
+ *   function by reserve_spawn(), avoiding thread creation (and stack
+ *   allocation) on the latency critical path. A spawned function SHALL
+ *   be waited on with reserve_wait(), which returns its thread to the
+ *   reserve, rather than with thread_wait().
  * - A function designed to run in a new thread SHALL be of format:
  *     // If multiple arguments are required, use a struct.
  *     Threaded thread_functionname(void *arg)
@@ -48,6 +62,18 @@
  * Rev.4   2020-05-31
  *   File overhaul and conversion to header file.
  *   Changed functions to MACRO redefinitions where appropriate.
+ * Rev.5   2026-10-18
+ *   Added thread registry for dense, recyclable thread indexes.
+ *   Added thread_self() and ThreadLocal storage class redefinitions.
+ *   Added Condition variables with millisecond timed wait support.
+ * Rev.6   2026-10-18
+ *   Added processor count and thread affinity (CPU pinning) support.
+ *   Added thread creation with stack size, and ThreadReserve of parked,
+ *   pre-spawned threads.
+ *   Added Spinlock for short critical sections.
+ * Rev.7   2026-10-18
+ *   Thread registry state is now process-wide (ThreadShared storage),
+ *   rather than local to each translation unit.
  *
  * ****************************************************************/
 
@@ -61,9 +87,15 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <errno.h>
+#include <stdlib.h>
 
 /* Windows function redefinitions */
 #define rwlock_free()  0  /* SRWLock need not be explicitly destroyed */
+#define condition_free(cnd)       0  /* CONDITION_VARIABLE, likewise */
+#define condition_signal(cnd)     ( WakeConditionVariable(cnd), 0 )
+#define condition_broadcast(cnd)  ( WakeAllConditionVariable(cnd), 0 )
+#define thread_self()  GetCurrentThreadId()
 
 /* Windows static initializers */
 #define MUTEX_INITIALIZER   {0}
@@ -74,6 +106,14 @@
 #define Threaded  DWORD    /* thread execution function datatype */
 #define Treturn   0        /* thread function return value */
 #define RWLock    SRWLOCK  /* shared read / exclusive write lock */
+#define Condition  CONDITION_VARIABLE  /* condition variable */
+
+/* Windows storage class for thread local variables */
+#define ThreadLocal  __declspec(thread)
+
+/* Windows storage class for process-wide variables, defined (with an
+ * initializer) in every translation unit and merged by the linker */
+#define ThreadShared  __declspec(selectany)
 
 /* A Mutually exclusive lock datatype, utilizing Windows' CRITICAL_SECTION
  * to more closely imitate pthread's pthread_mutex_t element. Since there
@@ -97,6 +137,19 @@ thread_create(ThreadID *threadid, LPTHREAD_START_ROUTINE func, void *arg)
    return 0;
 }
 
+/* Create a new thread on Windows with a `stacksize` byte stack reservation
+ * (0 for the default), and store it's thread identifier.
+ * Return 0 on success, else GetLastError(). */
+static inline int thread_create_stack(ThreadID *threadid,
+   LPTHREAD_START_ROUTINE func, void *arg, size_t stacksize)
+{
+   if(CreateThread(NULL, stacksize, func, arg,
+      STACK_SIZE_PARAM_IS_A_RESERVATION, threadid) == NULL)
+      return GetLastError();
+
+   return 0;
+}
+
 /* Wait for a thread on Windows to complete. (BLOCKING)
  * Returns 0 on success, else GetLastError(). */
 static inline int thread_wait(ThreadID *threadid)
@@ -195,6 +248,59 @@ static inline int rwlock_rdunlock(RWLock *rwlock)
 static inline int rwlock_wrunlock(RWLock *rwlock)
 { ReleaseSRWLockExclusive(rwlock); return 0; }
 
+/* Initialize a Condition variable on Windows.
+ * Always returns 0 on Windows. */
+static inline int condition_init(Condition *cond)
+{ InitializeConditionVariable(cond); return 0; }
+
+/* Wait on a Condition variable, for at most `ms` milliseconds, on
+ * Windows. The Mutex SHALL be locked by the calling thread. (BLOCKING)
+ * Returns 0 on success, ETIMEDOUT on timeout, else GetLastError(). */
+static inline int
+condition_timedwait(Condition *cond, Mutex *mutex, unsigned long ms)
+{
+   if(SleepConditionVariableCS(cond, &mutex->lock, (DWORD) ms))
+      return 0;
+   if(GetLastError() == ERROR_TIMEOUT)
+      return ETIMEDOUT;
+
+   return GetLastError();
+}
+
+/* Wait on a Condition variable on Windows. (BLOCKING)
+ * Returns 0 on success, else GetLastError(). */
+static inline int condition_wait(Condition *cond, Mutex *mutex)
+{ return condition_timedwait(cond, mutex, INFINITE); }
+
+/* Obtain the number of logical processors on Windows.
+ * Returns the number of processors (of the current processor group). */
+static inline int thread_cpucount(void)
+{
+   SYSTEM_INFO info;
+
+   GetSystemInfo(&info);
+
+   return (int) info.dwNumberOfProcessors;
+}
+
+/* Pin the calling thread to a single processor on Windows, or allow it
+ * all processors of the process with a negative `cpu`.
+ * Returns 0 on success, EINVAL for an unsupported cpu, else GetLastError(). */
+static inline int thread_setaffinity(int cpu)
+{
+   DWORD_PTR mask, sysmask;
+
+   if(cpu >= (int) (sizeof(mask) * 8))
+      return EINVAL;
+   if(cpu >= 0) mask = (DWORD_PTR) 1 << cpu;
+   else if(!GetProcessAffinityMask(GetCurrentProcess(), &mask, &sysmask))
+      return GetLastError();
+   if(SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+      return GetLastError();
+
+   return 0;
+}
+
 
 #else /* end Windows */
 /*********************/
@@ -203,11 +309,25 @@ static inline int rwlock_wrunlock(RWLock *rwlock)
 /* ---------------- POSIX ---------------- */
 
 #include <pthread.h>
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+/* Maximum processors addressable by thread_setaffinity() */
+#define THREAD_CPUMAX  1024
 
 /* POSIX function redefinitions... */
    /* ... threading functions, return 0 on success else error code. */
 #define thread_create(tid,func,arg)  pthread_create(tid,NULL,func,arg)
 #define thread_wait(tid)             pthread_join(*(tid),NULL)  /* BLOCKING */
+#define thread_self()                pthread_self()
    /* ... mutex lock functions, return 0 on success else error code. */
 #define mutex_init(m)    pthread_mutex_init(m,NULL)
 #define mutex_lock(m)    pthread_mutex_lock(m)  /* BLOCKING */
@@ -220,6 +340,11 @@ static inline int rwlock_wrunlock(RWLock *rwlock)
 #define rwlock_rdunlock(rwl)  pthread_rwlock_unlock(rwl)
 #define rwlock_wrunlock(rwl)  pthread_rwlock_unlock(rwl)
 #define rwlock_free(rwl)      pthread_rwlock_destroy(rwl)
+   /* ... condition functions, return 0 on success else error code. */
+#define condition_wait(cnd,m)     pthread_cond_wait(cnd,m)  /* BLOCKING */
+#define condition_signal(cnd)     pthread_cond_signal(cnd)
+#define condition_broadcast(cnd)  pthread_cond_broadcast(cnd)
+#define condition_free(cnd)       pthread_cond_destroy(cnd)
 
 /* POSIX static initializers */
 #define MUTEX_INITIALIZER   PTHREAD_MUTEX_INITIALIZER
@@ -231,6 +356,118 @@ static inline int rwlock_wrunlock(RWLock *rwlock)
 #define Treturn   NULL              /* thread function return value */
 #define Mutex     pthread_mutex_t   /* mutually exclusive lock */
 #define RWLock    pthread_rwlock_t  /* shared read / exclusive write lock */
+#define Condition  pthread_cond_t   /* condition variable */
+
+/* POSIX storage class for thread local variables */
+#define ThreadLocal  __thread
+
+/* POSIX storage class for process-wide variables, defined (with an
+ * initializer) in every translation unit and merged by the linker */
+#define ThreadShared  __attribute__((weak))
+
+/* Initialize a Condition variable, measuring timed waits against
+ * the monotonic clock where available.
+ * Returns 0 on success, else error code. */
+static inline int condition_init(Condition *cond)
+{
+   pthread_condattr_t attr;
+   int ecode;
+
+   ecode = pthread_condattr_init(&attr);
+   if(ecode) return ecode;
+#ifdef CLOCK_MONOTONIC
+   pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+   ecode = pthread_cond_init(cond, &attr);
+   pthread_condattr_destroy(&attr);
+
+   return ecode;
+}
+
+/* Wait on a Condition variable for at most `ms` milliseconds.
+ * The Mutex SHALL be locked by the calling thread. (BLOCKING)
+ * Returns 0 on success, ETIMEDOUT on timeout, else error code. */
+static inline int
+condition_timedwait(Condition *cond, Mutex *mutex, unsigned long ms)
+{
+   struct timespec ts;
+
+   /* obtain current time of the clock used by condition_init() */
+#ifdef CLOCK_MONOTONIC
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+   clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+   /* derive absolute time from relative milliseconds */
+   ts.tv_sec += (time_t) (ms / 1000);
+   ts.tv_nsec += (long) (ms % 1000) * 1000000L;
+   if(ts.tv_nsec >= 1000000000L) {
+      ts.tv_nsec -= 1000000000L;
+      ts.tv_sec++;
+   }
+
+   return pthread_cond_timedwait(cond, mutex, &ts);
+}
+
+/* Create a new thread with a `stacksize` byte stack (0 for the default),
+ * rounded up to the system minimum and page size.
+ * Returns 0 on success, else error code. */
+static inline int thread_create_stack(ThreadID *threadid,
+   void *(*func)(void *), void *arg, size_t stacksize)
+{
+   pthread_attr_t attr;
+   size_t page;
+   int ecode;
+
+   if(stacksize == 0)
+      return pthread_create(threadid, NULL, func, arg);
+
+   page = (size_t) sysconf(_SC_PAGESIZE);
+   if(stacksize < (size_t) PTHREAD_STACK_MIN)
+      stacksize = (size_t) PTHREAD_STACK_MIN;
+   stacksize = (stacksize + page - 1) / page * page;
+   ecode = pthread_attr_init(&attr);
+   if(ecode) return ecode;
+   ecode = pthread_attr_setstacksize(&attr, stacksize);
+   if(ecode == 0) ecode = pthread_create(threadid, &attr, func, arg);
+   pthread_attr_destroy(&attr);
+
+   return ecode;
+}
+
+/* Obtain the number of online processors.
+ * Returns the number of processors, at least 1. */
+static inline int thread_cpucount(void)
+{
+   long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+   return n > 0 ? (int) n : 1;
+}
+
+/* Pin the calling thread to a single processor, or allow it all
+ * processors with a negative `cpu`. The raw system call is used, as the
+ * cpu_set_t interface requires _GNU_SOURCE.
+ * Returns 0 on success, ENOTSUP where unsupported, else error code. */
+static inline int thread_setaffinity(int cpu)
+{
+#ifdef __linux__
+   unsigned long mask[THREAD_CPUMAX / (8 * sizeof(unsigned long))];
+   size_t i, bits = 8 * sizeof(unsigned long);
+
+   if(cpu >= THREAD_CPUMAX)
+      return EINVAL;
+   for(i = 0; i < sizeof(mask) / sizeof(*mask); i++)
+      mask[i] = cpu < 0 ? ~0UL : 0;
+   if(cpu >= 0) mask[cpu / bits] = 1UL << (cpu % bits);
+   if(syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask))
+      return errno;
+
+   return 0;
+#else
+   /* other POSIX systems offer scheduling hints, at best */
+   return ENOTSUP;
+#endif
+}
 
 
 #endif /* end POSIX */
@@ -239,6 +476,82 @@ static inline int rwlock_wrunlock(RWLock *rwlock)
 /**********************************************************/
 /* ---------------- Platform independant ---------------- */
 
+/* Spinlock atomic exchange (acquire), store (release), and spin hints */
+#ifdef _MSC_VER
+#define spin_xchg(p,v)     InterlockedExchange(p,v)
+#define spin_release(p,v)  ( _ReadWriteBarrier(), *(p) = (v) )
+#define spin_pause()       YieldProcessor()
+#define spin_yield()       SwitchToThread()
+#else
+#define spin_xchg(p,v)     __atomic_exchange_n(p, v, __ATOMIC_ACQUIRE)
+#define spin_release(p,v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#if defined(__x86_64__) || defined(__i386__)
+#define spin_pause()       __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define spin_pause()       __asm__ __volatile__("yield")
+#else
+#define spin_pause()       ((void) 0)
+#endif
+#ifdef _WIN32
+#define spin_yield()       SwitchToThread()
+#else
+#define spin_yield()       sched_yield()
+#endif
+#endif
+
+/* Spins (pause hints) before a waiting Spinlock yields the processor */
+#define SPINLOCK_SPINS  64
+
+/* Spinlock static initializer */
+#define SPINLOCK_INITIALIZER  {0}
+
+/* A spin lock; a single word, acquired by atomic exchange. */
+typedef struct _Spinlock {
+   volatile long lock;
+} Spinlock;
+
+/* Initialize a Spinlock. Always returns 0. */
+static inline int spinlock_init(Spinlock *spin)
+{
+   spin->lock = 0;
+
+   return 0;
+}
+
+/* Acquire an exclusive Spinlock, spinning until available. (BLOCKING)
+ * Waits read the lock word before exchanging, to avoid cache line
+ * ping-pong between waiters. Always returns 0. */
+static inline int spinlock_lock(Spinlock *spin)
+{
+   int spins;
+
+   while(spin_xchg(&spin->lock, 1)) {
+      for(spins = 0; spin->lock; spins++) {
+         if(spins < SPINLOCK_SPINS) spin_pause();
+         else {
+            spin_yield();
+            spins = 0;
+         }
+      }
+   }
+
+   return 0;
+}
+
+/* Release an exclusive Spinlock. Always returns 0. */
+static inline int spinlock_unlock(Spinlock *spin)
+{
+   spin_release(&spin->lock, 0);
+
+   return 0;
+}
+
+/* Uninitialize a Spinlock. Always returns 0. */
+#define spinlock_free(spin)  0
+
+/* Thread execution function datatype, for functions run by reference */
+typedef Threaded (ThreadFunc)(void *arg);
+
 /* Thread structure containing a thread id, argument pointer and "done"
  * flag. Intended for obtaining thread state without performing a
  * blocking thread_wait() call. */
@@ -265,5 +578,317 @@ static inline int thread_multiwait(ThreadID *tidlist, int len)
    return ecode;
 }
 
+/* Maximum number of threads simultaneously held by the thread registry.
+ * May be overridden by defining THREAD_REGISTRY_MAX before inclusion. */
+#ifndef THREAD_REGISTRY_MAX
+#define THREAD_REGISTRY_MAX  256
+#endif
+
+/* Thread registry state. Registered threads are assigned the lowest
+ * available index, which is recycled on unregister or thread exit.
+ * The thread local index is stored as (index + 1), 0 = unregistered.
+ * State is process-wide (ThreadShared), such that every translation unit
+ * shares one registry; C linkage merges C and C++ translation units. */
+#ifdef __cplusplus
+extern "C" {
+#endif
+ThreadShared Mutex Registry_mpthread = MUTEX_INITIALIZER;
+ThreadShared ThreadID Registry_tid_mpthread[THREAD_REGISTRY_MAX] = {0};
+ThreadShared unsigned char Registry_live_mpthread[THREAD_REGISTRY_MAX] = {0};
+ThreadShared volatile unsigned char Registry_keyinit_mpthread = 0;
+#ifdef _WIN32
+/* the thread local index is held by fiber local storage, as thread local
+ * storage cannot be merged across translation units */
+ThreadShared DWORD Registry_key_mpthread = 0;
+#else
+ThreadShared ThreadLocal int Registry_idx_mpthread = 0;
+ThreadShared pthread_key_t Registry_key_mpthread = 0;
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+/* Obtain the registered (index + 1) of the current thread, 0 = none. */
+#ifdef _WIN32
+#define thread_registry_idx()  ( Registry_keyinit_mpthread ? \
+   (int) (size_t) FlsGetValue(Registry_key_mpthread) : 0 )
+#else
+#define thread_registry_idx()  Registry_idx_mpthread
+#endif
+
+/* Thread exit callback, releasing an index left registered by a thread.
+ * Data contains the registered (index + 1) of the exiting thread. */
+#ifdef _WIN32
+static inline VOID WINAPI thread_registry_exit(PVOID data)
+#else
+static inline void thread_registry_exit(void *data)
+#endif
+{
+   int idx = (int) (size_t) data;
+
+   if(idx > 0 && idx <= THREAD_REGISTRY_MAX) {
+      mutex_lock(&Registry_mpthread);
+      Registry_live_mpthread[idx - 1] = 0;
+      mutex_unlock(&Registry_mpthread);
+   }
+}
+
+/* Register the current thread with the thread registry, assigning it
+ * the lowest available dense index for use as a direct array index.
+ * The index is released by thread_unregister() or on thread exit.
+ * Returns the thread index on success, else -1 if registry is full. */
+static inline int thread_register(void)
+{
+   int i;
+
+   /* already registered threads retain their existing index */
+   i = thread_registry_idx();
+   if(i)
+      return i - 1;
+
+   mutex_lock(&Registry_mpthread);
+   /* thread exit callback need only be acquired once */
+   if(!Registry_keyinit_mpthread) {
+#ifdef _WIN32
+      Registry_key_mpthread = FlsAlloc(thread_registry_exit);
+#else
+      pthread_key_create(&Registry_key_mpthread, thread_registry_exit);
+#endif
+      Registry_keyinit_mpthread = 1;
+   }
+   /* claim the lowest available index */
+   for(i = 0; i < THREAD_REGISTRY_MAX; i++) {
+      if(Registry_live_mpthread[i]) continue;
+      Registry_live_mpthread[i] = 1;
+      Registry_tid_mpthread[i] = thread_self();
+      break;
+   }
+   mutex_unlock(&Registry_mpthread);
+
+   /* registry full */
+   if(i == THREAD_REGISTRY_MAX)
+      return -1;
+
+   /* attach index to thread, and to thread exit callback */
+#ifdef _WIN32
+   FlsSetValue(Registry_key_mpthread, (PVOID) (size_t) (i + 1));
+#else
+   Registry_idx_mpthread = i + 1;
+   pthread_setspecific(Registry_key_mpthread, (void *) (size_t) (i + 1));
+#endif
+
+   return i;
+}
+
+/* Unregister the current thread from the thread registry, releasing
+ * its index for recycling by subsequently registered threads.
+ * Returns 0 on success, else -1 if the thread was not registered. */
+static inline int thread_unregister(void)
+{
+   int idx = thread_registry_idx();
+
+   if(idx == 0)
+      return -1;
+
+   /* detach index from thread, and from thread exit callback */
+#ifdef _WIN32
+   FlsSetValue(Registry_key_mpthread, NULL);
+#else
+   pthread_setspecific(Registry_key_mpthread, NULL);
+   Registry_idx_mpthread = 0;
+#endif
+   thread_registry_exit((void *) (size_t) idx);
+
+   return 0;
+}
+
+/* Obtain the registry index of the current thread. (NON-BLOCKING)
+ * Returns the thread index, else -1 if the thread is not registered. */
+static inline int thread_index(void)
+{
+   return thread_registry_idx() - 1;
+}
+
+/* Enumerate live threads in the thread registry, in index order.
+ * Expects pointers to `len` length arrays of thread id's and indexes,
+ * either of which may be NULL if the information is not required.
+ * Returns the number of live threads written (at most `len`). */
+static inline int thread_enumerate(ThreadID *tidlist, int *idxlist, int len)
+{
+   int i, count;
+
+   mutex_lock(&Registry_mpthread);
+   for(i = count = 0; i < THREAD_REGISTRY_MAX && count < len; i++) {
+      if(!Registry_live_mpthread[i]) continue;
+      if(tidlist) tidlist[count] = Registry_tid_mpthread[i];
+      if(idxlist) idxlist[count] = i;
+      count++;
+   }
+   mutex_unlock(&Registry_mpthread);
+
+   return count;
+}
+
+/* A parked thread slot of a ThreadReserve. */
+typedef struct _RESERVE_SLOT {
+   struct _ThreadReserve *reserve;
+   ThreadID tid;
+   Condition wake;      /* signalled on hand off, or shutdown */
+   ThreadFunc *func;
+   void *arg;
+   int state;           /* 0 = parked, 1 = running, 2 = done */
+} RESERVE_SLOT;
+
+/* A reserve of pre-spawned threads, parked until handed a function.
+ * All reserve state is guarded by `lock`. */
+typedef struct _ThreadReserve {
+   Mutex lock;
+   Condition done;      /* broadcast on completion of a function */
+   RESERVE_SLOT *slots;
+   int *parked;         /* stack of parked slot indexes */
+   int nparked;
+   int threads;         /* running threads */
+   int shutdown;
+} ThreadReserve;
+
+/* Thread function of a parked thread, running handed off functions
+ * until the reserve is shutdown. */
+static inline Threaded reserve_thread(void *arg)
+{
+   RESERVE_SLOT *slot = (RESERVE_SLOT *) arg;
+   ThreadReserve *res = slot->reserve;
+
+   mutex_lock(&res->lock);
+   for( ; ; ) {
+      while(slot->state != 1 && !res->shutdown)
+         condition_wait(&slot->wake, &res->lock);
+      if(slot->state != 1) break;
+      mutex_unlock(&res->lock);
+      slot->func(slot->arg);
+      mutex_lock(&res->lock);
+      slot->state = 2;
+      condition_broadcast(&res->done);
+   }
+   mutex_unlock(&res->lock);
+
+   return Treturn;
+}
+
+/* Shutdown a ThreadReserve, waiting for running functions to complete,
+ * and joining all parked threads. (BLOCKING)
+ * Returns 0 on success, else the first error code. */
+static inline int reserve_free(ThreadReserve *res)
+{
+   int i, ecode, temp;
+
+   mutex_lock(&res->lock);
+   res->shutdown = 1;
+   for(i = 0; i < res->threads; i++)
+      condition_signal(&res->slots[i].wake);
+   mutex_unlock(&res->lock);
+
+   for(ecode = i = 0; i < res->threads; i++) {
+      temp = thread_wait(&res->slots[i].tid);
+      if(temp && !ecode) ecode = temp;
+      condition_free(&res->slots[i].wake);
+   }
+   condition_free(&res->done);
+   mutex_free(&res->lock);
+   free(res->slots);
+   free(res->parked);
+   res->slots = NULL;
+   res->parked = NULL;
+   res->threads = res->nparked = 0;
+
+   return ecode;
+}
+
+/* Initialize a ThreadReserve of `threads` pre-spawned threads, each with
+ * a `stacksize` byte stack (0 for the default).
+ * Returns 0 on success, else error code. */
+static inline int reserve_init(ThreadReserve *res, int threads,
+   size_t stacksize)
+{
+   int i, ecode;
+
+   if(threads < 1) return EINVAL;
+   res->slots = (RESERVE_SLOT *) calloc((size_t) threads, sizeof(RESERVE_SLOT));
+   res->parked = (int *) malloc((size_t) threads * sizeof(int));
+   if(res->slots == NULL || res->parked == NULL) {
+      free(res->slots);
+      free(res->parked);
+      return ENOMEM;
+   }
+   res->nparked = res->threads = res->shutdown = 0;
+   mutex_init(&res->lock);
+   condition_init(&res->done);
+
+   mutex_lock(&res->lock);
+   for(ecode = i = 0; i < threads; i++) {
+      res->slots[i].reserve = res;
+      condition_init(&res->slots[i].wake);
+      ecode = thread_create_stack(&res->slots[i].tid, reserve_thread,
+         &res->slots[i], stacksize);
+      if(ecode) {
+         condition_free(&res->slots[i].wake);
+         break;
+      }
+      res->parked[res->nparked++] = i;
+      res->threads++;
+   }
+   mutex_unlock(&res->lock);
+   if(ecode) reserve_free(res);
+
+   return ecode;
+}
+
+/* Hand a function to a parked thread of a ThreadReserve, to run
+ * immediately, storing its slot for reserve_wait() in `slot`.
+ * Returns 0 on success, EAGAIN if no thread is parked, else error code. */
+static inline int reserve_spawn(ThreadReserve *res, int *slot,
+   ThreadFunc *func, void *arg)
+{
+   RESERVE_SLOT *rs;
+   int ecode = 0;
+
+   mutex_lock(&res->lock);
+   if(res->shutdown) ecode = EINVAL;
+   else if(res->nparked == 0) ecode = EAGAIN;
+   else {
+      *slot = res->parked[--res->nparked];
+      rs = &res->slots[*slot];
+      rs->func = func;
+      rs->arg = arg;
+      rs->state = 1;
+      condition_signal(&rs->wake);
+   }
+   mutex_unlock(&res->lock);
+
+   return ecode;
+}
+
+/* Wait for the function handed to a ThreadReserve `slot` to complete,
+ * returning its thread to the reserve. (BLOCKING)
+ * Returns 0 on success, else EINVAL if the slot is not spawned. */
+static inline int reserve_wait(ThreadReserve *res, int slot)
+{
+   RESERVE_SLOT *rs;
+
+   if(slot < 0 || slot >= res->threads) return EINVAL;
+   rs = &res->slots[slot];
+
+   mutex_lock(&res->lock);
+   if(rs->state == 0) {
+      mutex_unlock(&res->lock);
+      return EINVAL;
+   }
+   while(rs->state != 2) condition_wait(&res->done, &res->lock);
+   rs->state = 0;
+   res->parked[res->nparked++] = slot;
+   mutex_unlock(&res->lock);
+
+   return 0;
+}
+
 
 #endif /* end _MP_THREAD_H_ */
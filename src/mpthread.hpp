@@ -0,0 +1,213 @@
+/* ****************************************************************
+ * Multiplatform threading support for C++; RAII lock guards and
+ * templated lock policies.
+ *  - mpthread.hpp (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file wraps the locks of mpthread.h in RAII guards, such that a
+ * lock is released on every path out of a scope, including early
+ * returns and exceptions. Lock types are selected at compile time, as
+ * template lock policies, allowing a container to be instantiated with
+ * the locking (or lack of locking) its use requires:
+ *   mp::Synchronized<Map, Mutex>     exclusive access
+ *   mp::Synchronized<Map, RWLock>    shared reads, exclusive writes
+ *   mp::Synchronized<Map, Spinlock>  short critical sections
+ *   mp::Synchronized<Map, mp::NoLock>  single threaded use
+ *
+ * A lock policy is any type with a specialization of mp::LockTraits,
+ * mapping init/lock/unlock (and shared variants) to plain function
+ * calls. The C lock types of mpthread.h are policies themselves, so no
+ * wrapper state exists; with optimization enabled, a guard compiles to
+ * exactly the C calls it replaces. Types providing lock() and unlock()
+ * member functions (such as std::mutex) are policies by default.
+ *
+ * NOTES:
+ * - Guards are neither copyable nor movable, and SHALL be named;
+ *   an unnamed guard is destroyed, releasing its lock, immediately.
+ * - Shared guards of exclusive-only policies (Mutex, Spinlock) acquire
+ *   the lock exclusively.
+ * - Requires C++11 or later.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial RAII guard and lock policy implementation.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_THREAD_HPP_
+#define _MP_THREAD_HPP_  /* include guard */
+
+
+#include <utility>
+#include "mpthread.h"
+
+namespace mp {
+
+/* A lock policy performing no locking, for single threaded use. */
+struct NoLock {};
+
+/* Lock traits of a policy type providing lock() and unlock() members. */
+template<class L>
+struct LockTraits {
+   static void init(L &) {}
+   static void free(L &) {}
+   static void lock(L &l) { l.lock(); }
+   static void unlock(L &l) { l.unlock(); }
+   static void lock_shared(L &l) { l.lock(); }
+   static void unlock_shared(L &l) { l.unlock(); }
+};
+
+/* Lock traits of the Mutex of mpthread.h. */
+template<>
+struct LockTraits<Mutex> {
+   static void init(Mutex &m) { mutex_init(&m); }
+   static void free(Mutex &m) { mutex_free(&m); }
+   static void lock(Mutex &m) { mutex_lock(&m); }
+   static void unlock(Mutex &m) { mutex_unlock(&m); }
+   static void lock_shared(Mutex &m) { mutex_lock(&m); }
+   static void unlock_shared(Mutex &m) { mutex_unlock(&m); }
+};
+
+/* Lock traits of the RWLock of mpthread.h. */
+template<>
+struct LockTraits<RWLock> {
+   static void init(RWLock &rw) { rwlock_init(&rw); }
+#ifdef _WIN32
+   static void free(RWLock &) {}
+#else
+   static void free(RWLock &rw) { rwlock_free(&rw); }
+#endif
+   static void lock(RWLock &rw) { rwlock_wrlock(&rw); }
+   static void unlock(RWLock &rw) { rwlock_wrunlock(&rw); }
+   static void lock_shared(RWLock &rw) { rwlock_rdlock(&rw); }
+   static void unlock_shared(RWLock &rw) { rwlock_rdunlock(&rw); }
+};
+
+/* Lock traits of the Spinlock of mpthread.h. */
+template<>
+struct LockTraits<Spinlock> {
+   static void init(Spinlock &s) { spinlock_init(&s); }
+   static void free(Spinlock &) {}
+   static void lock(Spinlock &s) { spinlock_lock(&s); }
+   static void unlock(Spinlock &s) { spinlock_unlock(&s); }
+   static void lock_shared(Spinlock &s) { spinlock_lock(&s); }
+   static void unlock_shared(Spinlock &s) { spinlock_unlock(&s); }
+};
+
+/* Lock traits of NoLock; every operation compiles to nothing. */
+template<>
+struct LockTraits<NoLock> {
+   static void init(NoLock &) {}
+   static void free(NoLock &) {}
+   static void lock(NoLock &) {}
+   static void unlock(NoLock &) {}
+   static void lock_shared(NoLock &) {}
+   static void unlock_shared(NoLock &) {}
+};
+
+/* An exclusive lock guard; locks on construction, unlocks on
+ * destruction. */
+template<class L>
+class LockGuard {
+public:
+   explicit LockGuard(L &l) : lock_(l) { LockTraits<L>::lock(lock_); }
+   ~LockGuard() { LockTraits<L>::unlock(lock_); }
+   LockGuard(const LockGuard &) = delete;
+   LockGuard &operator=(const LockGuard &) = delete;
+private:
+   L &lock_;
+};
+
+/* A shared lock guard; locks shared on construction, unlocks on
+ * destruction. */
+template<class L>
+class SharedGuard {
+public:
+   explicit SharedGuard(L &l) : lock_(l) { LockTraits<L>::lock_shared(lock_); }
+   ~SharedGuard() { LockTraits<L>::unlock_shared(lock_); }
+   SharedGuard(const SharedGuard &) = delete;
+   SharedGuard &operator=(const SharedGuard &) = delete;
+private:
+   L &lock_;
+};
+
+/* An owned lock of policy L, initialized on construction and freed on
+ * destruction, for use as a class member. */
+template<class L>
+class Lock {
+public:
+   Lock() { LockTraits<L>::init(lock_); }
+   ~Lock() { LockTraits<L>::free(lock_); }
+   Lock(const Lock &) = delete;
+   Lock &operator=(const Lock &) = delete;
+   void lock() { LockTraits<L>::lock(lock_); }
+   void unlock() { LockTraits<L>::unlock(lock_); }
+   void lock_shared() { LockTraits<L>::lock_shared(lock_); }
+   void unlock_shared() { LockTraits<L>::unlock_shared(lock_); }
+   L *native() { return &lock_; }
+private:
+   L lock_;
+};
+
+/* Lock traits of an owned lock, forwarding to its policy. */
+template<class L>
+struct LockTraits<Lock<L> > {
+   static void init(Lock<L> &) {}
+   static void free(Lock<L> &) {}
+   static void lock(Lock<L> &l) { l.lock(); }
+   static void unlock(Lock<L> &l) { l.unlock(); }
+   static void lock_shared(Lock<L> &l) { l.lock_shared(); }
+   static void unlock_shared(Lock<L> &l) { l.unlock_shared(); }
+};
+
+/* A value guarded by a lock of policy L. The value is only accessible
+ * within functions passed to write() (exclusive), or read() (shared,
+ * const), with the lock held. */
+template<class T, class L = Mutex>
+class Synchronized {
+public:
+   template<class... Args>
+   explicit Synchronized(Args &&... args)
+      : value_(std::forward<Args>(args)...) {}
+   Synchronized(const Synchronized &) = delete;
+   Synchronized &operator=(const Synchronized &) = delete;
+
+   /* Execute f(T &) with the lock held exclusively.
+    * Returns the result of f. */
+   template<class F>
+   auto write(F &&f) -> decltype(f(std::declval<T &>()))
+   {
+      LockGuard<Lock<L> > guard(lock_);
+      return f(value_);
+   }
+
+   /* Execute f(const T &) with the lock held shared.
+    * Returns the result of f. */
+   template<class F>
+   auto read(F &&f) const -> decltype(f(std::declval<const T &>()))
+   {
+      SharedGuard<Lock<L> > guard(lock_);
+      return f(value_);
+   }
+
+private:
+   T value_;
+   mutable Lock<L> lock_;
+};
+
+}  /* end namespace mp */
+
+
+#endif /* end _MP_THREAD_HPP_ */
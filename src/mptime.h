@@ -19,7 +19,50 @@
  * already present on most systems.
  *
  * This file provides support for sleep with millisecond precision,
- * as well as time stamps with milli and microsecond precision.
+ * as well as time stamps with milli, micro and nanosecond precision.
+ *
+ * A fast wall clock, walltime(), derives the time since the Unix Epoch
+ * from the nanoseconds() time stamp plus an offset, refreshed against
+ * the system realtime clock every WALLTIME_REFRESH nanoseconds. Wall
+ * clock time stamps may be formatted as ISO-8601 (UTC) with iso8601(),
+ * which caches the formatted date and time of the last second.
+ *
+ * Cheaper time stamps are available where precision may be traded for
+ * cost. A coarse clock, coarsenanoseconds(), returns the time of the
+ * last scheduler tick (milliseconds of precision), without reading a
+ * hardware counter. The time stamp counter, tsc_ticks(), reads the
+ * processor cycle counter (where available), and tsc_nanoseconds()
+ * scales ticks since calibration to nanoseconds, by a multiplier
+ * calibrated against the nanoseconds() time stamp over TSC_CALIBRATE
+ * nanoseconds, and adds them to the nanoseconds() time stamp of the
+ * calibration.
+ *
+ * A Stopwatch measures running time on the fastest clock available,
+ * stopwatch_clock() (the time stamp counter, where available), with
+ * start, stop, lap and reset. Each lap is recorded in-place by the
+ * Stopwatch's TimeStats, an accumulator of the count, minimum, maximum,
+ * mean and variance of samples (by Welford's online algorithm), such
+ * that hot loops are timed without allocation or storage of samples.
+ *
+ * NOTES:
+ * - Fast wall clock state is held in static storage and is therefore
+ *   local to each translation unit. Concurrent refreshes are benign.
+ * - Adjustments of the system clock are observed by walltime() at the
+ *   next offset refresh, and not before.
+ * - A TimeCache is used by a single thread, or SHALL be protected by
+ *   the caller, and SHALL be zero initialized (or TIMECACHE_INITIALIZER).
+ * - Time stamp counter calibration is process-wide, held in ThreadShared
+ *   storage (as the thread registry of mpthread.h), and performed once;
+ *   by the first call of tsc_calibrate() or tsc_nanoseconds() (blocking
+ *   for TSC_CALIBRATE). Later calls of tsc_calibrate() return the
+ *   published calibration, such that time stamps of every translation
+ *   unit share one origin, and never step.
+ * - The time stamp counter is steady only where the processor provides
+ *   an invariant counter, synchronized across processors (most x86
+ *   processors since ~2008). Elsewhere, tsc_ticks() is nanoseconds().
+ * - A Stopwatch (and its TimeStats) is used by a single thread, or SHALL
+ *   be protected by the caller. Per-thread TimeStats may be combined
+ *   with timestats_merge().
  *
  * CHANGELOG:
  * Rev.1   2020-02-1
@@ -32,6 +75,16 @@
  *   File overhaul and conversion to header file.
  *   Changed functions to MACRO redefinitions where appropriate.
  *   Removed stdint.h in favour of standard datatypes.
+ * Rev.5   2026-10-18
+ *   Added nanoseconds timestamp function and nanoelapsed function macro.
+ *   Added fast wall clock and cached ISO-8601 time stamp formatting.
+ * Rev.6   2026-10-18
+ *   Added coarse clock and time stamp counter time stamp functions.
+ * Rev.7   2026-10-18
+ *   Added Stopwatch lap timer and TimeStats accumulator.
+ * Rev.8   2026-10-18
+ *   Time stamp counter calibration is now process-wide, calibrated once,
+ *   and anchored to the nanoseconds() time stamp of the calibration.
  *
  * ****************************************************************/
 
@@ -39,13 +92,33 @@
 #define _MP_TIME_H_  /* include guard */
 
 
+#include <string.h>
+
 #define MILLISECONDS 1000L
 #define MICROSECONDS 1000000L
+#define NANOSECONDS  1000000000LL
+
+/* Period of the fast wall clock offset refresh, in nanoseconds.
+ * May be overridden by defining WALLTIME_REFRESH before inclusion. */
+#ifndef WALLTIME_REFRESH
+#define WALLTIME_REFRESH  NANOSECONDS
+#endif
+
+/* Period of the time stamp counter calibration, in nanoseconds.
+ * May be overridden by defining TSC_CALIBRATE before inclusion. */
+#ifndef TSC_CALIBRATE
+#define TSC_CALIBRATE  (NANOSECONDS / 100)
+#endif
+
+/* Length of an ISO-8601 time stamp buffer, including nul terminator. */
+#define ISO8601_LEN  32
 
 /* Measure elapsed milliseconds since a previous millisecond time stamp. */
 #define millielapsed(ms)  ( milliseconds() - ms )
 /* Measure elapsed microseconds since a previous microsecond time stamp. */
 #define microelapsed(us)  ( microseconds() - us )
+/* Measure elapsed nanoseconds since a previous nanosecond time stamp. */
+#define nanoelapsed(ns)   ( nanoseconds() - ns )
 
 
 #ifdef _WIN32
@@ -97,6 +170,51 @@ static inline long microseconds(void)
    return (long) ((count.QuadPart * MICROSECONDS) / Freq_mptime.QuadPart);
 }
 
+/* Retrieve a high resolution time stamp, in nanoseconds,
+ * independent of any external time reference.
+ * NOTE: Always 8 byte long long, time range is ±292 years.
+ * Returns long long integer. */
+static inline long long nanoseconds(void)
+{
+   LARGE_INTEGER count;
+
+   /* performance frequency need only be acquired once */
+   if(Freq_mptime.QuadPart == 0)
+      QueryPerformanceFrequency(&Freq_mptime);
+   /* obtain performance counter */
+   QueryPerformanceCounter(&count);
+
+   /* split calculation of whole seconds, avoiding overflow */
+   return ((count.QuadPart / Freq_mptime.QuadPart) * NANOSECONDS) +
+      (((count.QuadPart % Freq_mptime.QuadPart) * NANOSECONDS) /
+      Freq_mptime.QuadPart);
+}
+
+/* Retrieve the system realtime clock, in nanoseconds since the
+ * Unix Epoch, with 100 nanosecond (FILETIME) precision.
+ * Returns long long integer. */
+static inline long long realnanoseconds(void)
+{
+   ULARGE_INTEGER count;
+   FILETIME ft;
+
+   GetSystemTimePreciseAsFileTime(&ft);
+   count.LowPart = ft.dwLowDateTime;
+   count.HighPart = ft.dwHighDateTime;
+
+   /* FILETIME counts 100ns intervals since 1 January 1601 */
+   return ((long long) count.QuadPart - 116444736000000000LL) * 100;
+}
+
+/* Retrieve a coarse time stamp, in nanoseconds, independent of any
+ * external time reference, with the precision of the system timer
+ * (typically 10-16 milliseconds).
+ * Returns long long integer. */
+static inline long long coarsenanoseconds(void)
+{
+   return (long long) GetTickCount64() * 1000000LL;
+}
+
 
 #else /* end Windows */
 /*********************/
@@ -105,6 +223,7 @@ static inline long microseconds(void)
 /* ---------------- POSIX ---------------- */
 
 #include <sys/time.h>
+#include <time.h>
 
 /* Suspend the current thread for specified milliseconds. */
 static inline void millisleep(unsigned long ms)
@@ -162,9 +281,409 @@ static inline long microseconds(void)
    return ((long) ts.tv_sec * MICROSECONDS) + (ts.tv_nsec / 1000L);
 }
 
+/* Retrieve a high resolution time stamp in nanoseconds, using
+ * some unspecified starting point (default:CLOCK_MONOTONIC) or
+ * using system-wide realtime (fallback:CLOCK_REALTIME).
+ * NOTE: Always 8 byte long long, time range is ±292 years.
+ * Returns long long integer. */
+static inline long long nanoseconds(void)
+{
+   struct timespec ts = ts_gettime();
+
+   /* return high resolution time calculation */
+   return ((long long) ts.tv_sec * NANOSECONDS) + ts.tv_nsec;
+}
+
+/* Retrieve the system realtime clock, in nanoseconds since the
+ * Unix Epoch (CLOCK_REALTIME).
+ * Returns long long integer. */
+static inline long long realnanoseconds(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_REALTIME, &ts);
+
+   return ((long long) ts.tv_sec * NANOSECONDS) + ts.tv_nsec;
+}
+
+/* Retrieve a coarse time stamp in nanoseconds, using some unspecified
+ * starting point (default:CLOCK_MONOTONIC_COARSE), with the precision
+ * of the scheduler tick (typically 1-4 milliseconds), or a high
+ * resolution time stamp where no coarse clock exists (fallback).
+ * Returns long long integer. */
+static inline long long coarsenanoseconds(void)
+{
+   struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC_COARSE
+   if(clock_gettime(CLOCK_MONOTONIC_COARSE, &ts))
+#endif
+      ts = ts_gettime();
+
+   return ((long long) ts.tv_sec * NANOSECONDS) + ts.tv_nsec;
+}
+
 
 #endif /* end POSIX */
 /********************/
 
+/* A formatting cache, holding the ISO-8601 date and time of the last
+ * formatted second, "YYYY-MM-DDThh:mm:ss", and of its day. */
+typedef struct {
+   int valid;
+   long long sec, day;
+   char text[20];
+} TimeCache;
+
+#define TIMECACHE_INITIALIZER  {0}
+
+/* Fast wall clock state; the offset of the wall clock from nanoseconds(),
+ * and the nanoseconds() time stamp of the next offset refresh. */
+static volatile long long Walloff_mptime;
+static volatile long long Wallsync_mptime;
+
+/* Retrieve a fast wall clock time stamp, in nanoseconds since the Unix
+ * Epoch, derived from nanoseconds() and a periodically refreshed offset.
+ * Returns long long integer. */
+static inline long long walltime(void)
+{
+   long long ns, real, after;
+
+   ns = nanoseconds();
+   if(ns >= Wallsync_mptime || Walloff_mptime == 0) {
+      /* measure offset against the midpoint of the monotonic readings */
+      real = realnanoseconds();
+      after = nanoseconds();
+      Walloff_mptime = real - (ns + ((after - ns) / 2));
+      Wallsync_mptime = after + WALLTIME_REFRESH;
+   }
+
+   return ns + Walloff_mptime;
+}
+
+/* Read the time stamp counter, in processor defined ticks. Where no
+ * counter is available, ticks are nanoseconds() (TSC_FALLBACK).
+ * Returns long long integer. */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define tsc_ticks()  ( (long long) __rdtsc() )
+
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define tsc_ticks()  ( (long long) __rdtsc() )
+
+#else
+#define TSC_FALLBACK
+#define tsc_ticks()  nanoseconds()
+
+#endif
+
+/* Storage class for process-wide variables, defined (with an
+ * initializer) in every translation unit and merged by the linker.
+ * Identical to that of mpthread.h. */
+#ifndef ThreadShared
+#ifdef _WIN32
+#define ThreadShared  __declspec(selectany)
+#else
+#define ThreadShared  __attribute__((weak))
+#endif
+#endif
+
+/* Time stamp counter state load/store, with acquire/release semantics,
+ * and claim (compare and swap of 0 with 1).
+ * MSVC volatile accesses carry these semantics by default (/volatile:ms). */
+#ifdef _MSC_VER
+#define tsc_acquire(p)    ( *(volatile long *) (p) )
+#define tsc_release(p,v)  ( *(volatile long *) (p) = (v) )
+#define tsc_claim(p)      ( InterlockedCompareExchange(p, 1, 0) == 0 )
+#else
+#define tsc_acquire(p)    __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define tsc_release(p,v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define tsc_claim(p)      __sync_bool_compare_and_swap(p, 0, 1)
+#endif
+
+/* Time stamp counter calibration. */
+typedef struct {
+   long long mult;      /* nanoseconds per tick, in 32.32 fixed point */
+   long long ticks;     /* tsc_ticks() of the calibration */
+   long long ns;        /* nanoseconds() of the calibration */
+   long long freq;      /* ticks per second */
+} TSC_CALIBRATION;
+
+/* Process-wide time stamp counter state; the calibration, published
+ * by a state of 2 (0 = uncalibrated, 1 = calibrating). */
+#ifdef __cplusplus
+extern "C" {
+#endif
+ThreadShared TSC_CALIBRATION Tsc_mptime = {0};
+ThreadShared volatile long Tscstate_mptime = 0;
+#ifdef __cplusplus
+}
+#endif
+
+/* Check the time stamp counter is calibrated. Returns non-zero if so. */
+#define tsc_calibrated()  ( tsc_acquire(&Tscstate_mptime) == 2 )
+
+/* Scale `t` ticks by a 32.32 fixed point multiplier `m`.
+ * Split 64x64 fixed point multiply, avoiding overflow. */
+#define tsc_scale(t,m)  ( (long long) (((t) >> 32) * (m) + \
+   ((t) & 0xffffffffULL) * ((m) >> 32) + \
+   ((((t) & 0xffffffffULL) * ((m) & 0xffffffffULL)) >> 32)) )
+
+/* Calibrate the time stamp counter against nanoseconds(), over
+ * TSC_CALIBRATE nanoseconds, once per process. Blocks the calling
+ * thread (spinning), or waits for a calibration in progress.
+ * Returns the time stamp counter frequency, in ticks per second. */
+static inline long long tsc_calibrate(void)
+{
+   TSC_CALIBRATION cal;
+   long long ns, ticks;
+
+   if(tsc_claim(&Tscstate_mptime)) {
+      cal.ns = nanoseconds();
+      cal.ticks = tsc_ticks();
+      do ns = nanoelapsed(cal.ns); while(ns < TSC_CALIBRATE);
+      ticks = tsc_ticks() - cal.ticks;
+      /* a stalled counter is unusable; scale 1:1 */
+      if(ticks <= 0) ticks = ns;
+      cal.mult = (ns << 32) / ticks;
+      cal.freq = ticks * (NANOSECONDS / 1000) / (ns / 1000);
+      Tsc_mptime = cal;
+      tsc_release(&Tscstate_mptime, 2);
+   } else while(!tsc_calibrated()) millisleep(1);
+
+   return Tsc_mptime.freq;
+}
+
+/* Retrieve a time stamp counter time stamp, in nanoseconds, on the
+ * timeline of nanoseconds() at calibration. Calibrates the time stamp
+ * counter on first use.
+ * Returns long long integer. */
+static inline long long tsc_nanoseconds(void)
+{
+   unsigned long long t, m;
+
+   if(!tsc_calibrated()) tsc_calibrate();
+   t = (unsigned long long) (tsc_ticks() - Tsc_mptime.ticks);
+   m = (unsigned long long) Tsc_mptime.mult;
+
+   /* ticks before calibration (of a lagging processor) scale backwards */
+   if((long long) t < 0) {
+      t = 0 - t;
+      return Tsc_mptime.ns - tsc_scale(t, m);
+   }
+
+   return Tsc_mptime.ns + tsc_scale(t, m);
+}
+
+/* Read the clock of a Stopwatch, in nanoseconds; the time stamp counter
+ * where available, else nanoseconds().
+ * May be overridden by defining stopwatch_clock() before inclusion. */
+#ifndef stopwatch_clock
+#ifdef TSC_FALLBACK
+#define stopwatch_clock()  nanoseconds()
+#else
+#define stopwatch_clock()  tsc_nanoseconds()
+#endif
+#endif
+
+/* An accumulator of time samples, in nanoseconds. */
+typedef struct {
+   long long count;
+   long long min, max;
+   double mean;
+   double m2;           /* sum of squared deviations from the mean */
+} TimeStats;
+
+/* A lap timer, accumulating running time and recording laps. */
+typedef struct {
+   long long start;     /* stopwatch_clock() of the start, or last lap */
+   long long elapsed;   /* running time of previous intervals */
+   long long lapsed;    /* running time of the current lap, when stopped */
+   int running;
+   TimeStats laps;
+} Stopwatch;
+
+/* Add a sample of `ns` nanoseconds to a TimeStats. */
+static inline void timestats_add(TimeStats *ts, long long ns)
+{
+   double delta;
+
+   if(ts->count == 0 || ns < ts->min) ts->min = ns;
+   if(ts->count == 0 || ns > ts->max) ts->max = ns;
+   ts->count++;
+   delta = (double) ns - ts->mean;
+   ts->mean += delta / (double) ts->count;
+   ts->m2 += delta * ((double) ns - ts->mean);
+}
+
+/* Add the samples of TimeStats `src` to TimeStats `ts`. */
+static inline void timestats_merge(TimeStats *ts, const TimeStats *src)
+{
+   double delta, n;
+
+   if(src->count == 0) return;
+   if(ts->count == 0) {
+      *ts = *src;
+      return;
+   }
+   if(src->min < ts->min) ts->min = src->min;
+   if(src->max > ts->max) ts->max = src->max;
+   n = (double) (ts->count + src->count);
+   delta = src->mean - ts->mean;
+   ts->mean += delta * (double) src->count / n;
+   ts->m2 += src->m2 + delta * delta *
+      (double) ts->count * (double) src->count / n;
+   ts->count += src->count;
+}
+
+/* Obtain the sample variance (divisor n - 1) of a TimeStats.
+ * Returns variance, in nanoseconds squared, or 0 where count < 2. */
+static inline double timestats_variance(const TimeStats *ts)
+{
+   return ts->count > 1 ? ts->m2 / (double) (ts->count - 1) : 0.0;
+}
+
+/* Reset a Stopwatch, stopped, with no laps. Calibrates the time stamp
+ * counter, where not yet calibrated, so laps never include calibration. */
+static inline void stopwatch_reset(Stopwatch *sw)
+{
+   memset(sw, 0, sizeof(*sw));
+#ifndef TSC_FALLBACK
+   if(!tsc_calibrated()) tsc_calibrate();
+#endif
+}
+
+/* Start (or resume) a Stopwatch. */
+static inline void stopwatch_start(Stopwatch *sw)
+{
+   if(sw->running) return;
+   sw->start = stopwatch_clock();
+   sw->running = 1;
+}
+
+/* Stop a Stopwatch. The current lap resumes with stopwatch_start().
+ * Returns total running time, in nanoseconds. */
+static inline long long stopwatch_stop(Stopwatch *sw)
+{
+   long long ns;
+
+   if(sw->running) {
+      ns = stopwatch_clock() - sw->start;
+      sw->elapsed += ns;
+      sw->lapsed += ns;
+      sw->running = 0;
+   }
+
+   return sw->elapsed;
+}
+
+/* Record a lap of a Stopwatch; the running time since the previous lap
+ * (or reset), which is added to the Stopwatch's TimeStats.
+ * Returns lap time, in nanoseconds. */
+static inline long long stopwatch_lap(Stopwatch *sw)
+{
+   long long now, ns;
+
+   ns = sw->lapsed;
+   if(sw->running) {
+      now = stopwatch_clock();
+      ns += now - sw->start;
+      sw->elapsed += now - sw->start;
+      sw->start = now;
+   }
+   sw->lapsed = 0;
+   timestats_add(&sw->laps, ns);
+
+   return ns;
+}
+
+/* Obtain the total running time of a Stopwatch.
+ * Returns running time, in nanoseconds. */
+static inline long long stopwatch_elapsed(const Stopwatch *sw)
+{
+   if(sw->running) return sw->elapsed + (stopwatch_clock() - sw->start);
+
+   return sw->elapsed;
+}
+
+/* Obtain the total running time of a Stopwatch, in seconds.
+ * Returns double precision seconds. */
+#define stopwatch_seconds(sw)  \
+   ( (double) stopwatch_elapsed(sw) / (double) NANOSECONDS )
+
+/* Write `n` decimal digits of `value` to `p`, zero padded. */
+static inline void iso8601_digits(char *p, long long value, int n)
+{
+   while(n--) {
+      p[n] = (char) ('0' + (value % 10));
+      value /= 10;
+   }
+}
+
+/* Format a wall clock time stamp, in nanoseconds since the Unix Epoch,
+ * as an ISO-8601 UTC time stamp with `digits` (0-9) fractional second
+ * digits, "YYYY-MM-DDThh:mm:ss.fffZ", into a ISO8601_LEN length buffer.
+ * The date, and time of day, are formatted once per day, and second.
+ * Returns the length of the time stamp written. */
+static inline int iso8601(TimeCache *cache, char *buf, long long ns,
+   int digits)
+{
+   long long sec, day, frac, z, era, doe, yoe, doy, mp, y, m, d;
+   int i, len;
+
+   sec = ns / NANOSECONDS;
+   frac = ns % NANOSECONDS;
+   if(frac < 0) {
+      frac += NANOSECONDS;
+      sec--;
+   }
+   if(!cache->valid || sec != cache->sec) {
+      day = sec / 86400;
+      if(sec % 86400 < 0) day--;
+      if(!cache->valid || day != cache->day) {
+         /* civil date from days since epoch (proleptic Gregorian) */
+         z = day + 719468;
+         era = (z >= 0 ? z : z - 146096) / 146097;
+         doe = z - (era * 146097);
+         yoe = (doe - (doe / 1460) + (doe / 36524) - (doe / 146096)) / 365;
+         doy = doe - ((365 * yoe) + (yoe / 4) - (yoe / 100));
+         mp = ((5 * doy) + 2) / 153;
+         d = doy - (((153 * mp) + 2) / 5) + 1;
+         m = mp < 10 ? mp + 3 : mp - 9;
+         y = (era * 400) + yoe + (m <= 2);
+         iso8601_digits(cache->text, y, 4);
+         cache->text[4] = '-';
+         iso8601_digits(cache->text + 5, m, 2);
+         cache->text[7] = '-';
+         iso8601_digits(cache->text + 8, d, 2);
+         cache->text[10] = 'T';
+         cache->text[13] = cache->text[16] = ':';
+         cache->day = day;
+      }
+      /* time of day */
+      z = sec - (day * 86400);
+      iso8601_digits(cache->text + 11, z / 3600, 2);
+      iso8601_digits(cache->text + 14, (z / 60) % 60, 2);
+      iso8601_digits(cache->text + 17, z % 60, 2);
+      cache->sec = sec;
+      cache->valid = 1;
+   }
+
+   memcpy(buf, cache->text, 19);
+   len = 19;
+   if(digits > 0) {
+      if(digits > 9) digits = 9;
+      for(i = digits; i < 9; i++) frac /= 10;
+      buf[len++] = '.';
+      iso8601_digits(buf + len, frac, digits);
+      len += digits;
+   }
+   buf[len++] = 'Z';
+   buf[len] = '\0';
+
+   return len;
+}
+
 
 #endif /* end _MP_TIME_H_ */
@@ -0,0 +1,152 @@
+/* ****************************************************************
+ * High resolution time support for C++; std::chrono compatible clocks
+ * over the time stamp functions of mptime.h.
+ *  - mptime.hpp (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides clock types satisfying the TrivialClock
+ * requirements of std::chrono, one for each time stamp backend of
+ * mptime.h, such that time points and durations remain type safe while
+ * hot paths read the cheapest clock sufficient for their precision:
+ *   mp::MonotonicClock  nanoseconds()        high resolution
+ *   mp::CoarseClock     coarsenanoseconds()  scheduler tick precision
+ *   mp::TscClock        tsc_nanoseconds()    time stamp counter
+ *
+ * Every clock counts nanoseconds, so durations of different clocks
+ * share a type (mp::Nanoseconds) and mix without conversion. Durations
+ * convert to the time stamp types of the C functions with constexpr
+ * to_milliseconds(), to_microseconds() and to_nanoseconds(), and C time
+ * stamps convert to time points with the from_stamp() of each clock.
+ *
+ * NOTES:
+ * - Time points of different clocks have different starting points,
+ *   and SHALL NOT be compared; they are distinct types.
+ * - A `using namespace std::chrono` directive makes the C time stamp
+ *   functions (milliseconds(), etc.) ambiguous; qualify chrono names.
+ * - See mptime.h for the precision and steadiness of each backend.
+ * - Requires C++11 or later.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial std::chrono compatible clock implementation.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_TIME_HPP_
+#define _MP_TIME_HPP_  /* include guard */
+
+
+#include <chrono>
+#include "mptime.h"
+
+namespace mp {
+
+/* Duration type of every clock. */
+typedef std::chrono::duration<long long, std::nano> Nanoseconds;
+
+/* A clock reading nanoseconds() of mptime.h. */
+struct MonotonicClock {
+   typedef Nanoseconds::rep rep;
+   typedef Nanoseconds::period period;
+   typedef Nanoseconds duration;
+   typedef std::chrono::time_point<MonotonicClock> time_point;
+   static constexpr bool is_steady = true;
+
+   static time_point now() noexcept
+   {
+      return time_point(duration(nanoseconds()));
+   }
+
+   /* Convert a nanoseconds() time stamp to a time point. */
+   static constexpr time_point from_stamp(long long ns) noexcept
+   {
+      return time_point(duration(ns));
+   }
+};
+
+/* A clock reading coarsenanoseconds() of mptime.h. */
+struct CoarseClock {
+   typedef Nanoseconds::rep rep;
+   typedef Nanoseconds::period period;
+   typedef Nanoseconds duration;
+   typedef std::chrono::time_point<CoarseClock> time_point;
+   static constexpr bool is_steady = true;
+
+   static time_point now() noexcept
+   {
+      return time_point(duration(coarsenanoseconds()));
+   }
+
+   /* Convert a coarsenanoseconds() time stamp to a time point. */
+   static constexpr time_point from_stamp(long long ns) noexcept
+   {
+      return time_point(duration(ns));
+   }
+};
+
+/* A clock reading tsc_nanoseconds() of mptime.h. The first call of
+ * now() calibrates the time stamp counter, unless calibrate() was
+ * called beforehand. */
+struct TscClock {
+   typedef Nanoseconds::rep rep;
+   typedef Nanoseconds::period period;
+   typedef Nanoseconds duration;
+   typedef std::chrono::time_point<TscClock> time_point;
+   static constexpr bool is_steady = true;
+
+   static time_point now() noexcept
+   {
+      return time_point(duration(tsc_nanoseconds()));
+   }
+
+   /* Convert a tsc_nanoseconds() time stamp to a time point. */
+   static constexpr time_point from_stamp(long long ns) noexcept
+   {
+      return time_point(duration(ns));
+   }
+
+   /* Calibrate the time stamp counter, once per process (see
+    * tsc_calibrate()); safe to call at any time, as time points never
+    * step. Returns the time stamp counter frequency, in ticks per second. */
+   static long long calibrate() noexcept { return tsc_calibrate(); }
+};
+
+/* Convert a duration to a milliseconds() type, truncating. */
+template<class Rep, class Period>
+constexpr long to_milliseconds(std::chrono::duration<Rep, Period> d)
+{
+   return (long) std::chrono::duration_cast<
+      std::chrono::milliseconds>(d).count();
+}
+
+/* Convert a duration to a microseconds() type, truncating. */
+template<class Rep, class Period>
+constexpr long to_microseconds(std::chrono::duration<Rep, Period> d)
+{
+   return (long) std::chrono::duration_cast<
+      std::chrono::microseconds>(d).count();
+}
+
+/* Convert a duration to a nanoseconds() type, truncating. */
+template<class Rep, class Period>
+constexpr long long to_nanoseconds(std::chrono::duration<Rep, Period> d)
+{
+   return (long long) std::chrono::duration_cast<Nanoseconds>(d).count();
+}
+
+}  /* end namespace mp */
+
+
+#endif /* end _MP_TIME_HPP_ */
@@ -0,0 +1,362 @@
+/* ****************************************************************
+ * Flight recorder trace event support, in a memory-mapped file.
+ *  - mptrace.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a flight recorder; fixed size, time stamped trace
+ * events written into per-thread rings inside a memory-mapped file.
+ * As the rings are file backed shared memory, the most recent events of
+ * every thread survive a crash of the process, and are decoded offline
+ * (by another process) with trace_dump().
+ *
+ * Events are defined by name with trace_define(), and recorded with
+ * trace_event(), along with two caller defined arguments. Recording an
+ * event performs no system call, lock, or allocation (beyond the first
+ * event of a thread), and is therefore async-signal-safe thereafter.
+ *
+ * NOTES:
+ * - Support functions requiring a Tracer param, SHALL be passed as
+ *   pointers.
+ * - Tracing threads are registered with the thread registry (mpthread.h),
+ *   and record into the ring of their registry index. Events of threads
+ *   with an index beyond the rings of the file are discarded. A ring is
+ *   continued by the next thread assigned the same registry index.
+ * - Each ring holds the most recent `slots` events of its thread. An
+ *   event interrupted by a crash is detected, and discarded, on decode.
+ * - Events survive a crash of the process, but not necessarily of the
+ *   operating system, as file pages are written back lazily.
+ * - Trace files are decoded on the same architecture as recorded.
+ *   trace_dump() rejects a file whose header is inconsistent with its
+ *   size, or with the limits of this file, as corrupt.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial Tracer flight recorder implementation.
+ * Rev.2   2026-10-18
+ *   trace_dump() validates header names, slots and rings against the
+ *   limits of this file and the size of the trace file.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_TRACE_H_
+#define _MP_TRACE_H_  /* include guard */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpthread.h"
+#include "mptime.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#define TRACE_MAGIC    "MPTRACE"
+#define TRACE_VERSION  1
+#define TRACE_NAMES    256  /* maximum defined event names */
+#define TRACE_NAMELEN  32   /* maximum event name length, including nul */
+
+/* Trace file position store, with release semantics.
+ * MSVC volatile accesses carry these semantics by default (/volatile:ms). */
+#ifdef _MSC_VER
+#define trace_release(p,v)  ( *(volatile unsigned *) (p) = (v) )
+#else
+#define trace_release(p,v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+/* A trace event, as recorded in a ring. The `seq` is the position of the
+ * event in its ring (+1), written last, and 0 while the event is written. */
+typedef struct {
+   long long ns;        /* nanoseconds() time stamp */
+   unsigned id;
+   unsigned seq;
+   long long arg[2];
+} TraceEvent;
+
+/* Trace file header. */
+typedef struct {
+   char magic[8];
+   unsigned version;
+   unsigned rings;
+   unsigned slots;      /* events per ring, a power of 2 */
+   unsigned names;      /* defined event names */
+   long long walloff;   /* walltime() offset of nanoseconds() time stamps */
+   char name[TRACE_NAMES][TRACE_NAMELEN];
+} TRACE_HEADER;
+
+/* Trace file ring header, followed by `slots` events. */
+typedef struct {
+   unsigned pos;        /* events written */
+   char pad[64 - sizeof(unsigned)];
+} TRACE_RING;
+
+/* A flight recorder trace file. */
+typedef struct {
+   TRACE_HEADER *hdr;
+   char *rings;
+   size_t ringsize, size;
+   unsigned nrings, slots;
+   Mutex lock;          /* event name definition */
+#ifdef _WIN32
+   HANDLE file, map;
+#else
+   int fd;
+#endif
+} Tracer;
+
+/* Size of a trace file header, aligned to the cache line of its rings. */
+#define trace_hdrsize()  ( (sizeof(TRACE_HEADER) + 63) & ~((size_t) 63) )
+
+/* Obtain the events of a trace file ring. */
+#define trace_events(ring)  ( (TraceEvent *) ((TRACE_RING *) (ring) + 1) )
+
+/* Create (or truncate) and map a trace file, of `rings` per-thread rings
+ * holding `slots` events each, which SHALL be a power of 2.
+ * Returns 0 on success, else error code. */
+static inline int trace_open(Tracer *tr, const char *path, unsigned rings,
+   unsigned slots)
+{
+   int ecode;
+
+   if(rings == 0 || slots == 0 || (slots & (slots - 1)))
+      return EINVAL;
+
+   memset(tr, 0, sizeof(*tr));
+   tr->nrings = rings;
+   tr->slots = slots;
+   tr->ringsize = sizeof(TRACE_RING) + (slots * sizeof(TraceEvent));
+   tr->size = trace_hdrsize() + (rings * tr->ringsize);
+
+#ifdef _WIN32
+   tr->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+   if(tr->file == INVALID_HANDLE_VALUE) return GetLastError();
+   tr->map = CreateFileMappingA(tr->file, NULL, PAGE_READWRITE,
+      (DWORD) ((unsigned long long) tr->size >> 32), (DWORD) tr->size, NULL);
+   if(tr->map == NULL) {
+      ecode = GetLastError();
+      CloseHandle(tr->file);
+      return ecode;
+   }
+   tr->hdr = (TRACE_HEADER *) MapViewOfFile(tr->map, FILE_MAP_WRITE, 0, 0,
+      tr->size);
+   if(tr->hdr == NULL) {
+      ecode = GetLastError();
+      CloseHandle(tr->map);
+      CloseHandle(tr->file);
+      return ecode;
+   }
+#else
+   tr->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if(tr->fd < 0) return errno;
+   /* a sized file reads as zeros, no event is valid until written */
+   if(ftruncate(tr->fd, (off_t) tr->size)) {
+      ecode = errno;
+      close(tr->fd);
+      return ecode;
+   }
+   tr->hdr = (TRACE_HEADER *) mmap(NULL, tr->size, PROT_READ | PROT_WRITE,
+      MAP_SHARED, tr->fd, 0);
+   if(tr->hdr == (TRACE_HEADER *) MAP_FAILED) {
+      ecode = errno;
+      close(tr->fd);
+      return ecode;
+   }
+#endif
+
+   tr->rings = (char *) tr->hdr + trace_hdrsize();
+   tr->hdr->version = TRACE_VERSION;
+   tr->hdr->rings = rings;
+   tr->hdr->slots = slots;
+   tr->hdr->walloff = walltime() - nanoseconds();
+   /* magic is written last, marking a complete header */
+   memcpy(tr->hdr->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+
+   return mutex_init(&tr->lock);
+}
+
+/* Unmap and close a trace file. The file is retained for decoding.
+ * Returns 0 on success, else error code. */
+static inline int trace_close(Tracer *tr)
+{
+#ifdef _WIN32
+   UnmapViewOfFile(tr->hdr);
+   CloseHandle(tr->map);
+   CloseHandle(tr->file);
+#else
+   munmap(tr->hdr, tr->size);
+   close(tr->fd);
+#endif
+   tr->hdr = NULL;
+
+   return mutex_free(&tr->lock);
+}
+
+/* Define an event name, or obtain the id of an existing definition.
+ * Returns the event id on success, else -1 if the name table is full. */
+static inline int trace_define(Tracer *tr, const char *name)
+{
+   unsigned id;
+
+   mutex_lock(&tr->lock);
+   for(id = 0; id < tr->hdr->names; id++)
+      if(strncmp(tr->hdr->name[id], name, TRACE_NAMELEN - 1) == 0) break;
+   if(id == tr->hdr->names) {
+      if(id == TRACE_NAMES) id = (unsigned) -1;
+      else {
+         strncpy(tr->hdr->name[id], name, TRACE_NAMELEN - 1);
+         tr->hdr->names = id + 1;
+      }
+   }
+   mutex_unlock(&tr->lock);
+
+   return (int) id;
+}
+
+/* Record an event, with two caller defined arguments, into the ring of
+ * the current thread. (NON-BLOCKING)
+ * Returns 0 on success, else ENOSPC if the thread has no ring. */
+static inline int trace_event(Tracer *tr, int id, long long arg0,
+   long long arg1)
+{
+   TRACE_RING *ring;
+   TraceEvent *ev;
+   unsigned pos;
+   int idx;
+
+   idx = thread_index();
+   if(idx < 0) idx = thread_register();
+   if(idx < 0 || (unsigned) idx >= tr->nrings) return ENOSPC;
+
+   ring = (TRACE_RING *) (tr->rings + (idx * tr->ringsize));
+   pos = ring->pos;
+   ev = &trace_events(ring)[pos & (tr->slots - 1)];
+   /* invalidate, write, then validate the event slot */
+   trace_release(&ev->seq, 0);
+   ev->ns = nanoseconds();
+   ev->id = (unsigned) id;
+   ev->arg[0] = arg0;
+   ev->arg[1] = arg1;
+   trace_release(&ev->seq, pos + 1);
+   trace_release(&ring->pos, pos + 1);
+
+   return 0;
+}
+
+/* A decoded trace event, and its ring. */
+typedef struct {
+   TraceEvent ev;
+   unsigned ring;
+} TRACE_DECODED;
+
+/* Order decoded events by time stamp, ring, then position. */
+static inline int trace_compare(const void *a, const void *b)
+{
+   const TRACE_DECODED *da = (const TRACE_DECODED *) a;
+   const TRACE_DECODED *db = (const TRACE_DECODED *) b;
+
+   if(da->ev.ns != db->ev.ns) return da->ev.ns < db->ev.ns ? -1 : 1;
+   if(da->ring != db->ring) return da->ring < db->ring ? -1 : 1;
+
+   return da->ev.seq < db->ev.seq ? -1 : (da->ev.seq > db->ev.seq);
+}
+
+/* Decode a trace file, possibly of a crashed process, writing the valid
+ * events of all rings to `out` in time stamp order, one per line:
+ *   [YYYY-MM-DDThh:mm:ss.nnnnnnnnnZ] <ring> <name> <arg0> <arg1>
+ * Returns the number of events written, else -1 on error. */
+static inline long trace_dump(const char *path, FILE *out)
+{
+   char stamp[ISO8601_LEN], *data, *rings;
+   TimeCache cache = TIMECACHE_INITIALIZER;
+   TRACE_DECODED *list;
+   TRACE_HEADER *hdr;
+   TraceEvent *ev;
+   size_t ringsize;
+   unsigned r, p, pos;
+   long size, count, i;
+   FILE *fp;
+
+   /* read, rather than map, the (possibly foreign) trace file */
+   fp = fopen(path, "rb");
+   if(fp == NULL) return -1;
+   fseek(fp, 0, SEEK_END);
+   size = ftell(fp);
+   rewind(fp);
+   data = (char *) malloc(size > 0 ? (size_t) size : 1);
+   if(data == NULL || size < (long) trace_hdrsize() ||
+      fread(data, 1, (size_t) size, fp) != (size_t) size) {
+      free(data);
+      fclose(fp);
+      return -1;
+   }
+   fclose(fp);
+
+   /* validate the (possibly corrupt) header before sizing by it; rings
+    * SHALL fit the file, and event ids index defined names only */
+   hdr = (TRACE_HEADER *) data;
+   if(memcmp(hdr->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) ||
+      hdr->version != TRACE_VERSION || hdr->names > TRACE_NAMES ||
+      hdr->slots == 0 || (hdr->slots & (hdr->slots - 1)) ||
+      hdr->slots > ((size_t) -1 - sizeof(TRACE_RING)) / sizeof(TraceEvent)) {
+      free(data);
+      return -1;
+   }
+   ringsize = sizeof(TRACE_RING) + (hdr->slots * sizeof(TraceEvent));
+   if(hdr->rings > ((size_t) size - trace_hdrsize()) / ringsize) {
+      free(data);
+      return -1;
+   }
+   /* rings fit the file, so the decoded events size cannot overflow */
+   list = (TRACE_DECODED *) malloc((size_t) hdr->rings * hdr->slots *
+      sizeof(TRACE_DECODED) + 1);
+   if(list == NULL) {
+      free(data);
+      return -1;
+   }
+
+   /* collect valid events, the final event may be unpublished */
+   rings = data + trace_hdrsize();
+   for(count = 0, r = 0; r < hdr->rings; r++) {
+      pos = ((TRACE_RING *) (rings + (r * ringsize)))->pos;
+      p = pos > hdr->slots ? pos - hdr->slots : 0;
+      for( ; p != pos + 1; p++) {
+         ev = &trace_events(rings + (r * ringsize))[p & (hdr->slots - 1)];
+         if(ev->seq != p + 1 || ev->id >= hdr->names) continue;
+         list[count].ev = *ev;
+         list[count++].ring = r;
+      }
+   }
+   qsort(list, (size_t) count, sizeof(TRACE_DECODED), trace_compare);
+   for(i = 0; i < count; i++) {
+      iso8601(&cache, stamp, list[i].ev.ns + hdr->walloff, 9);
+      fprintf(out, "[%s] %u %.*s %lld %lld\n", stamp, list[i].ring,
+         TRACE_NAMELEN, hdr->name[list[i].ev.id], list[i].ev.arg[0],
+         list[i].ev.arg[1]);
+   }
+   free(list);
+   free(data);
+
+   return count;
+}
+
+
+#endif /* end _MP_TRACE_H_ */
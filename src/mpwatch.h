@@ -0,0 +1,436 @@
+/* ****************************************************************
+ * Watchdog support, for long lock holds and stalled worker threads.
+ *  - mpwatch.h (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * This file provides a watchdog thread, reporting locks held, and tasks
+ * running without a heartbeat, for longer than a threshold.
+ *
+ * Each watched thread owns a slot, holding the start time of each lock
+ * it holds (up to WATCH_LOCKS), and the time of its last heartbeat.
+ * Times are watchdog ticks; coarse clock milliseconds (coarsenanoseconds()),
+ * published by the watchdog thread once per period (a quarter of the
+ * threshold), such that recording a lock hold or heartbeat never reads
+ * a clock, nor locks, nor performs an atomic read-modify-write; it is
+ * a few stores to a cache line owned by the recording thread.
+ *
+ * Locks are watched by watch_acquired() after acquiring, and
+ * watch_released() before releasing, or by the watch_mutex_*() and
+ * watch_spin_*() wrappers of mpthread.h locks. Workers mark the start of
+ * each task with watch_task(), refresh long running tasks with
+ * watch_beat(), and mark the end of each task with watch_idle(), such
+ * that idle workers (waiting for work) are never reported.
+ *
+ * Once per period, the watchdog thread publishes the tick and scans all
+ * slots, calling the report function once for each lock hold, and each
+ * heartbeat, exceeding the threshold.
+ *
+ * NOTES:
+ * - Support functions requiring a Watchdog param, SHALL be passed as
+ *   pointers. Recording functions accept a NULL Watchdog, and do nothing,
+ *   such that watching is optional at runtime.
+ * - Watched threads are registered with the thread registry (mpthread.h),
+ *   and a thread slot is recycled by the next thread assigned the same
+ *   registry index. The registry is process-wide, such that slots are
+ *   keyed consistently by every translation unit recording into a
+ *   Watchdog. Reports identify threads by registry index.
+ * - A tick lags the coarse clock by up to one period, so durations are
+ *   over-estimated by up to one period. To avoid false reports, a lock
+ *   hold or heartbeat is reported once it exceeds the threshold plus one
+ *   period, i.e. between 1.25 and 1.5 thresholds after it started.
+ * - Lock holds beyond WATCH_LOCKS per thread are not watched. Locks may
+ *   be released in any order.
+ * - Lock and task names are recorded by reference, and SHALL remain
+ *   valid until released, or until the next task, respectively.
+ * - The report function is called by the watchdog thread, once per lock
+ *   hold or heartbeat, and SHALL NOT record lock holds or heartbeats.
+ *
+ * CHANGELOG:
+ * Rev.1   2026-10-18
+ *   Initial Watchdog implementation.
+ * Rev.2   2026-10-18
+ *   Documented slots as keyed by the process-wide thread registry.
+ *
+ * ****************************************************************/
+
+#ifndef _MP_WATCH_H_
+#define _MP_WATCH_H_  /* include guard */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpthread.h"
+#include "mptime.h"
+
+/* Maximum lock holds watched per thread.
+ * May be overridden by defining WATCH_LOCKS before inclusion. */
+#ifndef WATCH_LOCKS
+#define WATCH_LOCKS  8
+#endif
+
+#define WATCH_LOCK  0   /* report of a lock hold */
+#define WATCH_TASK  1   /* report of a task without heartbeat */
+
+/* Slot fields are written by the owning thread and read by the watchdog
+ * thread; release stores publish in order of storing. */
+#ifdef _MSC_VER
+#define watch_acquire(p)    ( *(p) )
+#define watch_release(p,v)  ( *(p) = (v) )
+#else
+#define watch_acquire(p)    __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define watch_release(p,v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+/* Returns the current watchdog tick, in coarse milliseconds (never 0). */
+#define watch_now()  ( (unsigned long) (coarsenanoseconds() / 1000000) | 1 )
+
+/* A report of a lock hold, or task, exceeding the threshold. */
+typedef struct {
+   int kind;               /* WATCH_LOCK or WATCH_TASK */
+   int thread;             /* registry index of the thread */
+   const void *lock;       /* lock address, or NULL for a task */
+   const char *name;       /* lock or task name, may be NULL */
+   unsigned long ms;       /* milliseconds held, or since heartbeat */
+} WatchReport;
+
+/* A report function, called by the watchdog thread. */
+typedef void WatchFunc(void *ctx, const WatchReport *report);
+
+/* A lock hold. The `reported` tick is written by the watchdog only. */
+typedef struct {
+   const void * volatile lock;
+   const char * volatile name;
+   volatile unsigned long since;    /* tick of acquisition, 0 = free */
+   unsigned long reported;
+} WATCH_HOLD;
+
+/* A thread slot, on cache lines of its own. */
+typedef struct {
+   volatile unsigned long beat;     /* tick of heartbeat, 0 = idle */
+   const char * volatile task;
+   unsigned long reported;
+   WATCH_HOLD hold[WATCH_LOCKS];
+   char pad[64];
+} WATCH_SLOT;
+
+/* A watchdog. */
+typedef struct {
+   volatile unsigned long tick;     /* published coarse milliseconds */
+   char pad[64 - sizeof(unsigned long)];
+   WATCH_SLOT *slots[THREAD_REGISTRY_MAX];
+   int nslots;             /* registry index high water mark (+1) */
+   unsigned long threshold, period;
+   WatchFunc *func;
+   void *ctx;
+   long long reports;      /* reports made, read under lock */
+   Mutex lock;
+   Condition wake;         /* signalled to stop the watchdog thread */
+   ThreadID thread;
+   int stop;
+} Watchdog;
+
+/* Report function writing a line per report to a FILE stream `ctx`,
+ * or stderr where `ctx` is NULL. */
+static inline void watch_print(void *ctx, const WatchReport *report)
+{
+   FILE *stream = ctx ? (FILE *) ctx : stderr;
+
+   if(report->kind == WATCH_LOCK) {
+      fprintf(stream, "watchdog: thread %d held lock %s (%p) for %lums\n",
+         report->thread, report->name ? report->name : "?", report->lock,
+         report->ms);
+   } else {
+      fprintf(stream, "watchdog: thread %d running task %s for %lums "
+         "without heartbeat\n", report->thread,
+         report->name ? report->name : "?", report->ms);
+   }
+}
+
+/* Obtain the slot of the current thread, registering the thread
+ * with the thread registry and allocating a slot where necessary.
+ * Returns a pointer to the slot, else NULL on error. */
+static inline WATCH_SLOT *watch_register(Watchdog *wd)
+{
+   WATCH_SLOT *slot;
+   int idx;
+
+   idx = thread_register();
+   if(idx < 0) return NULL;
+
+   mutex_lock(&wd->lock);
+   slot = wd->slots[idx];
+   if(slot == NULL) {
+      slot = (WATCH_SLOT *) calloc(1, sizeof(WATCH_SLOT));
+      if(slot) {
+         wd->slots[idx] = slot;
+         if(wd->nslots <= idx) wd->nslots = idx + 1;
+      }
+   }
+   mutex_unlock(&wd->lock);
+
+   return slot;
+}
+
+/* Obtain the slot of the current thread. (NON-BLOCKING, once allocated)
+ * Returns a pointer to the slot, else NULL on error. */
+static inline WATCH_SLOT *watch_slot(Watchdog *wd)
+{
+   int idx;
+
+   idx = thread_index();
+   if(idx >= 0 && wd->slots[idx]) return wd->slots[idx];
+
+   return watch_register(wd);
+}
+
+/* Record a hold of `lock`, named `name` (may be NULL), acquired by the
+ * current thread. */
+static inline void watch_acquired(Watchdog *wd, const void *lock,
+   const char *name)
+{
+   WATCH_SLOT *slot;
+   int i;
+
+   if(wd == NULL || (slot = watch_slot(wd)) == NULL) return;
+   for(i = 0; i < WATCH_LOCKS; i++) {
+      if(slot->hold[i].since) continue;
+      watch_release(&slot->hold[i].lock, lock);
+      watch_release(&slot->hold[i].name, name);
+      watch_release(&slot->hold[i].since, watch_acquire(&wd->tick));
+      break;
+   }
+}
+
+/* Record the release of `lock`, held by the current thread. */
+static inline void watch_released(Watchdog *wd, const void *lock)
+{
+   WATCH_SLOT *slot;
+   int i;
+
+   if(wd == NULL || (slot = watch_slot(wd)) == NULL) return;
+   for(i = 0; i < WATCH_LOCKS; i++) {
+      if(slot->hold[i].since && slot->hold[i].lock == lock) {
+         watch_release(&slot->hold[i].since, 0);
+         break;
+      }
+   }
+}
+
+/* Mark the start of a task named `name` (may be NULL) by the current
+ * thread, and record a heartbeat. */
+static inline void watch_task(Watchdog *wd, const char *name)
+{
+   WATCH_SLOT *slot;
+
+   if(wd == NULL || (slot = watch_slot(wd)) == NULL) return;
+   watch_release(&slot->beat, 0);
+   watch_release(&slot->task, name);
+   watch_release(&slot->beat, watch_acquire(&wd->tick));
+}
+
+/* Record a heartbeat of the current thread's task. */
+static inline void watch_beat(Watchdog *wd)
+{
+   WATCH_SLOT *slot;
+
+   if(wd == NULL || (slot = watch_slot(wd)) == NULL) return;
+   watch_release(&slot->beat, watch_acquire(&wd->tick));
+}
+
+/* Mark the end of the current thread's task; idle threads are not
+ * reported. */
+static inline void watch_idle(Watchdog *wd)
+{
+   WATCH_SLOT *slot;
+
+   if(wd == NULL || (slot = watch_slot(wd)) == NULL) return;
+   watch_release(&slot->beat, 0);
+}
+
+/* Lock a Mutex, and record the hold.
+ * Returns 0 on success, else error code. */
+static inline int watch_mutex_lock(Watchdog *wd, Mutex *mutex,
+   const char *name)
+{
+   int ecode;
+
+   ecode = mutex_lock(mutex);
+   if(ecode == 0) watch_acquired(wd, mutex, name);
+
+   return ecode;
+}
+
+/* Record the release of a Mutex, and unlock it.
+ * Returns 0 on success, else error code. */
+static inline int watch_mutex_unlock(Watchdog *wd, Mutex *mutex)
+{
+   watch_released(wd, mutex);
+
+   return mutex_unlock(mutex);
+}
+
+/* Lock a Spinlock, and record the hold.
+ * Returns 0 on success, else error code. */
+static inline int watch_spin_lock(Watchdog *wd, Spinlock *spin,
+   const char *name)
+{
+   int ecode;
+
+   ecode = spinlock_lock(spin);
+   if(ecode == 0) watch_acquired(wd, spin, name);
+
+   return ecode;
+}
+
+/* Record the release of a Spinlock, and unlock it.
+ * Returns 0 on success, else error code. */
+static inline int watch_spin_unlock(Watchdog *wd, Spinlock *spin)
+{
+   watch_released(wd, spin);
+
+   return spinlock_unlock(spin);
+}
+
+/* Publish the current tick, and report the lock holds and heartbeats
+ * of all slots exceeding the threshold, not yet reported.
+ * Called by the watchdog thread only. Returns the number of reports. */
+static inline int watch_scan(Watchdog *wd)
+{
+   WATCH_SLOT *slots[THREAD_REGISTRY_MAX];
+   WATCH_SLOT *slot;
+   WATCH_HOLD *hold;
+   WatchReport report;
+   unsigned long now, since, limit;
+   int nslots, count, i, j;
+
+   now = watch_now();
+   watch_release(&wd->tick, now);
+   limit = wd->threshold + wd->period;
+   mutex_lock(&wd->lock);
+   nslots = wd->nslots;
+   memcpy(slots, wd->slots, nslots * sizeof(*slots));
+   mutex_unlock(&wd->lock);
+
+   for(count = i = 0; i < nslots; i++) {
+      if((slot = slots[i]) == NULL) continue;
+      report.thread = i;
+      for(j = 0; j < WATCH_LOCKS; j++) {
+         hold = &slot->hold[j];
+         since = watch_acquire(&hold->since);
+         if(since == 0 || since == hold->reported || now - since <= limit)
+            continue;
+         report.lock = watch_acquire(&hold->lock);
+         report.name = watch_acquire(&hold->name);
+         /* skip a hold released (or replaced) while reading */
+         if(watch_acquire(&hold->since) != since) continue;
+         hold->reported = since;
+         report.kind = WATCH_LOCK;
+         report.ms = now - since;
+         wd->func(wd->ctx, &report);
+         count++;
+      }
+      since = watch_acquire(&slot->beat);
+      if(since == 0 || since == slot->reported || now - since <= limit)
+         continue;
+      report.name = watch_acquire(&slot->task);
+      if(watch_acquire(&slot->beat) != since) continue;
+      slot->reported = since;
+      report.kind = WATCH_TASK;
+      report.lock = NULL;
+      report.ms = now - since;
+      wd->func(wd->ctx, &report);
+      count++;
+   }
+
+   if(count) {
+      mutex_lock(&wd->lock);
+      wd->reports += count;
+      mutex_unlock(&wd->lock);
+   }
+
+   return count;
+}
+
+/* Watchdog thread. Scans once per period until the watchdog is freed. */
+static inline Threaded watch_thread(void *arg)
+{
+   Watchdog *wd;
+
+   wd = (Watchdog *) arg;
+   mutex_lock(&wd->lock);
+   while(!wd->stop) {
+      condition_timedwait(&wd->wake, &wd->lock, wd->period);
+      if(wd->stop) break;
+      mutex_unlock(&wd->lock);
+      watch_scan(wd);
+      mutex_lock(&wd->lock);
+   }
+   mutex_unlock(&wd->lock);
+
+   return Treturn;
+}
+
+/* Initialize a watchdog, reporting lock holds and tasks exceeding
+ * `threshold` milliseconds to `func` (or watch_print(), where NULL) with
+ * context `ctx`, and start its watchdog thread.
+ * Returns 0 on success, else error code. */
+static inline int watch_init(Watchdog *wd, unsigned long threshold,
+   WatchFunc *func, void *ctx)
+{
+   int ecode;
+
+   memset(wd, 0, sizeof(*wd));
+   if(threshold < 1) return EINVAL;
+   wd->threshold = threshold;
+   wd->period = threshold / 4 ? threshold / 4 : 1;
+   wd->func = func ? func : watch_print;
+   wd->ctx = ctx;
+   wd->tick = watch_now();
+   mutex_init(&wd->lock);
+   condition_init(&wd->wake);
+
+   ecode = thread_create(&wd->thread, watch_thread, wd);
+   if(ecode) {
+      condition_free(&wd->wake);
+      mutex_free(&wd->lock);
+   }
+
+   return ecode;
+}
+
+/* Uninitialize a watchdog, stopping its watchdog thread. Watched threads
+ * SHALL NOT record lock holds or heartbeats during, or after, the call.
+ * Returns 0 on success, else error code. */
+static inline int watch_free(Watchdog *wd)
+{
+   int i;
+
+   mutex_lock(&wd->lock);
+   wd->stop = 1;
+   condition_signal(&wd->wake);
+   mutex_unlock(&wd->lock);
+   thread_wait(&wd->thread);
+
+   for(i = 0; i < wd->nslots; i++)
+      free(wd->slots[i]);
+   condition_free(&wd->wake);
+
+   return mutex_free(&wd->lock);
+}
+
+
+#endif /* end _MP_WATCH_H_ */
@@ -0,0 +1,215 @@
+/* ****************************************************************
+ * Core-to-core cache line latency benchmark.
+ *  - corelatency.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * For every pair of processors, pins a pair of threads (one to each
+ * processor) and ping-pongs a single cache line between them, reporting
+ * a matrix of round trip latencies, in nanoseconds. Pairs sharing a core
+ * or cache are cheapest to communicate between, and are candidates for
+ * pinning producer/consumer threads.
+ *
+ * Usage:
+ *   corelatency [rounds]
+ *   (round trips per pair, best of RUNS runs, default ROUNDS)
+ *
+ * NOTES:
+ * - Rows ping, columns pong; the diagonal is not measured, as spinning
+ *   threads sharing a processor measure only the scheduler.
+ * - Matrices are limited to the first CPUMAX processors.
+ * - Requires at least 2 processors, and thread affinity support.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpthread.h"
+#include "../src/mptime.h"
+
+#define ROUNDS  5000  /* round trips per measurement */
+#define RUNS    3     /* measurements per pair, best of */
+#define CPUMAX  64    /* maximum processors measured */
+
+/****************************************************************/
+
+/* A cache line, ping-ponged between two threads. Round `r` is started by
+ * the ping thread storing (2r - 1), and completed by the pong thread
+ * storing 2r; a negative value aborts. Padding keeps neighbouring data
+ * off the cache line. */
+typedef struct {
+   char pad1[64];
+   volatile long line;
+   char pad2[64 - sizeof(long)];
+   volatile int ready;
+   char pad3[64 - sizeof(int)];
+} PINGPONG;
+
+/* Arguments of a ping or pong thread. */
+typedef struct {
+   PINGPONG *pp;
+   int cpu;
+   long rounds;
+   int ecode;
+   long long ns;
+} PAIRARG;
+
+/* Thread function answering rounds, pinned to its processor. */
+Threaded th_pong(void *arg)
+{
+   PAIRARG *pa = (PAIRARG *) arg;
+   PINGPONG *pp = pa->pp;
+   long r, v;
+
+   pa->ecode = thread_setaffinity(pa->cpu);
+   pp->ready = pa->ecode ? -1 : 1;
+   if(pa->ecode) return Treturn;
+   for(r = 1; r <= pa->rounds; r++) {
+      while((v = pp->line) != 2 * r - 1) if(v < 0) return Treturn;
+      pp->line = 2 * r;
+   }
+
+   return Treturn;
+}
+
+/* Thread function starting and timing rounds, pinned to its processor. */
+Threaded th_ping(void *arg)
+{
+   PAIRARG *pa = (PAIRARG *) arg;
+   PINGPONG *pp = pa->pp;
+   long long nstart;
+   long r;
+
+   pa->ecode = thread_setaffinity(pa->cpu);
+   /* wait for the pong thread, and pin, before timing */
+   while(pp->ready == 0);
+   if(pa->ecode || pp->ready < 0) {
+      /* release the pong thread, if waiting */
+      pp->line = -1;
+      return Treturn;
+   }
+   nstart = nanoseconds();
+   for(r = 1; r <= pa->rounds; r++) {
+      pp->line = 2 * r - 1;
+      while(pp->line != 2 * r);
+   }
+   pa->ns = nanoelapsed(nstart);
+
+   return Treturn;
+}
+
+/* Measure the round trip latency between processors `a` and `b`.
+ * Returns the round trip latency in nanoseconds, else -1 on error. */
+double measure(PINGPONG *pp, int a, int b, long rounds)
+{
+   ThreadID tid[2];
+   PAIRARG ping, pong;
+
+   pp->line = 0;
+   pp->ready = 0;
+   ping.pp = pong.pp = pp;
+   ping.rounds = pong.rounds = rounds;
+   ping.cpu = a;
+   pong.cpu = b;
+   ping.ecode = pong.ecode = 0;
+   ping.ns = 0;
+   if(thread_create(&tid[1], th_pong, &pong)) return -1;
+   if(thread_create(&tid[0], th_ping, &ping)) {
+      pp->line = -1;
+      thread_wait(&tid[1]);
+      return -1;
+   }
+   thread_multiwait(tid, 2);
+   if(ping.ecode || pong.ecode) return -1;
+
+   return (double) ping.ns / rounds;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main(int argc, char **argv)
+{
+   static double matrix[CPUMAX][CPUMAX];
+   PINGPONG *pp;
+   double best, ns, min, max;
+   long rounds;
+   int a, b, run, cpus, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Core-to-core Latency benchmark...\n");
+
+   rounds = argc > 1 ? atol(argv[1]) : ROUNDS;
+   if(rounds <= 0) rounds = ROUNDS;
+   cpus = thread_cpucount();
+   if(cpus > CPUMAX) cpus = CPUMAX;
+   printf("\nRound trip latency, %d processors x %ld rounds, ns;\n",
+      cpus, rounds);
+   if(cpus < 2) {
+      printf("  Skipped, requires 2 or more processors.\n");
+      return 0;
+   }
+
+   /* the cache line SHALL NOT share a line with other data */
+   pp = (PINGPONG *) calloc(1, sizeof(PINGPONG));
+   if(pp == NULL) {
+      printf("  Failed. out of memory\n");
+      return 1;
+   }
+   min = max = 0;
+   for(a = 0; a < cpus; a++) {
+      for(b = 0; b < cpus; b++) {
+         if(a == b) continue;
+         for(best = -1, run = 0; run < RUNS; run++) {
+            ns = measure(pp, a, b, rounds);
+            if(ns >= 0 && (best < 0 || ns < best)) best = ns;
+         }
+         matrix[a][b] = best;
+         if(best < 0) continue;
+         if(min == 0 || best < min) min = best;
+         if(best > max) max = best;
+      }
+   }
+   free(pp);
+
+   /* print the matrix, rows ping, columns pong */
+   printf("  cpu");
+   for(b = 0; b < cpus; b++) printf(" %6d", b);
+   printf("\n");
+   for(a = 0; a < cpus; a++) {
+      printf("  %3d", a);
+      for(b = 0; b < cpus; b++) {
+         if(a == b) printf(" %6s", "-");
+         else if(matrix[a][b] < 0) printf(" %6s", "n/a");
+         else printf(" %6.0f", matrix[a][b]);
+      }
+      printf("\n");
+   }
+
+   printf("  Pairs measured... ");
+   if(min > 0)
+      printf("min %.0fns, max %.0fns, Pass!\n", min, max);
+   else {
+      fail++;
+      printf("Failed. no pair could be pinned\n");
+   }
+
+
+   return fail;
+}
@@ -1,7 +1,7 @@
 @echo off
 cls
 ::
-:: Testing makefile (Windows) to compile and test all *.c files.
+:: Testing makefile (Windows) to compile and test all *.c and *.cpp files.
 ::  - makefile.bat (1 June 2020)
 ::
 :: Original work Copyright (c) 2020 Zalamanda
@@ -40,11 +40,35 @@ set LOG="error.log"
 del /f /q %LOG% 1>NUL 2>&1
 
 ::
-:: Build test software
+:: Build test software, linking additional translation units of a
+:: test from unit\<testname>.c (or .cpp), where present
+
+setlocal EnableDelayedExpansion
 
 for %%f in (*.c) do (
    echo | set /p="Building %%~nf test... "
-   cl /nologo /WX /W4 /Fe%%~nf.exe %%~nf.c >>%LOG% 2>&1
+   set UNIT=
+   if exist unit\%%~nf.c set UNIT=unit\%%~nf.c
+   cl /nologo /WX /W4 /Fe%%~nf.exe %%~nf.c !UNIT! >>%LOG% 2>&1
+   if exist %%~nf.exe (
+      echo OK
+
+REM Run software on success
+      start "" /b /wait %%~nf.exe
+
+   ) else (
+      echo Error
+      echo.
+      more %LOG%
+      goto CLEANUP
+   )
+)
+
+for %%f in (*.cpp) do (
+   echo | set /p="Building %%~nf test... "
+   set UNIT=
+   if exist unit\%%~nf.cpp set UNIT=unit\%%~nf.cpp
+   cl /nologo /WX /W4 /EHsc /O2 /std:c++latest /Fe%%~nf.exe %%~nf.cpp !UNIT! >>%LOG% 2>&1
    if exist %%~nf.exe (
       echo OK
 
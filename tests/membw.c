@@ -0,0 +1,198 @@
+/* ****************************************************************
+ * Test memory bandwidth of parallel copy and fill.
+ *  - membw.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * A STREAM-like bandwidth benchmark, at 1..N pinned threads:
+ * - Copy   a = b             pmemcpy()    16 bytes per element
+ * - Fill   a = x             pmemset()     8 bytes per element
+ * - Triad  a = b + s * c     ThreadGroup  24 bytes per element
+ * Each kernel reports the best of RUNS repetitions, in GB/s (10^9 bytes
+ * per second), counting bytes read and written, as STREAM does. The
+ * first row is the calling thread alone, with memcpy(), memset() and a
+ * sequential triad. Arrays should be several times the size of the last
+ * level cache, such that bandwidth is that of main memory.
+ *
+ * Usage:
+ *   membw [megabytes]
+ *   (megabytes per array, default MEGABYTES)
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpalgo.h"
+#include "../src/mptime.h"
+
+#define MEGABYTES  64   /* megabytes per array */
+#define RUNS       5    /* repetitions of each kernel, best reported */
+#define SCALAR     3.0
+
+/****************************************************************/
+
+/* A block of a triad kernel. */
+typedef struct {
+   double *a;
+   const double *b, *c;
+   size_t n;
+} TRIAD;
+
+/* Triad kernel; a = b + s * c. */
+static void triad(double *a, const double *b, const double *c, size_t n)
+{
+   size_t i;
+
+   for(i = 0; i < n; i++) a[i] = b[i] + SCALAR * c[i];
+}
+
+/* Thread function of a triad block. */
+Threaded thread_triad(void *arg)
+{
+   TRIAD *t = (TRIAD *) arg;
+
+   triad(t->a, t->b, t->c, t->n);
+
+   return Treturn;
+}
+
+/* Triad kernel with `threads` pinned threads, splitting `n` elements.
+ * Returns 0 on success, else error code. */
+int ptriad(double *a, const double *b, const double *c, size_t n,
+   int threads)
+{
+   static TRIAD block[256];
+   ThreadGroup group;
+   ThreadAttr attr;
+   size_t lo, hi;
+   int i, ecode, temp;
+
+   if(threads > 256) threads = 256;
+   for(lo = 0, i = 0; i < threads; i++, lo = hi) {
+      hi = n * (size_t) (i + 1) / (size_t) threads;
+      block[i].a = a + lo;
+      block[i].b = b + lo;
+      block[i].c = c + lo;
+      block[i].n = hi - lo;
+   }
+   attr.stacksize = 0;
+   attr.pin = 1;
+   ecode = thread_create_many(&group, threads, thread_triad, block,
+      sizeof(TRIAD), &attr);
+   temp = group_join(&group);
+
+   return ecode ? ecode : temp;
+}
+
+/* Print the bandwidth of the best of `ns` nanoseconds for `bytes`. */
+static void bandwidth(size_t bytes, long long ns)
+{
+   printf(" %8.2f", ns > 0 ? (double) bytes / (double) ns : 0.0);
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main(int argc, char **argv)
+{
+   double *a, *b, *c;
+   long long nstart, ns, best[3];
+   size_t n, bytes, i;
+   int mb, run, res, threads, cpus, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Memory Bandwidth tests...\n");
+
+   mb = argc > 1 ? atoi(argv[1]) : MEGABYTES;
+   if(mb < 1) mb = MEGABYTES;
+   bytes = (size_t) mb << 20;
+   n = bytes / sizeof(double);
+   cpus = thread_cpucount();
+   printf("\nBandwidth w/ %d MB arrays, 1..%d threads - mpalgo.h;\n",
+      mb, cpus);
+   a = (double *) malloc(bytes);
+   b = (double *) malloc(bytes);
+   c = (double *) malloc(bytes);
+   if(!a || !b || !c) {
+      fail++;
+      printf("  Failed. out of memory\n");
+   } else {
+      /* fault in every array, before timing */
+      for(i = 0; i < n; i++) {
+         a[i] = 0.0;
+         b[i] = 1.0;
+         c[i] = 2.0;
+      }
+      printf("  threads   copy GB/s  fill GB/s triad GB/s\n");
+      /* sequential baseline, then every power of two, and the processor
+       * count; threads of 0 denotes the baseline */
+      for(res = 0, threads = 0; threads <= cpus; threads =
+         threads < cpus && threads * 2 > cpus ? cpus :
+         threads ? threads * 2 : 1) {
+         best[0] = best[1] = best[2] = 0;
+         for(run = 0; run < RUNS; run++) {
+            nstart = nanoseconds();
+            if(threads) pmemcpy(a, b, bytes, threads);
+            else memcpy(a, b, bytes);
+            ns = nanoelapsed(nstart);
+            if(best[0] == 0 || ns < best[0]) best[0] = ns;
+            nstart = nanoseconds();
+            if(threads) pmemset(a, 0, bytes, threads);
+            else memset(a, 0, bytes);
+            ns = nanoelapsed(nstart);
+            if(best[1] == 0 || ns < best[1]) best[1] = ns;
+            nstart = nanoseconds();
+            if(threads) res += ptriad(a, b, c, n, threads) != 0;
+            else triad(a, b, c, n);
+            ns = nanoelapsed(nstart);
+            if(best[2] == 0 || ns < best[2]) best[2] = ns;
+         }
+         /* the triad is last; a = 1 + 3 * 2 */
+         for(i = 0; i < n; i++) if(a[i] != 7.0) break;
+         res += i < n;
+         if(threads) printf("  %7d", threads);
+         else printf("  libc   ");
+         bandwidth(bytes * 2, best[0]);
+         printf("  ");
+         bandwidth(bytes, best[1]);
+         printf("  ");
+         bandwidth(bytes * 3, best[2]);
+         printf("\n");
+      }
+      /* verify copy and fill contents, outside of timing */
+      pmemcpy(a, c, bytes, cpus);
+      for(i = 0; i < n; i++) if(a[i] != 2.0) break;
+      res += i < n;
+      pmemset(a, 0, bytes, cpus);
+      for(i = 0; i < n; i++) if(a[i] != 0.0) break;
+      res += i < n;
+      printf("  Copied, filled and computed...  ");
+      if(res == 0) printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed.\n");
+      }
+   }
+   free(c);
+   free(b);
+   free(a);
+
+
+   return fail;
+}
@@ -0,0 +1,75 @@
+/* ****************************************************************
+ * Metrics file reader tool.
+ *  - metricsdump.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Attaches (read-only) a metrics file written by another process, and
+ * dumps its metrics in the Prometheus text format, either once, or
+ * repeatedly at an interval. The writing process is never signalled,
+ * locked, or otherwise interrupted.
+ *
+ * Usage:
+ *   metricsdump <file> [interval_ms [count]]
+ *   (a count of 0 dumps indefinitely, default 1 without an interval)
+ *
+ * NOTES:
+ * - Run without arguments (as by the testing makefiles), the tool
+ *   prints its usage and exits successfully.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpmetrics.h"
+#include "../src/mptime.h"
+
+/****************************************************************/
+
+/* Returns 0 on success, else 1 */
+int main(int argc, char **argv)
+{
+   Metrics m;
+   long interval, count;
+   int res;
+
+   if(argc < 2) {
+      printf("\nMetrics file reader tool, usage:\n");
+      printf("  metricsdump <file> [interval_ms [count]]\n");
+      return 0;
+   }
+
+   /* a count of zero dumps at the interval indefinitely */
+   interval = argc > 2 ? atol(argv[2]) : 0;
+   count = argc > 3 ? atol(argv[3]) : (interval ? 0 : 1);
+   res = metrics_attach(&m, argv[1]);
+   if(res) {
+      fprintf(stderr, "metricsdump: %s: %s\n", argv[1], strerror(res));
+      return 1;
+   }
+   for( ; ; ) {
+      metrics_dump(&m, stdout);
+      fflush(stdout);
+      if(count > 0 && --count == 0) break;
+      millisleep((unsigned long) interval);
+      printf("\n");
+   }
+   metrics_close(&m);
+
+   return 0;
+}
@@ -0,0 +1,411 @@
+/* ****************************************************************
+ * Test parallel algorithm support.
+ *  - mpalgo.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Parallel sort and prefix scan:
+ * - Sorted output equal to qsort(), across sizes, grains and pools
+ * - Sort of large elements, and of heavily duplicated keys
+ * - Inclusive and exclusive scans, in and out of place, with a non
+ *   commutative operation
+ * - Parallel copy and fill equal to memcpy() and memset(), across sizes,
+ *   alignments and thread counts, with and without streaming stores
+ * - Speedup of psort() versus qsort(), and of scans versus a sequential
+ *   scan, at 1..N threads
+ * (see membw.c for the bandwidth of parallel copy and fill)
+ *
+ * Usage:
+ *   mpalgo [elements]
+ *   (elements of the speedup benchmark, default ELEMENTS)
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+/* exercise streaming stores regardless of cache size */
+#define ALGO_STREAM  (8L << 20)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpalgo.h"
+#include "../src/mptime.h"
+
+#define ELEMENTS  2000000  /* elements of the speedup benchmark */
+#define CHECKS    200000   /* elements of correctness checks */
+#define THREADS   4
+
+/****************************************************************/
+
+/* A large element, sorted by key. */
+typedef struct {
+   unsigned key;
+   unsigned id;
+   char pad[56];
+} RECORD;
+
+/* An affine function f(x) = a*x + b, composed by scans. Composition is
+ * associative, but not commutative. */
+typedef struct {
+   unsigned long long a, b;
+} AFFINE;
+
+static unsigned long long Seed = 1;
+
+/* Pseudo random number generator (splitmix64). */
+unsigned long long rnd(void)
+{
+   unsigned long long z = (Seed += 0x9e3779b97f4a7c15ULL);
+
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+}
+
+int cmp_uint(const void *a, const void *b)
+{
+   unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+
+   return (x > y) - (x < y);
+}
+
+int cmp_record(const void *a, const void *b)
+{
+   return cmp_uint(&((const RECORD *) a)->key, &((const RECORD *) b)->key);
+}
+
+void op_sum(void *acc, const void *elem)
+{
+   *(long long *) acc += *(const long long *) elem;
+}
+
+/* acc = elem(acc(x)), applying acc first */
+void op_affine(void *acc, const void *elem)
+{
+   AFFINE *f = (AFFINE *) acc;
+   const AFFINE *g = (const AFFINE *) elem;
+
+   f->b = (g->a * f->b) + g->b;
+   f->a = g->a * f->a;
+}
+
+/* Sort `n` random keys (modulo `mod`, or unbounded if 0) with psort(),
+ * comparing with qsort(). Returns 0 on equal output, else non-zero. */
+int check_sort(ThreadPool *pool, size_t n, unsigned mod, size_t grain)
+{
+   unsigned *a, *b;
+   size_t i;
+   int res;
+
+   a = (unsigned *) malloc(sizeof(unsigned) * (n + 1));
+   b = (unsigned *) malloc(sizeof(unsigned) * (n + 1));
+   if(a == NULL || b == NULL) res = 1;
+   else {
+      for(i = 0; i < n; i++)
+         a[i] = b[i] = mod ? (unsigned) (rnd() % mod) : (unsigned) rnd();
+      res = psort(pool, a, n, sizeof(unsigned), cmp_uint, grain);
+      qsort(b, n, sizeof(unsigned), cmp_uint);
+      if(res == 0) res = memcmp(a, b, sizeof(unsigned) * n) != 0;
+   }
+   free(b);
+   free(a);
+
+   return res;
+}
+
+/* Sort `n` large records by key, verifying order and that every record
+ * remains. Returns 0 on success, else non-zero. */
+int check_records(ThreadPool *pool, size_t n)
+{
+   RECORD *r;
+   char *seen;
+   size_t i;
+   int res;
+
+   r = (RECORD *) malloc(sizeof(RECORD) * n);
+   seen = (char *) calloc(n, 1);
+   if(r == NULL || seen == NULL) res = 1;
+   else {
+      for(i = 0; i < n; i++) {
+         r[i].key = (unsigned) (rnd() % 1000);
+         r[i].id = (unsigned) i;
+      }
+      res = psort(pool, r, n, sizeof(RECORD), cmp_record, 1000);
+      for(i = 0; res == 0 && i < n; i++) {
+         if(i && r[i - 1].key > r[i].key) res = 1;
+         else if(r[i].id >= n || seen[r[i].id]++) res = 1;
+      }
+   }
+   free(seen);
+   free(r);
+
+   return res;
+}
+
+/* Scan `n` elements of a sum and an affine composition, inclusively and
+ * exclusively, in and out of place, comparing with sequential scans.
+ * Returns the number of mismatched scans. */
+int check_scan(ThreadPool *pool, size_t n, size_t grain)
+{
+   static const AFFINE identity = { 1, 0 };
+   static const long long zero = 0;
+   long long *in, *out, *inplace, sum;
+   AFFINE *fin, *fout, f;
+   size_t i;
+   int bad;
+
+   bad = 0;
+   in = (long long *) malloc(sizeof(long long) * n);
+   out = (long long *) malloc(sizeof(long long) * n);
+   inplace = (long long *) malloc(sizeof(long long) * n);
+   fin = (AFFINE *) malloc(sizeof(AFFINE) * n);
+   fout = (AFFINE *) malloc(sizeof(AFFINE) * n);
+   if(!in || !out || !inplace || !fin || !fout) bad = 4;
+   else {
+      for(i = 0; i < n; i++) {
+         in[i] = inplace[i] = (long long) (rnd() % 2001) - 1000;
+         fin[i].a = rnd() | 1;
+         fin[i].b = rnd();
+      }
+      /* inclusive sum, out of place and in place */
+      bad += pscan_inclusive(pool, in, out, n, sizeof(long long), op_sum,
+         grain) != 0;
+      pscan_inclusive(pool, inplace, inplace, n, sizeof(long long), op_sum,
+         grain);
+      for(sum = 0, i = 0; i < n; i++) {
+         sum += in[i];
+         if(out[i] != sum || inplace[i] != sum) break;
+      }
+      bad += i < n;
+      /* exclusive sum, in place */
+      memcpy(inplace, in, sizeof(long long) * n);
+      pscan_exclusive(pool, inplace, inplace, n, sizeof(long long), op_sum,
+         &zero, grain);
+      for(sum = 0, i = 0; i < n; i++) {
+         if(inplace[i] != sum) break;
+         sum += in[i];
+      }
+      bad += i < n;
+      /* exclusive affine composition; order sensitive */
+      pscan_exclusive(pool, fin, fout, n, sizeof(AFFINE), op_affine,
+         &identity, grain);
+      for(f = identity, i = 0; i < n; i++) {
+         if(fout[i].a != f.a || fout[i].b != f.b) break;
+         op_affine(&f, &fin[i]);
+      }
+      bad += i < n;
+   }
+   free(fout);
+   free(fin);
+   free(inplace);
+   free(out);
+   free(in);
+
+   return bad;
+}
+
+/* Copy and fill `n` bytes at offsets `off` (source) and `doff`
+ * (destination) with `threads` threads, checking every byte, and the
+ * guard bytes either side of the destination.
+ * Returns the number of mismatched operations. */
+int check_memory(size_t n, size_t off, size_t doff, int threads)
+{
+   unsigned char *src, *dst;
+   size_t i;
+   int bad;
+
+   bad = 0;
+   src = (unsigned char *) malloc(n + off);
+   dst = (unsigned char *) malloc(n + doff + 1);
+   if(!src || !dst) bad = 2;
+   else {
+      for(i = 0; i < n; i++) src[off + i] = (unsigned char) rnd();
+      memset(dst, 0xA5, n + doff + 1);
+      pmemcpy(dst + doff, src + off, n, threads);
+      bad += memcmp(dst + doff, src + off, n) != 0;
+      bad += (doff && dst[doff - 1] != 0xA5) || dst[doff + n] != 0xA5;
+      pmemset(dst + doff, 0x3C, n, threads);
+      for(i = 0; i < n; i++) if(dst[doff + i] != 0x3C) break;
+      bad += i < n;
+      bad += (doff && dst[doff - 1] != 0xA5) || dst[doff + n] != 0xA5;
+   }
+   free(dst);
+   free(src);
+
+   return bad;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main(int argc, char **argv)
+{
+   static const size_t sizes[] = { 0, 1, 2, 3, 1000, 4096, 4097, 99999 };
+   static const size_t grains[] = { 0, 1, 7, 1000 };
+   ThreadPool pool, *pp;
+   unsigned *data, *work;
+   long long *sdata, *sout;
+   long long nstart, base, sbase, ns;
+   size_t n, i, j;
+   int res, threads, cpus, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Parallel Algorithm tests...\n");
+
+   if(pool_init(&pool, THREADS)) {
+      printf("\n  Failed. pool_init()\n");
+      return 1;
+   }
+
+
+   printf("\nParallel sort w/ %d threads - mpalgo.h;\n", THREADS);
+   printf("  Sizes and grains vs. qsort()... ");
+   for(res = 0, i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+      for(j = 0; j < sizeof(grains) / sizeof(*grains); j++)
+         res += check_sort(&pool, sizes[i], 0, grains[j]);
+   }
+   res += check_sort(NULL, 1000, 0, 1);
+   res += check_sort(&pool, CHECKS, 0, 0);
+   if(res == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d\n", res);
+   }
+   printf("  Duplicate keys...               ");
+   res = check_sort(&pool, CHECKS, 3, 0) + check_sort(&pool, CHECKS, 1, 0);
+   if(res == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  %d byte records...              ", (int) sizeof(RECORD));
+   if(check_records(&pool, CHECKS) == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nParallel scan w/ %d threads - mpalgo.h;\n", THREADS);
+   printf("  Inclusive and exclusive...      ");
+   for(res = 0, i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+      if(sizes[i] == 0) continue;
+      for(j = 0; j < sizeof(grains) / sizeof(*grains); j++)
+         res += check_scan(&pool, sizes[i], grains[j]);
+   }
+   res += check_scan(NULL, 1000, 1);
+   res += check_scan(&pool, CHECKS, 0);
+   if(res == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d\n", res);
+   }
+   pool_free(&pool);
+
+
+   printf("\nParallel copy and fill - mpalgo.h;\n");
+   printf("  Sizes and alignments...         ");
+   for(res = 0, i = 0; i < 4; i++) {
+      for(threads = 0; threads <= THREADS; threads += 2) {
+         res += check_memory(i * 7, i, 3 - i, threads);
+         res += check_memory(ALGO_MINCOPY * 3 + i * 33, i, 3 - i,
+            threads);
+      }
+   }
+   if(res == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d\n", res);
+   }
+   printf("  Streaming stores...             ");
+   res = check_memory(ALGO_STREAM + 4097, 5, 3, 1);
+   res += check_memory(ALGO_STREAM + 4097, 0, 11, THREADS);
+   if(res == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d\n", res);
+   }
+
+
+   n = argc > 1 ? (size_t) atol(argv[1]) : ELEMENTS;
+   if(n < 1) n = ELEMENTS;
+   cpus = thread_cpucount();
+   printf("\nSpeedup w/ %lu elements, 1..%d threads - mpalgo.h;\n",
+      (unsigned long) n, cpus);
+   data = (unsigned *) malloc(sizeof(unsigned) * n);
+   work = (unsigned *) malloc(sizeof(unsigned) * n);
+   sdata = (long long *) malloc(sizeof(long long) * n);
+   sout = (long long *) malloc(sizeof(long long) * n);
+   if(!data || !work || !sdata || !sout) {
+      fail++;
+      printf("  Failed. out of memory\n");
+   } else {
+      for(i = 0; i < n; i++) {
+         data[i] = (unsigned) rnd();
+         sdata[i] = (long long) (rnd() % 1000);
+      }
+      /* fault in the scan output, before timing */
+      memset(sout, 0, sizeof(long long) * n);
+      printf("  threads       sort   speedup       scan   speedup\n");
+      memcpy(work, data, sizeof(unsigned) * n);
+      nstart = nanoseconds();
+      qsort(work, n, sizeof(unsigned), cmp_uint);
+      base = nanoelapsed(nstart);
+      nstart = nanoseconds();
+      pscan_inclusive(NULL, sdata, sout, n, sizeof(long long), op_sum, 0);
+      sbase = nanoelapsed(nstart);
+      printf("  qsort   %8.1fms     1.00x %8.1fms     1.00x\n",
+         (double) base / 1000000, (double) sbase / 1000000);
+      /* measure every power of two, and the processor count */
+      for(res = 0, threads = 1; threads <= cpus;
+         threads = threads < cpus && threads * 2 > cpus ? cpus : threads * 2) {
+         pp = pool_init(&pool, threads) ? NULL : &pool;
+         if(pp == NULL) {
+            res++;
+            break;
+         }
+         memcpy(work, data, sizeof(unsigned) * n);
+         nstart = nanoseconds();
+         res += psort(pp, work, n, sizeof(unsigned), cmp_uint, 0);
+         ns = nanoelapsed(nstart);
+         for(i = 1; i < n; i++) if(work[i - 1] > work[i]) break;
+         res += i < n;
+         printf("  %7d %8.1fms %8.2fx", threads, (double) ns / 1000000,
+            (double) base / (double) ns);
+         nstart = nanoseconds();
+         res += pscan_inclusive(pp, sdata, sout, n, sizeof(long long),
+            op_sum, 0);
+         ns = nanoelapsed(nstart);
+         printf(" %8.1fms %8.2fx\n", (double) ns / 1000000,
+            (double) sbase / (double) ns);
+         pool_free(pp);
+      }
+      printf("  Sorted and scanned...           ");
+      if(res == 0) printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed.\n");
+      }
+   }
+   free(sout);
+   free(sdata);
+   free(work);
+   free(data);
+
+
+   return fail;
+}
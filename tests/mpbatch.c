@@ -0,0 +1,279 @@
+/* ****************************************************************
+ * Test micro-batching support.
+ *  - mpbatch.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Micro-batcher:
+ * - Every item of many appending threads flushed exactly once, and in
+ *   order of appending per thread
+ * - Batches flushed by count, before any deadline
+ * - A lone item flushed by deadline, within tolerance of the deadline
+ * - batch_flush() of a partial batch
+ * - Throughput versus added latency (append to flush), at saturating
+ *   and light load, across capacities and deadlines
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpbatch.h"
+
+#define THREADS     4
+#define ITEMS       100000     /* items per thread, correctness */
+#define BENCH_MS    200        /* duration of each benchmark run */
+#define LIGHT_US    200        /* interval of light load appends */
+#define DEADLINE_US 2000
+#define TOLERANCE   20000      /* deadline tolerance, microseconds */
+
+/****************************************************************/
+
+/* An item; the appending thread and its sequence number, and the
+ * nanoseconds() of appending. */
+typedef struct {
+   int thread;
+   int seq;
+   long long ns;
+} ITEM;
+
+/* Flush state of the correctness and benchmark tests. Written only by
+ * the flusher thread, and read after the batcher is flushed. */
+typedef struct {
+   int next[THREADS];   /* next expected sequence number per thread */
+   long long flushed;   /* items flushed */
+   long long errors;    /* duplicated or reordered items */
+   long long latency;   /* sum of append to flush nanoseconds */
+   long long maximum;   /* maximum append to flush nanoseconds */
+   long long stamp;     /* microseconds() of the last flush */
+   long batches, largest;
+} FLUSH;
+
+/* Appending thread arguments. */
+typedef struct {
+   Batcher *b;
+   int thread;
+   int items;           /* items to append, or 0 for BENCH_MS */
+   long interval;       /* microseconds between appends, or 0 */
+   int appended;
+} APPENDER;
+
+/* Flush function recording order, count and latency of items. */
+void flush_items(void *ctx, void *items, long count)
+{
+   FLUSH *f = (FLUSH *) ctx;
+   ITEM *item = (ITEM *) items;
+   long long now, ns;
+   long i;
+
+   now = nanoseconds();
+   f->stamp = microseconds();
+   f->batches++;
+   if(count > f->largest) f->largest = count;
+   for(i = 0; i < count; i++) {
+      if(item[i].seq != f->next[item[i].thread]) f->errors++;
+      f->next[item[i].thread] = item[i].seq + 1;
+      ns = now - item[i].ns;
+      f->latency += ns;
+      if(ns > f->maximum) f->maximum = ns;
+   }
+   f->flushed += count;
+}
+
+/* Thread appending items, for a count or a duration. */
+Threaded thread_append(void *arg)
+{
+   APPENDER *a = (APPENDER *) arg;
+   ITEM item;
+   long mstart, ustart;
+
+   item.thread = a->thread;
+   item.seq = 0;
+   mstart = milliseconds();
+   for(ustart = microseconds(); ; ) {
+      if(a->items ? item.seq >= a->items :
+         millielapsed(mstart) >= BENCH_MS) break;
+      if(a->interval) {
+         /* pace appends, without accumulating lag */
+         while(microelapsed(ustart) < a->interval) spin_yield();
+         ustart += a->interval;
+      }
+      item.ns = nanoseconds();
+      batch_append(a->b, &item);
+      item.seq++;
+   }
+   a->appended = item.seq;
+
+   return Treturn;
+}
+
+/* Append with `threads` threads, each appending `items` items (or for
+ * BENCH_MS), every `interval` microseconds (or unpaced).
+ * Returns total items appended, or -1 on error. */
+long long run(Batcher *b, int threads, int items, long interval)
+{
+   ThreadID tid[THREADS];
+   APPENDER app[THREADS];
+   long long total;
+   int i;
+
+   for(i = 0; i < threads; i++) {
+      app[i].b = b;
+      app[i].thread = i;
+      app[i].items = items;
+      app[i].interval = interval;
+      app[i].appended = 0;
+      if(thread_create(&tid[i], thread_append, &app[i])) return -1;
+   }
+   for(total = 0, i = 0; i < threads; i++) {
+      thread_wait(&tid[i]);
+      total += app[i].appended;
+   }
+
+   return total;
+}
+
+/* Returns the items flushed by a batcher, synchronizing with the flush
+ * function for the caller. */
+long long flushed(Batcher *b)
+{
+   long long items;
+
+   mutex_lock(&b->lock);
+   items = b->items;
+   mutex_unlock(&b->lock);
+
+   return items;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   static const long capacities[] = { 16, 256, 4096 };
+   static const long delays[] = { 100, 1000, 10000 };
+   Batcher b;
+   FLUSH f;
+   ITEM item;
+   long long total, ns;
+   long ustart;
+   size_t i, j;
+   int load, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Micro-batcher tests...\n");
+
+
+   printf("\nMicro-batcher w/ %d threads - mpbatch.h;\n", THREADS);
+   printf("  Items flushed once, in order... ");
+   memset(&f, 0, sizeof(f));
+   if(batch_init(&b, sizeof(ITEM), 100, 1000, flush_items, &f)) {
+      printf("Failed. batch_init()\n");
+      return 1;
+   }
+   total = run(&b, THREADS, ITEMS, 0);
+   batch_free(&b);
+   if(total == (long long) THREADS * ITEMS && f.flushed == total &&
+      f.errors == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. flushed %lld/%lld, errors= %lld\n",
+         f.flushed, total, f.errors);
+   }
+
+   printf("  Batches flushed by count...     ");
+   memset(&f, 0, sizeof(f));
+   batch_init(&b, sizeof(ITEM), 64, 1000000, flush_items, &f);
+   run(&b, 1, 640, 0);
+   /* allow all full batches to flush */
+   for(ustart = microseconds(); flushed(&b) < 640 &&
+      microelapsed(ustart) < 100000; ) millisleep(1);
+   if(f.flushed == 640 && f.batches == 10 && b.deadlines == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %lld items, %ld batches, %lld deadlines\n",
+         f.flushed, f.batches, b.deadlines);
+   }
+   batch_free(&b);
+
+   printf("  Lone item flushed by deadline...");
+   memset(&f, 0, sizeof(f));
+   memset(&item, 0, sizeof(item));
+   batch_init(&b, sizeof(ITEM), 1024, DEADLINE_US, flush_items, &f);
+   ustart = microseconds();
+   batch_append(&b, &item);
+   while(flushed(&b) == 0 && microelapsed(ustart) < 1000000) millisleep(1);
+   ns = f.stamp - ustart;
+   printf(" %ldus ", (long) ns);
+   if(f.flushed == 1 && b.deadlines == 1 && ns >= DEADLINE_US &&
+      ns < DEADLINE_US + TOLERANCE) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   printf("  Partial batch flush...          ");
+   item.seq = 1;
+   batch_append(&b, &item);
+   batch_flush(&b);
+   if(f.flushed == 2) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   batch_free(&b);
+
+
+   printf("\nThroughput vs. added latency w/ %d threads - mpbatch.h;\n",
+      THREADS);
+   printf("  load  capacity   delay   Mitems/s   avg/batch"
+      "   mean lat    max lat\n");
+   for(load = 0; load < 2; load++) {
+      for(i = 0; i < sizeof(capacities) / sizeof(*capacities); i++) {
+         for(j = 0; j < sizeof(delays) / sizeof(*delays); j++) {
+            memset(&f, 0, sizeof(f));
+            if(batch_init(&b, sizeof(ITEM), capacities[i], delays[j],
+               flush_items, &f)) {
+               fail++;
+               printf("  Failed. batch_init()\n");
+               break;
+            }
+            ustart = microseconds();
+            total = run(&b, THREADS, 0, load ? LIGHT_US : 0);
+            ns = (long long) microelapsed(ustart) * 1000;
+            batch_free(&b);
+            printf("  %-5s %8ld %6ldus %10.2f %11.1f %8.1fus %8.1fus\n",
+               load ? "light" : "full", capacities[i], delays[j],
+               (double) total * 1000.0 / (double) ns,
+               f.batches ? (double) f.flushed / (double) f.batches : 0.0,
+               f.flushed ? (double) f.latency / (double) f.flushed / 1000 :
+               0.0, (double) f.maximum / 1000);
+            if(total < 0 || f.flushed != total || f.errors) {
+               fail++;
+               printf("  Failed. flushed %lld/%lld, errors= %lld\n",
+                  f.flushed, total, f.errors);
+            }
+         }
+      }
+   }
+
+
+   return fail;
+}
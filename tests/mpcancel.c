@@ -0,0 +1,370 @@
+/* ****************************************************************
+ * Test multiplatform cooperative cancellation.
+ *  - mpcancel.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Multiplatform cooperative cancellation:
+ * - Polling, sleeping and condition waiting raw threads
+ * - Callback registration order and unregistration
+ * - Cancellation of pool tasks and task scopes
+ * - Thread groups; per index arguments, pinning, group cancellation,
+ *   and spawn errors
+ * - Group tokens observed by group functions of another translation
+ *   unit, linked with unit/mpcancel.c
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/mpcancel.h"
+#include "../src/mppool.h"
+#include "../src/mptime.h"
+
+#define LONGWAIT   10000  /* milliseconds, never expected to elapse */
+#define CANCELAT   20     /* milliseconds before cancellation */
+#define PROMPT_MS  500    /* maximum milliseconds to observe cancel */
+#define GROUP      256    /* threads per group */
+
+/****************************************************************/
+
+/* Struct for passing cancellation arguments to thread function. */
+typedef struct {
+   CancelToken token;
+   Mutex lock;
+   Condition cond;
+   int method;
+   int result;
+   long polls;
+} CTState;
+
+/* Struct for recording the order of executed callbacks. */
+typedef struct {
+   char order[8];
+   int len;
+} CBState;
+
+/* Struct for passing per index arguments to group threads. */
+typedef struct {
+   int index;
+   int result;
+} GRArg;
+
+GRArg Grs[GROUP];
+CancelToken *Tokens[GROUP];
+
+/* Group thread function of the second translation unit */
+Threaded unit_group_token(void *arg);
+
+/* Group thread function recording its index, and group token. */
+Threaded grs_index(void *arg)
+{
+   GRArg *gr = (GRArg *) arg;
+
+   gr->result = (gr - Grs) == gr->index && group_token() != NULL;
+
+   return Treturn;
+}
+
+/* Group thread function sleeping until cancellation of its group. */
+Threaded grs_sleep(void *arg)
+{
+   GRArg *gr = (GRArg *) arg;
+
+   gr->result = cancel_sleep(group_token(), LONGWAIT);
+
+   return Treturn;
+}
+
+/* Thread function blocking until cancellation, by various methods. */
+Threaded cts_work(void *arg)
+{
+   CTState *cts;
+
+   cts = (CTState *) arg;
+
+   switch(cts->method) {
+      case 0:
+         while(!cancel_requested(&cts->token)) cts->polls++;
+         cts->result = ECANCELED;
+         break;
+      case 1:
+         cts->result = cancel_sleep(&cts->token, LONGWAIT);
+         break;
+      case 2:
+         mutex_lock(&cts->lock);
+         cts->result = cancel_condwait(&cts->token, &cts->cond, &cts->lock,
+            LONGWAIT);
+         mutex_unlock(&cts->lock);
+         break;
+   }
+
+   return Treturn;
+}
+
+/* Global record of executed callbacks. */
+CBState Cbs;
+
+/* Cancellation callback appending a character to the global record. */
+void cb_append(void *arg)
+{
+   Cbs.order[Cbs.len++] = *((char *) arg);
+}
+
+/* Task function polling the token of its task until cancelled. */
+int task_poll(void *arg)
+{
+   (void) arg;
+
+   while(!cancel_requested(task_token()))
+      millisleep(1);
+
+   return ECANCELED;
+}
+
+/* Task function sleeping with the token of its task, failing fast
+ * when its argument is non-NULL. */
+int task_sleep(void *arg)
+{
+   if(arg) return EIO;
+
+   return cancel_sleep(task_token(), LONGWAIT);
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   static char *names[] = {
+      "Polling thread...           ",
+      "Sleeping thread...          ",
+      "Condition waiting thread... "
+   };
+   CancelCallback cb[3];
+   ThreadGroup group;
+   ThreadAttr attr;
+   CancelToken *token;
+   CTState cts;
+   ThreadPool pool;
+   TaskScope scope;
+   ThreadID tid;
+   long mstart, elapsed;
+   int i, res, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Multiplatform Cancellation tests...\n");
+
+
+   printf("\nRaw thread cancellation - mpcancel.h;\n");
+   for(i = 0; i < 3; i++) {
+      printf("  %s", names[i]);
+      memset(&cts, 0, sizeof(cts));
+      cancel_init(&cts.token);
+      mutex_init(&cts.lock);
+      condition_init(&cts.cond);
+      cts.method = i;
+      thread_create(&tid, cts_work, &cts);
+      millisleep(CANCELAT);
+      mstart = milliseconds();
+      cancel_request(&cts.token);
+      thread_wait(&tid);
+      elapsed = millielapsed(mstart);
+      printf("woke in %ldms, ", elapsed);
+      if(cts.result == ECANCELED && elapsed < PROMPT_MS)
+         printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed. result= %d\n", cts.result);
+      }
+      condition_free(&cts.cond);
+      mutex_free(&cts.lock);
+      cancel_free(&cts.token);
+   }
+
+   printf("  Timed waits elapse uncancelled... ");
+   cancel_init(&cts.token);
+   mutex_init(&cts.lock);
+   condition_init(&cts.cond);
+   res = cancel_sleep(&cts.token, 5);
+   mutex_lock(&cts.lock);
+   res |= (cancel_condwait(&cts.token, &cts.cond, &cts.lock, 5) != ETIMEDOUT);
+   mutex_unlock(&cts.lock);
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   condition_free(&cts.cond);
+   mutex_free(&cts.lock);
+   cancel_free(&cts.token);
+
+
+   printf("\nCancellation callbacks - mpcancel.h;\n");
+   printf("  Registration order and unregister... ");
+   cancel_init(&cts.token);
+   memset(&Cbs, 0, sizeof(Cbs));
+   cancel_register(&cts.token, &cb[0], cb_append, "a");
+   cancel_register(&cts.token, &cb[1], cb_append, "b");
+   cancel_register(&cts.token, &cb[2], cb_append, "c");
+   cancel_unregister(&cts.token, &cb[1]);
+   cancel_request(&cts.token);
+   cancel_request(&cts.token);
+   if(strcmp(Cbs.order, "ac") == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. order= %s\n", Cbs.order);
+   }
+
+   printf("  Register after cancellation...       ");
+   res = cancel_register(&cts.token, &cb[0], cb_append, "d");
+   if(res == ECANCELED && strcmp(Cbs.order, "ac") == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d\n", res);
+   }
+   cancel_free(&cts.token);
+
+
+   printf("\nPool task cancellation - mpcancel.h;\n");
+   printf("  Scope error wakes sleeping siblings... ");
+   pool_init(&pool, 4);
+   mstart = milliseconds();
+   scope_init(&scope, &pool);
+   for(i = 0; i < 3; i++)
+      scope_spawn(&scope, task_sleep, NULL);
+   millisleep(CANCELAT);
+   scope_spawn(&scope, task_sleep, &scope);
+   res = scope_join(&scope);
+   elapsed = millielapsed(mstart);
+   if(res == EIO && elapsed < CANCELAT + PROMPT_MS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d, elapsed= %ldms\n", res, elapsed);
+   }
+
+   printf("  Pool cancellation stops all tasks...   ");
+   scope_init(&scope, &pool);
+   for(i = 0; i < 2; i++) {
+      scope_spawn(&scope, task_sleep, NULL);
+      pool_submit(&pool, task_poll, NULL);
+   }
+   millisleep(CANCELAT);
+   mstart = milliseconds();
+   pool_cancel(&pool);
+   res = scope_join(&scope);
+   pool_free(&pool);
+   elapsed = millielapsed(mstart);
+   if(res == ECANCELED && elapsed < PROMPT_MS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d, elapsed= %ldms\n", res, elapsed);
+   }
+
+
+   printf("\nThread groups w/ %d threads - mpcancel.h;\n", GROUP);
+   printf("  Per index arguments...        ");
+   memset(Grs, 0, sizeof(Grs));
+   for(i = 0; i < GROUP; i++) Grs[i].index = i;
+   res = thread_create_many(&group, GROUP, grs_index, Grs, sizeof(GRArg),
+      NULL);
+   res |= group_join(&group);
+   for(i = 0; i < GROUP && Grs[i].result == 1; i++);
+   if(res == 0 && i == GROUP)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d, ran= %d\n", res, i);
+   }
+
+   printf("  Pinned, with small stacks...  ");
+   attr.stacksize = 65536;
+   attr.pin = 1;
+   res = thread_setaffinity(-1);
+   if(res == ENOTSUP)
+      printf("Skipped, unsupported.\n");
+   else {
+      memset(Grs, 0, sizeof(Grs));
+      for(i = 0; i < GROUP; i++) Grs[i].index = i;
+      res = thread_create_many(&group, GROUP, grs_index, Grs, sizeof(GRArg),
+         &attr);
+      res |= group_join(&group);
+      for(i = 0; i < GROUP && Grs[i].result == 1; i++);
+      if(res == 0 && i == GROUP)
+         printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed. res= %d, ran= %d\n", res, i);
+      }
+   }
+
+   printf("  Group cancellation...         ");
+   memset(Grs, 0, sizeof(Grs));
+   res = thread_create_many(&group, GROUP, grs_sleep, Grs, sizeof(GRArg),
+      NULL);
+   millisleep(CANCELAT);
+   mstart = milliseconds();
+   group_cancel(&group);
+   res |= group_join(&group);
+   elapsed = millielapsed(mstart);
+   for(i = 0; i < GROUP && Grs[i].result == ECANCELED; i++);
+   printf("woke in %ldms, ", elapsed);
+   if(res == 0 && i == GROUP && elapsed < PROMPT_MS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d, cancelled= %d\n", res, i);
+   }
+
+   printf("  Token across units...         ");
+   memset(Tokens, 0, sizeof(Tokens));
+   res = thread_create_many(&group, GROUP, unit_group_token, Tokens,
+      sizeof(*Tokens), NULL);
+   token = &group.cancel;
+   res |= group_join(&group);
+   for(i = 0; i < GROUP && Tokens[i] == token; i++);
+   if(res == 0 && i == GROUP)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d, observed= %d\n", res, i);
+   }
+
+   printf("  Spawn error...                ");
+   memset(Grs, 0, sizeof(Grs));
+   /* a stack beyond the address space fails the first spawn */
+   attr.stacksize = ((size_t) -1) / 2;
+   attr.pin = 0;
+   res = thread_create_many(&group, GROUP, grs_index, Grs, sizeof(GRArg),
+      &attr);
+   for(i = 0; i < GROUP && Grs[i].result == 0; i++);
+   if(res != 0 && group_join(&group) == res && i == GROUP)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d, ran= %d\n", res, GROUP - i);
+   }
+
+
+   return fail;
+}
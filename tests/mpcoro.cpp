@@ -0,0 +1,461 @@
+/* ****************************************************************
+ * Test coroutine support.
+ *  - mpcoro.cpp (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Coroutine tasks, executor and awaitables:
+ * - Task results and exceptions, through nested tasks and sync_wait()
+ * - Detached tasks spawned onto the pool
+ * - Timer expiry and ordering, by deadline
+ * - Channel delivery between producers and consumers, and close()
+ * - AsyncMutex exclusion, across suspension within the lock
+ * - Cost of a coroutine switch versus a thread handoff
+ *
+ * NOTES:
+ * - Requires C++20 coroutine support; the test is skipped elsewhere.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+
+#ifdef __cpp_impl_coroutine
+
+#include <atomic>
+#include <stdexcept>
+
+#include "../src/mpcoro.hpp"
+
+#define THREADS   4
+#define SPAWNS    10000   /* detached tasks */
+#define TIMERS    8       /* timers, SLEEP milliseconds apart */
+#define SLEEP     10      /* timer interval, in milliseconds */
+#define LATE      50      /* timer tolerance, in milliseconds */
+#define PRODUCERS 4
+#define CONSUMERS 4
+#define MESSAGES  20000   /* messages per producer */
+#define LOCKERS   16
+#define ROUNDS    2000    /* lock rounds per locker */
+#define SWITCHES  1000000 /* coroutine switches per measurement */
+#define HANDOFFS  20000   /* thread and channel handoffs per measurement */
+
+/****************************************************************/
+
+/* Nested tasks, summing 1..n recursively. */
+mp::Task<long> sum_to(long n)
+{
+   if(n == 0) co_return 0;
+   co_return n + co_await sum_to(n - 1);
+}
+
+/* Task throwing from a nested task. */
+mp::Task<int> thrower(int depth)
+{
+   if(depth == 0) throw std::runtime_error("thrown");
+   co_return co_await thrower(depth - 1);
+}
+
+/* Detached task incrementing a counter. */
+std::atomic<long> Spawned;
+
+mp::Task<void> spawned(void)
+{
+   Spawned++;
+   co_return;
+}
+
+/* Task awaiting all detached tasks, polling on the pool. */
+mp::Task<long> await_spawned(mp::Executor &ex)
+{
+   long long deadline = nanoseconds() + NANOSECONDS * 10;
+
+   while(Spawned < SPAWNS && nanoseconds() < deadline)
+      co_await ex.sleep_for(std::chrono::milliseconds(1));
+   co_return Spawned.load();
+}
+
+/* Completion order and lateness of timers. */
+struct TimerLog {
+   std::atomic<int> order;
+   int seq[TIMERS];
+   long long late[TIMERS];
+};
+
+/* Task sleeping until a deadline, recording its order and lateness. */
+mp::Task<void> sleeper(mp::Executor &ex, TimerLog &log, int i)
+{
+   mp::MonotonicClock::time_point deadline = mp::MonotonicClock::now() +
+      std::chrono::milliseconds(SLEEP * (TIMERS - i));
+
+   co_await ex.sleep_until(deadline);
+   log.late[i] = mp::to_nanoseconds(mp::MonotonicClock::now() - deadline);
+   log.seq[log.order++] = i;
+}
+
+/* Task starting timers in reverse deadline order, awaiting all. */
+mp::Task<void> timers(mp::Executor &ex, TimerLog &log)
+{
+   mp::Task<void> t[TIMERS];
+   int i;
+
+   for(i = 0; i < TIMERS; i++) t[i] = sleeper(ex, log, i);
+   co_await mp::when_all(ex, t, TIMERS);
+}
+
+/* Producer task, sending MESSAGES values. */
+mp::Task<void> producer(mp::Channel<long> &ch, std::atomic<int> &left)
+{
+   for(long i = 1; i <= MESSAGES; i++) {
+      if(!co_await ch.send(i)) co_return;
+   }
+   /* the last producer closes the channel */
+   if(--left == 0) ch.close();
+}
+
+/* Consumer task, summing values until the channel is closed. */
+mp::Task<void> consumer(mp::Channel<long> &ch, std::atomic<long> &sum,
+   std::atomic<long> &count)
+{
+   std::optional<long> v;
+
+   while((v = co_await ch.recv())) {
+      sum += *v;
+      count++;
+   }
+}
+
+/* Task running producers and consumers over a channel, concurrently. */
+mp::Task<int> channel_test(mp::Executor &ex, long *sum, long *count)
+{
+   mp::Channel<long> ch(ex, 4);
+   std::atomic<int> left(PRODUCERS);
+   std::atomic<long> s(0), c(0);
+   mp::Task<void> t[PRODUCERS + CONSUMERS];
+   int i;
+
+   for(i = 0; i < CONSUMERS; i++) t[i] = consumer(ch, s, c);
+   for(i = 0; i < PRODUCERS; i++) t[CONSUMERS + i] = producer(ch, left);
+   /* consumers complete once the last producer closes the channel */
+   co_await mp::when_all(ex, t, PRODUCERS + CONSUMERS);
+   *sum = s;
+   *count = c;
+   /* a closed and empty channel neither sends nor receives */
+   co_return (co_await ch.send(0)) || (co_await ch.recv()).has_value();
+}
+
+/* Locker task, incrementing a shared count under an AsyncMutex, while
+ * suspending within the lock. */
+mp::Task<void> locker(mp::Executor &ex, mp::AsyncMutex &m, long &count,
+   std::atomic<int> &inside, std::atomic<int> &overlap)
+{
+   long v;
+
+   for(int i = 0; i < ROUNDS; i++) {
+      mp::AsyncMutex::Guard guard = co_await m.scoped_lock();
+      if(inside++) overlap++;
+      v = count;
+      if(i % 64 == 0) co_await ex.schedule();
+      count = v + 1;
+      inside--;
+   }
+}
+
+/* Task running LOCKERS lockers concurrently. */
+mp::Task<long> mutex_test(mp::Executor &ex, int *overlaps)
+{
+   mp::AsyncMutex m(ex);
+   std::atomic<int> inside(0), overlap(0);
+   mp::Task<void> t[LOCKERS];
+   long count = 0;
+   int i;
+
+   for(i = 0; i < LOCKERS; i++) t[i] = locker(ex, m, count, inside, overlap);
+   co_await mp::when_all(ex, t, LOCKERS);
+   *overlaps = overlap;
+   co_return count;
+}
+
+/****************************************************************/
+
+/* A coroutine suspending forever, resumed by the caller; each resume
+ * and suspend pair is a round trip of two switches. */
+struct Yielder {
+   struct promise_type {
+      Yielder get_return_object()
+      {
+         return Yielder{ std::coroutine_handle<promise_type>::from_promise(
+            *this) };
+      }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept { std::terminate(); }
+   };
+   std::coroutine_handle<promise_type> h;
+};
+
+volatile long Sink;
+
+Yielder yielder(void)
+{
+   for( ;; ) {
+      Sink = Sink + 1;
+      co_await std::suspend_always{};
+   }
+}
+
+/* Measure a coroutine switch, in nanoseconds. */
+double cost_switch(void)
+{
+   Yielder y = yielder();
+   long long nstart;
+
+   nstart = nanoseconds();
+   for(long i = 0; i < SWITCHES; i++) y.h.resume();
+   y.h.destroy();
+
+   return (double) nanoelapsed(nstart) / (2.0 * SWITCHES);
+}
+
+/* Task awaiting a trivial task SWITCHES times. */
+mp::Task<long> leaf(long i) { co_return i; }
+
+mp::Task<long> awaiter(void)
+{
+   long sum = 0;
+
+   for(long i = 0; i < SWITCHES; i++) sum += co_await leaf(i);
+   co_return sum;
+}
+
+/* Task hopping onto the pool HANDOFFS times. */
+mp::Task<void> hopper(mp::Executor &ex)
+{
+   for(long i = 0; i < HANDOFFS; i++) co_await ex.schedule();
+}
+
+/* Task ping-ponging between two coroutines over a pair of channels. */
+mp::Task<void> pinger(mp::Channel<long> &ping, mp::Channel<long> &pong)
+{
+   for(long i = 0; i < HANDOFFS; i++) {
+      co_await ping.send(i);
+      co_await pong.recv();
+   }
+   ping.close();
+}
+
+mp::Task<void> ponger(mp::Channel<long> &ping, mp::Channel<long> &pong)
+{
+   std::optional<long> v;
+
+   while((v = co_await ping.recv())) co_await pong.send(*v);
+}
+
+mp::Task<void> pingpong(mp::Executor &ex)
+{
+   mp::Channel<long> ping(ex, 1), pong(ex, 1);
+   mp::Task<void> t[2];
+
+   t[0] = pinger(ping, pong);
+   t[1] = ponger(ping, pong);
+   co_await mp::when_all(ex, t, 2);
+}
+
+/* Thread handoff state; a token passed between two threads. */
+struct Handoff {
+   Mutex lock;
+   Condition cond;
+   long turn;
+};
+
+Threaded th_handoff(void *arg)
+{
+   Handoff *ho = (Handoff *) arg;
+
+   mutex_lock(&ho->lock);
+   for(long i = 0; i < HANDOFFS; i++) {
+      while(ho->turn % 2 == 0) condition_wait(&ho->cond, &ho->lock);
+      ho->turn++;
+      condition_signal(&ho->cond);
+   }
+   mutex_unlock(&ho->lock);
+
+   return Treturn;
+}
+
+/* Measure a thread handoff, in nanoseconds. */
+double cost_handoff(void)
+{
+   Handoff ho;
+   ThreadID tid;
+   long long nstart;
+
+   mutex_init(&ho.lock);
+   condition_init(&ho.cond);
+   ho.turn = 0;
+   thread_create(&tid, th_handoff, &ho);
+   nstart = nanoseconds();
+   mutex_lock(&ho.lock);
+   for(long i = 0; i < HANDOFFS; i++) {
+      while(ho.turn % 2) condition_wait(&ho.cond, &ho.lock);
+      ho.turn++;
+      condition_signal(&ho.cond);
+   }
+   while(ho.turn < 2 * HANDOFFS) condition_wait(&ho.cond, &ho.lock);
+   mutex_unlock(&ho.lock);
+   thread_wait(&tid);
+   condition_free(&ho.cond);
+   mutex_free(&ho.lock);
+
+   return (double) nanoelapsed(nstart) / (2.0 * HANDOFFS);
+}
+
+/* Run all tests on an executor of a pool.
+ * Returns number of tests failed. */
+int run(ThreadPool *pool)
+{
+   mp::Executor ex(pool);
+   TimerLog log;
+   long long nstart, late;
+   double sw, aw, hop, pp, ho;
+   long sum, count, res;
+   int i, overlaps, fail;
+
+   fail = 0;
+
+   printf("\nTasks w/ %d thread pool - mpcoro.hpp;\n", THREADS);
+   printf("  Task results...          ");
+   res = mp::sync_wait(ex, sum_to(1000));
+   if(res == 500500) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. sum= %ld\n", res);
+   }
+   printf("  Task exceptions...       ");
+   try {
+      mp::sync_wait(ex, thrower(100));
+      fail++;
+      printf("Failed. not thrown\n");
+   } catch(const std::runtime_error &) {
+      printf("Pass!\n");
+   }
+   printf("  Detached tasks...        ");
+   for(i = 0; i < SPAWNS; i++) ex.spawn(spawned());
+   res = mp::sync_wait(ex, await_spawned(ex));
+   if(res == SPAWNS) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. completed= %ld\n", res);
+   }
+
+
+   printf("\nAwaitables - mpcoro.hpp;\n");
+   printf("  Timers by deadline...    ");
+   log.order = 0;
+   nstart = nanoseconds();
+   mp::sync_wait(ex, timers(ex, log));
+   nstart = nanoelapsed(nstart);
+   for(res = late = i = 0; i < TIMERS; i++) {
+      /* the latest started timer is due first */
+      if(log.seq[i] != TIMERS - 1 - i || log.late[i] < 0) res++;
+      if(log.late[i] > late) late = log.late[i];
+   }
+   printf("max late %.2fms, ", (double) late / 1000000);
+   if(res == 0 && late < LATE * 1000000LL) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. misordered= %ld\n", res);
+   }
+   printf("  Channel %dx%d...           ", PRODUCERS, CONSUMERS);
+   sum = count = 0;
+   res = mp::sync_wait(ex, channel_test(ex, &sum, &count));
+   if(res == 0 && count == (long) PRODUCERS * MESSAGES &&
+      sum == (long) PRODUCERS * MESSAGES * (MESSAGES + 1) / 2)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. count= %ld, sum= %ld\n", count, sum);
+   }
+   printf("  AsyncMutex x%d...        ", LOCKERS);
+   overlaps = 0;
+   res = mp::sync_wait(ex, mutex_test(ex, &overlaps));
+   if(res == (long) LOCKERS * ROUNDS && overlaps == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. count= %ld, overlaps= %d\n", res, overlaps);
+   }
+
+
+   printf("\nSwitch cost vs. thread handoff - mpcoro.hpp;\n");
+   sw = cost_switch();
+   nstart = nanoseconds();
+   mp::sync_wait(ex, awaiter());
+   aw = (double) nanoelapsed(nstart) / SWITCHES;
+   nstart = nanoseconds();
+   mp::sync_wait(ex, hopper(ex));
+   hop = (double) nanoelapsed(nstart) / HANDOFFS;
+   nstart = nanoseconds();
+   mp::sync_wait(ex, pingpong(ex));
+   pp = (double) nanoelapsed(nstart) / (2.0 * HANDOFFS);
+   ho = cost_handoff();
+   printf("  Coroutine switch...      %8.1fns\n", sw);
+   printf("  Task await (+frame)...   %8.1fns\n", aw);
+   printf("  Pool hop...              %8.1fns\n", hop);
+   printf("  Channel handoff...       %8.1fns\n", pp);
+   printf("  Thread handoff...        %8.1fns, ", ho);
+   if(sw < ho && aw < ho) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   return fail;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   ThreadPool pool;
+   int fail;
+
+   printf("\n___________________\n");
+   printf("Begin Coroutine tests...\n");
+
+   if(pool_init(&pool, THREADS)) {
+      printf("\n  Failed. pool_init()\n");
+      return 1;
+   }
+   /* the executor SHALL NOT outlive its pool */
+   fail = run(&pool);
+   pool_free(&pool);
+
+
+   return fail;
+}
+
+#else
+
+int main()
+{
+   printf("\nCoroutine tests skipped, requires C++20 coroutines.\n");
+
+   return 0;
+}
+
+#endif
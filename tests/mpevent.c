@@ -0,0 +1,293 @@
+/* ****************************************************************
+ * Test event loop.
+ *  - mpevent.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Event loop:
+ * - Readiness of socketpairs and pipes
+ * - Timer ordering, cancellation and periodic restart
+ * - Cross-thread task posting and stop requests
+ * - A failed post wake up, leaving no task posted
+ *
+ * NOTES:
+ * - The event loop is Linux only; the test is skipped elsewhere.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+
+#include <sys/socket.h>
+
+#include "../src/mpevent.h"
+
+#define POSTS      100000
+#define TIMER_MS   10
+#define PRECISION  5  /* milliseconds */
+
+/****************************************************************/
+
+/* Struct recording events observed by callbacks. */
+typedef struct {
+   char order[16];
+   int len;
+   long fired[4];
+   int echoes;
+   volatile int posts;
+} EVState;
+
+EVState Evs;
+
+/* Event callback echoing data read from a socket back to its sender. */
+void ev_echo(EventLoop *loop, EventWatch *watch, unsigned events)
+{
+   char buf[64];
+   ssize_t len;
+
+   if(events & EVENT_IN) {
+      len = read(watch->fd, buf, sizeof(buf));
+      if(len > 0 && write(watch->fd, buf, (size_t) len) == len)
+         Evs.echoes++;
+   }
+}
+
+/* Event callback recording pipe data, stopping the loop on hang up. */
+void ev_pipe(EventLoop *loop, EventWatch *watch, unsigned events)
+{
+   char c;
+
+   if(events & EVENT_IN) {
+      while(read(watch->fd, &c, 1) == 1)
+         Evs.order[Evs.len++] = c;
+   }
+   if(events & EVENT_HUP) {
+      event_del(loop, watch);
+      event_stop(loop);
+   }
+}
+
+/* Timer callback recording its character and expiry time. */
+void tm_record(EventLoop *loop, EventTimer *timer)
+{
+   char c = *((char *) timer->arg);
+
+   Evs.fired[c - 'a'] = milliseconds();
+   Evs.order[Evs.len++] = c;
+   if(Evs.len == 3) event_stop(loop);
+}
+
+/* Timer callback restarting itself, for periodic use. */
+void tm_periodic(EventLoop *loop, EventTimer *timer)
+{
+   Evs.order[Evs.len++] = 'p';
+   if(Evs.len < 5) event_settimer(loop, timer, 1, tm_periodic, NULL);
+   else event_stop(loop);
+}
+
+/* Posted task counting posts. */
+void post_count(void *arg)
+{
+   Evs.posts++;
+}
+
+/* Posted task stopping the loop passed as argument. */
+void post_stop(void *arg)
+{
+   event_stop((EventLoop *) arg);
+}
+
+/* Thread function posting tasks to the loop passed as argument. */
+Threaded th_post(void *arg)
+{
+   int i;
+
+   for(i = 0; i < POSTS; i++)
+      event_post((EventLoop *) arg, post_count, NULL);
+   event_post((EventLoop *) arg, post_stop, arg);
+
+   return Treturn;
+}
+
+/* Thread function stopping the loop passed as argument, after delay. */
+Threaded th_stop(void *arg)
+{
+   millisleep(TIMER_MS);
+   event_stop((EventLoop *) arg);
+
+   return Treturn;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   EventLoop loop;
+   EventWatch watch[2];
+   EventTimer timer[4];
+   ThreadID tid;
+   long mstart, elapsed;
+   char buf[64];
+   int sv[2], fd[2], evfd;
+   int i, res, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Event Loop tests...\n");
+
+   event_init(&loop);
+
+
+   printf("\nFile descriptor readiness - mpevent.h;\n");
+   printf("  Socketpair echo...       ");
+   memset(&Evs, 0, sizeof(Evs));
+   socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+   event_add(&loop, &watch[0], sv[1], EVENT_IN, ev_echo, NULL);
+   for(res = i = 0; i < 10; i++) {
+      if(write(sv[0], "ping", 4) != 4) break;
+      event_runonce(&loop, 100);
+      if(read(sv[0], buf, sizeof(buf)) == 4 && memcmp(buf, "ping", 4) == 0)
+         res++;
+   }
+   event_del(&loop, &watch[0]);
+   close(sv[0]);
+   close(sv[1]);
+   if(res == 10 && Evs.echoes == 10)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. echoes= %d\n", Evs.echoes);
+   }
+
+   printf("  Pipe data and hang up... ");
+   memset(&Evs, 0, sizeof(Evs));
+   res = pipe(fd);
+   event_add(&loop, &watch[1], fd[0], EVENT_IN, ev_pipe, NULL);
+   res |= (write(fd[1], "abc", 3) != 3);
+   close(fd[1]);
+   res |= event_run(&loop);
+   close(fd[0]);
+   if(res == 0 && strcmp(Evs.order, "abc") == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. data= %s\n", Evs.order);
+   }
+
+
+   printf("\nTimers - mpevent.h;\n");
+   printf("  Deadline order...        ");
+   memset(&Evs, 0, sizeof(Evs));
+   for(i = 0; i < 4; i++) timer[i].index = -1;
+   mstart = milliseconds();
+   event_settimer(&loop, &timer[0], TIMER_MS * 3, tm_record, "c");
+   event_settimer(&loop, &timer[1], TIMER_MS * 1, tm_record, "a");
+   event_settimer(&loop, &timer[3], TIMER_MS * 4, tm_record, "d");
+   event_settimer(&loop, &timer[2], TIMER_MS * 2, tm_record, "b");
+   event_deltimer(&loop, &timer[3]);
+   event_run(&loop);
+   for(res = i = 0; i < 3; i++) {
+      elapsed = Evs.fired[i] - mstart;
+      if(elapsed < TIMER_MS * (i + 1) ||
+         elapsed > TIMER_MS * (i + 1) + PRECISION) res++;
+   }
+   if(res == 0 && strcmp(Evs.order, "abc") == 0 && loop.len == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. order= %s, late= %d\n", Evs.order, res);
+   }
+
+   printf("  Periodic restart...      ");
+   memset(&Evs, 0, sizeof(Evs));
+   event_settimer(&loop, &timer[0], 1, tm_periodic, NULL);
+   event_run(&loop);
+   if(strcmp(Evs.order, "ppppp") == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. order= %s\n", Evs.order);
+   }
+
+
+   printf("\nCross-thread wake ups - mpevent.h;\n");
+   printf("  Posted tasks...          ");
+   memset(&Evs, 0, sizeof(Evs));
+   mstart = milliseconds();
+   thread_create(&tid, th_post, &loop);
+   event_run(&loop);
+   thread_wait(&tid);
+   elapsed = millielapsed(mstart);
+   printf("%d in %ldms, ", Evs.posts, elapsed);
+   if(Evs.posts == POSTS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   printf("  Stop from idle...        ");
+   mstart = milliseconds();
+   thread_create(&tid, th_stop, &loop);
+   event_run(&loop);
+   thread_wait(&tid);
+   elapsed = millielapsed(mstart);
+   printf("%ldms, ", elapsed);
+   if(elapsed >= TIMER_MS && elapsed <= TIMER_MS + PRECISION)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   printf("  Failed wake up...        ");
+   memset(&Evs, 0, sizeof(Evs));
+   evfd = loop.evfd;
+   loop.evfd = -1;
+   res = event_post(&loop, post_count, NULL);
+   loop.evfd = evfd;
+   /* the failed post is not queued, and later posts wake the loop */
+   if(res == EBADF && loop.head == NULL) {
+      event_post(&loop, post_count, NULL);
+      event_post(&loop, post_stop, &loop);
+      event_run(&loop);
+   }
+   if(res == EBADF && Evs.posts == 1)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d, posts= %d\n", res, Evs.posts);
+   }
+
+   event_free(&loop);
+
+
+   return fail;
+}
+
+#else
+
+int main()
+{
+   printf("\nEvent loop tests skipped, Linux only.\n");
+
+   return 0;
+}
+
+#endif
@@ -0,0 +1,235 @@
+/* ****************************************************************
+ * Test asynchronous batched logging.
+ *  - mplog.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Asynchronous batched logging:
+ * - Deferred formatting fidelity, compared against snprintf()
+ * - Record integrity and per-thread order from many logging threads
+ * - Per-call cost of log_printf() versus fprintf(), in nanoseconds
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mplog.h"
+#include "../src/mptime.h"
+
+#define TESTFILE  "mplog.tmp"
+#define THREADS   8
+#define RECORDS   20000  /* per thread */
+#define BURST     512    /* calls per timed burst */
+#define BURSTS    64
+
+#define FORMATS   16
+
+/****************************************************************/
+
+Logger Logs;
+char Expect[FORMATS][LOG_LINE];
+int Nexpect;
+
+/* Log a message and record its expected formatting. */
+#define log_expect(...)  do { \
+   snprintf(Expect[Nexpect++], LOG_LINE, __VA_ARGS__); \
+   log_printf(&Logs, __VA_ARGS__); \
+} while(0)
+
+/* Struct for passing benchmark arguments to thread function. */
+typedef struct {
+   FILE *fp;       /* fprintf() stream, else NULL for log_printf() */
+   long long ns;   /* time spent in calls */
+} BMState;
+
+/* Thread function logging numbered records. */
+Threaded th_records(void *arg)
+{
+   int i, id = (int) (size_t) arg;
+
+   for(i = 0; i < RECORDS; i++)
+      log_printf(&Logs, "thread %d seq %d", id, i);
+
+   return Treturn;
+}
+
+/* Thread function timing bursts of logging calls, either to a stream
+ * with fprintf(), or with log_printf(). Only the calls are timed, the
+ * (shared) writer thread is flushed between bursts. */
+Threaded th_bench(void *arg)
+{
+   BMState *bms = (BMState *) arg;
+   long long nstart;
+   int i, j;
+
+   for(bms->ns = i = 0; i < BURSTS; i++) {
+      nstart = nanoseconds();
+      for(j = 0; j < BURST; j++) {
+         if(bms->fp) {
+            fprintf(bms->fp, "request %d took %.3fms, status %s\n",
+               j, j * 0.125, "ok");
+         } else log_printf(&Logs, "request %d took %.3fms, status %s",
+            j, j * 0.125, "ok");
+      }
+      bms->ns += nanoelapsed(nstart);
+      if(bms->fp) fflush(bms->fp);
+      else log_flush(&Logs);
+   }
+
+   return Treturn;
+}
+
+/* Benchmark `nthreads` threads logging with fprintf() to `fp`,
+ * or with log_printf() where `fp` is NULL.
+ * Returns the average cost per call in nanoseconds. */
+double run_bench(FILE *fp, int nthreads)
+{
+   ThreadID tid[THREADS];
+   BMState bms[THREADS];
+   long long ns;
+   int i;
+
+   for(i = 0; i < nthreads; i++) {
+      bms[i].fp = fp;
+      thread_create(&tid[i], th_bench, &bms[i]);
+   }
+   thread_multiwait(tid, nthreads);
+   for(ns = i = 0; i < nthreads; i++) ns += bms[i].ns;
+
+   return (double) ns / ((double) nthreads * BURSTS * BURST);
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   static char line[LOG_LINE], longstr[LOG_STRLEN * 2];
+   static int last[THREADS];
+   ThreadID tid[THREADS];
+   double ns_file[2], ns_log[2];
+   FILE *fp;
+   char *msg;
+   int i, id, seq, res, bad, fail;
+   long count;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Asynchronous Logging tests...\n");
+
+
+   printf("\nDeferred formatting - mplog.h;\n");
+   printf("  Conversions vs. snprintf()... ");
+   memset(longstr, 'x', sizeof(longstr) - 1);
+   fp = fopen(TESTFILE, "w+");
+   log_init(&Logs, fp);
+   log_expect("plain text, 100%% literal");
+   log_expect("int %d %5i %-4u| %x %#o %c", -42, 7, 99u, 0xbeef, 8, 'z');
+   log_expect("long %ld %lu %lld %llx", -1L, 123456789UL, -9876543210LL,
+      0x123456789abcULL);
+   log_expect("size %zu %zx", sizeof(line), (size_t) 4096);
+   log_expect("double %f %.3f %e %g %8.2f|", 3.14159, -2.5, 1e-9, 0.1, 42.0);
+   log_expect("string %s|%8s|%-6s|%.2s|", "abc", "right", "left", "trunc");
+   log_expect("star %*d|%-*.*f|", 6, 12, 9, 3, 1.5);
+   log_expect("pointer %p", (void *) line);
+   log_expect("short %hd %08X", (short) -3, 0xcafeu);
+   log_expect("mixed %s=%d (%.1f%%) %s", "count", 17, 42.5, "done");
+   log_expect("many %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8);
+   /* string arguments beyond LOG_STRLEN bytes are truncated */
+   strcpy(Expect[Nexpect], "long ");
+   strncat(Expect[Nexpect++], longstr, LOG_STRLEN - 1);
+   log_printf(&Logs, "long %s", longstr);
+   /* arguments beyond LOG_ARGS are written verbatim */
+   strcpy(Expect[Nexpect++], "over 1 2 3 4 5 6 7 8 %d");
+   log_printf(&Logs, "over %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7,
+      8, 9);
+   /* specifications of more than two '*' are written verbatim */
+   strcpy(Expect[Nexpect++], "stars %*******d");
+   log_printf(&Logs, "stars %*******d", -1000000000, -1000000000,
+      -1000000000, -1000000000, -1000000000, -1000000000, -1000000000, 1);
+   log_flush(&Logs);
+   rewind(fp);
+   for(bad = i = 0; i < Nexpect && fgets(line, sizeof(line), fp); i++) {
+      line[strcspn(line, "\n")] = '\0';
+      msg = strstr(line, "] ");
+      if(msg == NULL) {
+         bad++;
+         continue;
+      }
+      if(strcmp(msg + 2, Expect[i])) bad++;
+   }
+   log_free(&Logs);
+   fclose(fp);
+   if(bad == 0 && i == Nexpect)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d, lines= %d\n", bad, i);
+   }
+
+
+   printf("\nRecord integrity - mplog.h;\n");
+   printf("  %d threads x %d records... ", THREADS, RECORDS);
+   fp = fopen(TESTFILE, "w+");
+   log_init(&Logs, fp);
+   for(i = 0; i < THREADS; i++)
+      thread_create(&tid[i], th_records, (void *) (size_t) i);
+   thread_multiwait(tid, THREADS);
+   log_free(&Logs);
+   rewind(fp);
+   for(i = 0; i < THREADS; i++) last[i] = -1;
+   for(count = bad = 0; fgets(line, sizeof(line), fp); count++) {
+      msg = strstr(line, "] ");
+      res = msg ? sscanf(msg, "] thread %d seq %d", &id, &seq) : 0;
+      if(res != 2 || id < 0 || id >= THREADS || seq != last[id] + 1) bad++;
+      else last[id] = seq;
+   }
+   fclose(fp);
+   if(count == (long) THREADS * RECORDS && bad == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. records= %ld, out of order= %d\n", count, bad);
+   }
+
+
+   printf("\nPer-call cost, %d call bursts - mplog.h;\n", BURST);
+   fp = fopen(TESTFILE, "w");
+   log_init(&Logs, fp);
+   for(i = 0; i < 2; i++) {
+      ns_file[i] = run_bench(fp, i ? THREADS : 1);
+      ns_log[i] = run_bench(NULL, i ? THREADS : 1);
+   }
+   log_free(&Logs);
+   fclose(fp);
+   remove(TESTFILE);
+   for(i = 0; i < 2; i++) {
+      printf("  %d thread(s); fprintf= %.0fns, log_printf= %.0fns/call\n",
+         i ? THREADS : 1, ns_file[i], ns_log[i]);
+   }
+   printf("  log_printf() cheaper than fprintf()... ");
+   if(ns_log[0] < ns_file[0] && ns_log[1] < ns_file[1])
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   return fail;
+}
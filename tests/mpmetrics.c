@@ -0,0 +1,230 @@
+/* ****************************************************************
+ * Test shared memory metrics.
+ *  - mpmetrics.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Shared memory metrics:
+ * - Registration of counters, gauges and histograms
+ * - Concurrent updates, read live through a read-only attachment
+ * - Dumping of metrics by another process (see also metricsdump.c)
+ * - Per-update cost, in nanoseconds
+ *
+ * NOTES:
+ * - The external reader test requires fork(), and is skipped on Windows.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpmetrics.h"
+#include "../src/mptime.h"
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+#define TESTFILE  "mpmetrics.tmp"
+#define DUMPFILE  "mpmetrics.txt"
+#define CAPACITY  8
+#define THREADS   4
+#define UPDATES   250000  /* per thread */
+#define BENCH     10000000
+#define BUDGET    100     /* nanoseconds per update */
+
+/****************************************************************/
+
+Metric *Requests, *Active, *Latency;
+volatile int Running;
+long Decreased;
+
+/* Thread function updating each metric UPDATES times. Observed values
+ * cycle through 0-999, a quarter within each bucket. */
+Threaded th_update(void *arg)
+{
+   int i;
+
+   metric_inc(Active);
+   for(i = 0; i < UPDATES; i++) {
+      metric_inc(Requests);
+      metric_observe(Latency, i % 1000);
+   }
+   metric_add(Active, -1);
+
+   return Treturn;
+}
+
+/* Thread function reading a counter through a read-only attachment,
+ * while updated, counting any observed decrease of the counter. */
+Threaded th_reader(void *arg)
+{
+   Metrics *view = (Metrics *) arg;
+   long long value, last;
+
+   for(last = 0; Running; last = value) {
+      value = metric_value(&view->metric[0]);
+      if(value < last) Decreased++;
+   }
+
+   return Treturn;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   static const long long bounds[] = { 249, 499, 749 };
+   static char line[128], want[4][128];
+   ThreadID tid[THREADS], reader;
+   Metrics m, view;
+   Metric *metric;
+   long long nstart, expect;
+   double cost;
+   int i, res, fail;
+#ifndef _WIN32
+   pid_t pid;
+#endif
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Shared Memory Metrics tests...\n");
+
+
+   printf("\nRegistration w/ capacity %d - mpmetrics.h;\n", CAPACITY);
+   printf("  Counters, gauges and histograms... ");
+   res = metrics_open(&m, TESTFILE, CAPACITY);
+   if(res == 0) {
+      Requests = metric_counter(&m, "requests_total");
+      Active = metric_gauge(&m, "active_threads");
+      Latency = metric_histogram(&m, "latency_us", bounds, 3);
+      /* existing names, mismatched types, and full capacity */
+      if(metric_counter(&m, "requests_total") != Requests) res++;
+      if(metric_gauge(&m, "requests_total") != NULL) res++;
+      for(i = 3; i < CAPACITY; i++) {
+         sprintf(line, "spare_%d", i);
+         if(metric_counter(&m, line) == NULL) res++;
+      }
+      if(metric_counter(&m, "overflow") != NULL) res++;
+      if(!Requests || !Active || !Latency) res++;
+   }
+   if(res == 0 && m.hdr->count == CAPACITY)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. errors= %d\n", res);
+   }
+
+
+   printf("\nConcurrent updates w/ %d threads - mpmetrics.h;\n", THREADS);
+   printf("  Live, read-only attachment... ");
+   res = metrics_attach(&view, TESTFILE);
+   Running = 1;
+   if(res == 0) thread_create(&reader, th_reader, &view);
+   for(i = 0; i < THREADS; i++)
+      thread_create(&tid[i], th_update, NULL);
+   thread_multiwait(tid, THREADS);
+   Running = 0;
+   if(res == 0) thread_wait(&reader);
+   expect = (long long) THREADS * UPDATES;
+   if(res == 0) {
+      metric = view.metric;
+      if(metric_value(&metric[0]) != expect) res++;
+      if(metric_value(&metric[1]) != 0) res++;
+      if(metric[2].count != expect) res++;
+      if(metric[2].value != (expect / 1000) * (999 * 1000 / 2)) res++;
+      for(i = 0; i < 4; i++) if(metric[2].bucket[i] != expect / 4) res++;
+   }
+   if(res == 0 && Decreased == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. errors= %d\n", res);
+   }
+
+   printf("  External reader process...    ");
+#ifndef _WIN32
+   fflush(stdout);
+   pid = fork();
+   if(pid == 0) {
+      /* another process, dumping the metrics file */
+      FILE *fp = fopen(DUMPFILE, "w");
+      Metrics ext;
+
+      if(fp == NULL || metrics_attach(&ext, TESTFILE)) exit(1);
+      metrics_dump(&ext, fp);
+      metrics_close(&ext);
+      fclose(fp);
+      exit(0);
+   }
+   waitpid(pid, &res, 0);
+   if(res == 0) {
+      FILE *fp = fopen(DUMPFILE, "r");
+
+      /* expect counter, gauge, and cumulative histogram lines */
+      sprintf(want[0], "requests_total %lld\n", expect);
+      sprintf(want[1], "active_threads 0\n");
+      sprintf(want[2], "latency_us_bucket{le=\"499\"} %lld\n", expect / 2);
+      sprintf(want[3], "latency_us_bucket{le=\"+Inf\"} %lld\n", expect);
+      for(res = 0; fp && fgets(line, sizeof(line), fp); )
+         for(i = 0; i < 4; i++) if(strcmp(line, want[i]) == 0) res |= 1 << i;
+      if(fp) fclose(fp);
+      res = res != 15;
+   }
+   remove(DUMPFILE);
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+#else
+   printf("Skipped, requires fork().\n");
+#endif
+   if(view.hdr) metrics_close(&view);
+
+
+   printf("\nPer-update cost, budget= %dns - mpmetrics.h;\n", BUDGET);
+   printf("  Counter increment...   ");
+   nstart = nanoseconds();
+   for(i = 0; i < BENCH; i++) metric_inc(Requests);
+   cost = (double) nanoelapsed(nstart) / BENCH;
+   printf("%.1fns, ", cost);
+   if(cost < BUDGET)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  Histogram observe...   ");
+   nstart = nanoseconds();
+   for(i = 0; i < BENCH; i++) metric_observe(Latency, i & 1023);
+   cost = (double) nanoelapsed(nstart) / BENCH;
+   printf("%.1fns, ", cost);
+   if(cost < BUDGET)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   metrics_close(&m);
+   remove(TESTFILE);
+
+
+   return fail;
+}
@@ -0,0 +1,455 @@
+/* ****************************************************************
+ * Test multiplatform thread pool.
+ *  - mppool.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Multiplatform thread pool:
+ * - Detached task submission and pool shutdown
+ * - Structured task scopes, error propagation and cancellation
+ * - Fan-out cost of task scopes versus one thread per child
+ * - Priority lane and deadline scheduling, starvation protection
+ * - Interactive latency under batch saturation, FIFO versus EDF
+ * - Elastic pool reaction time to a load step, growth and retirement
+ * - Task tokens observed by tasks of another translation unit, linked
+ *   with unit/mppool.c
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mppool.h"
+#include "../src/mptime.h"
+
+#define WORKERS   4
+#define TASKS     10000
+#define CHILDREN  1000
+#define FAILAT    10
+
+#define STARVE_US       10000  /* lane starvation period */
+#define SPIN_US         1000   /* duration of starvation test tasks */
+#define BATCH_TASKS     400
+#define BATCH_US        250    /* duration of batch tasks */
+#define INTERACTIVE     50
+#define INTERACTIVE_US  1000   /* relative deadline of interactive tasks */
+
+#define ELASTIC_MAX  8
+#define GROW_US      2000    /* elastic growth threshold */
+#define IDLE_MS      50      /* elastic idle period */
+#define STEP_MS      250     /* duration of load step */
+#define LOAD_MS      2       /* duration of (blocking) load step tasks */
+
+/****************************************************************/
+
+/* Struct for passing counting arguments to task function. */
+typedef struct {
+   Mutex lock;
+   int count;
+   int failat;
+} PTState;
+
+/* Struct for passing nested scope arguments to task function. */
+typedef struct {
+   ThreadPool *pool;
+   PTState *pts;
+} NSState;
+
+/* Task function incrementing a Mutex guarded count. Fails with EIO
+ * when the count reaches `failat` (when non-zero). */
+int pts_inc(void *arg)
+{
+   PTState *pts;
+   int count;
+
+   pts = (PTState *) arg;
+
+   mutex_lock(&pts->lock);
+   count = ++pts->count;
+   mutex_unlock(&pts->lock);
+
+   if(pts->failat && count == pts->failat)
+      return EIO;
+
+   return 0;
+}
+
+/* Task function spawning and joining a nested scope of counting tasks. */
+int nss_fanout(void *arg)
+{
+   TaskScope scope;
+   NSState *nss;
+   int i;
+
+   nss = (NSState *) arg;
+
+   scope_init(&scope, nss->pool);
+   for(i = 0; i < 10; i++)
+      scope_spawn(&scope, pts_inc, nss->pts);
+
+   return scope_join(&scope);
+}
+
+/* Struct for recording the start latency of an interactive task. */
+typedef struct {
+   long submitted;
+   long latency;
+} LTState;
+
+/* Task function recording the latency between submission and start. */
+int lts_start(void *arg)
+{
+   LTState *lts = (LTState *) arg;
+
+   lts->latency = microelapsed(lts->submitted);
+
+   return 0;
+}
+
+/* Task function occupying a worker for `*arg` microseconds. */
+int spin_task(void *arg)
+{
+   long ustart = microseconds();
+
+   while(microelapsed(ustart) < *((long *) arg));
+
+   return 0;
+}
+
+/* Task function occupying a worker until `*arg` is non-zero. */
+int gate_task(void *arg)
+{
+   while(*((volatile int *) arg) == 0) millisleep(1);
+
+   return 0;
+}
+
+/* Task function recording the current count as its order of execution. */
+int order_task(void *arg)
+{
+   PTState *pts = (PTState *) arg;
+
+   pts->failat = pts->count;
+
+   return 0;
+}
+
+/* Task function counting, then occupying a worker for SPIN_US. */
+int spin_inc(void *arg)
+{
+   static long spin = SPIN_US;
+
+   pts_inc(arg);
+
+   return spin_task(&spin);
+}
+
+/* Task function blocking a worker for `*arg` milliseconds. */
+int sleep_task(void *arg)
+{
+   millisleep(*((unsigned long *) arg));
+
+   return 0;
+}
+
+/* Comparison function for sorting latencies. */
+int cmp_long(const void *a, const void *b)
+{
+   long la = *((const long *) a), lb = *((const long *) b);
+
+   return (la > lb) - (la < lb);
+}
+
+/* Thread function equivalent of pts_inc(), for comparison. */
+Threaded pts_thread(void *arg)
+{
+   pts_inc(arg);
+
+   return Treturn;
+}
+
+/* Task function of the second translation unit */
+int unit_task_token(void *arg);
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   ThreadPool pool, single;
+   CancelToken *tokens[2];
+   TaskScope scope;
+   PTState pts;
+   NSState nss;
+   ThreadID *tids;
+   LTState lts[INTERACTIVE];
+   long latency[2][INTERACTIVE];
+   long batch_us = BATCH_US;
+   unsigned long load_ms = LOAD_MS;
+   long reaction, settled, retired;
+   int peak;
+   float elapsed, elapsed2;
+   long ustart;
+   int i, j, res, fail;
+   volatile int gate;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Multiplatform Thread Pool tests...\n");
+
+   memset(&pts, 0, sizeof(pts));
+   mutex_init(&pts.lock);
+
+
+   printf("\nThread pool tests w/ %d workers - mppool.h;\n", WORKERS);
+   printf("  Detached tasks drained on free... ");
+   res = pool_init(&pool, WORKERS);
+   for(i = 0; i < TASKS && res == 0; i++)
+      res = pool_submit(&pool, pts_inc, &pts);
+   res |= pool_free(&pool);
+   if(res == 0 && pts.count == TASKS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. count= %d, res= %d\n", pts.count, res);
+   }
+
+
+   printf("\nTask scope tests - mppool.h;\n");
+   pool_init(&pool, WORKERS);
+
+   printf("  Scope joins all children...       ");
+   pts.count = 0;
+   scope_init(&scope, &pool);
+   for(i = 0; i < TASKS; i++)
+      scope_spawn(&scope, pts_inc, &pts);
+   res = scope_join(&scope);
+   if(res == 0 && pts.count == TASKS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. count= %d, res= %d\n", pts.count, res);
+   }
+
+   printf("  First error cancels siblings...   ");
+   pts.count = 0;
+   pts.failat = FAILAT;
+   scope_init(&scope, &pool);
+   for(i = 0; i < TASKS; i++) {
+      if(scope_spawn(&scope, pts_inc, &pts)) break;
+   }
+   res = scope_join(&scope);
+   pts.failat = 0;
+   if(res == EIO && pts.count >= FAILAT && pts.count < TASKS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. count= %d, res= %d\n", pts.count, res);
+   }
+
+   printf("  Manual cancellation...            ");
+   scope_init(&scope, &pool);
+   scope_cancel(&scope);
+   res = scope_spawn(&scope, pts_inc, &pts);
+   if(res == ECANCELED && scope_join(&scope) == ECANCELED)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d\n", res);
+   }
+
+   printf("  Nested scopes on single worker... ");
+   pts.count = 0;
+   pool_init(&single, 1);
+   nss.pool = &single;
+   nss.pts = &pts;
+   scope_init(&scope, &single);
+   for(i = 0; i < 10; i++)
+      scope_spawn(&scope, nss_fanout, &nss);
+   res = scope_join(&scope);
+   pool_free(&single);
+   if(res == 0 && pts.count == 100)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. count= %d, res= %d\n", pts.count, res);
+   }
+
+   printf("  Token across units...             ");
+   memset(tokens, 0, sizeof(tokens));
+   scope_init(&scope, &pool);
+   res = scope_spawn(&scope, unit_task_token, &tokens[0]);
+   res |= scope_join(&scope);
+   /* detached tasks are drained on free */
+   res |= pool_init(&single, 1);
+   res |= pool_submit(&single, unit_task_token, &tokens[1]);
+   res |= pool_free(&single);
+   if(res == 0 && tokens[0] == &scope.cancel && tokens[1] == &single.cancel)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. res= %d\n", res);
+   }
+
+
+   printf("\nFan-out comparison w/ %d children - mppool.h;\n", CHILDREN);
+   printf("  Thread per child vs. task scope... ");
+   tids = (ThreadID *) malloc(sizeof(ThreadID) * CHILDREN);
+   pts.count = 0;
+   ustart = microseconds();
+   for(i = 0; i < CHILDREN; i++)
+      thread_create(&tids[i], pts_thread, &pts);
+   thread_multiwait(tids, CHILDREN);
+   elapsed = (float) microelapsed(ustart) / MICROSECONDS;
+   free(tids);
+   ustart = microseconds();
+   scope_init(&scope, &pool);
+   for(i = 0; i < CHILDREN; i++)
+      scope_spawn(&scope, pts_inc, &pts);
+   res = scope_join(&scope);
+   elapsed2 = (float) microelapsed(ustart) / MICROSECONDS;
+   printf("%.06fs / %.06fs, ", elapsed, elapsed2);
+   if(res == 0 && pts.count == CHILDREN * 2 && elapsed2 < elapsed)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   pool_free(&pool);
+
+
+   printf("\nPriority lane scheduling - mppool.h;\n");
+   printf("  Deadline order within a lane...  ");
+   pool_init(&single, 1);
+   pool_schedule(&single, 2, STARVE_US);
+   gate = 0;
+   pool_submit(&single, gate_task, (void *) &gate);
+   ustart = microseconds();
+   /* submit in reverse deadline order; latency reveals execution order */
+   for(i = 0; i < 8; i++)
+      pool_submit_at(&single, 0, ustart + MICROSECONDS - i, lts_start, &lts[i]);
+   for(i = 0; i < 8; i++) lts[i].submitted = microseconds();
+   gate = 1;
+   pool_free(&single);
+   for(i = 1, res = 0; i < 8; i++)
+      res |= lts[i].latency > lts[i - 1].latency;
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   printf("  Starvation protection...         ");
+   pool_init(&single, 1);
+   pool_schedule(&single, 2, STARVE_US);
+   gate = 0;
+   pts.count = 0;
+   pts.failat = -1;
+   pool_submit(&single, gate_task, (void *) &gate);
+   for(i = 0; i < 100; i++)
+      pool_submit(&single, spin_inc, &pts);
+   pool_submit_at(&single, 1, 0, order_task, &pts);
+   gate = 1;
+   pool_free(&single);
+   printf("lane 1 ran after %d of 100 lane 0 tasks, ", pts.failat);
+   if(pts.failat >= 0 && pts.failat < 100)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   pts.failat = 0;
+
+
+   printf("\nInteractive latency under batch saturation - mppool.h;\n");
+   for(j = 0; j < 2; j++) {
+      printf("  %s... ", j ? "EDF w/ priority lanes" : "FIFO                 ");
+      pool_init(&pool, 2);
+      if(j) pool_schedule(&pool, 2, STARVE_US);
+      for(i = 0; i < BATCH_TASKS; i++)
+         pool_submit_at(&pool, 1, 0, spin_task, &batch_us);
+      for(i = 0; i < INTERACTIVE; i++) {
+         lts[i].submitted = microseconds();
+         pool_submit_at(&pool, 0, lts[i].submitted + INTERACTIVE_US,
+            lts_start, &lts[i]);
+         millisleep(1);
+      }
+      pool_free(&pool);
+      for(i = 0; i < INTERACTIVE; i++) latency[j][i] = lts[i].latency;
+      qsort(latency[j], INTERACTIVE, sizeof(long), cmp_long);
+      printf("p50/p99/max= %ld/%ld/%ldus\n", latency[j][INTERACTIVE / 2],
+         latency[j][(INTERACTIVE * 99) / 100], latency[j][INTERACTIVE - 1]);
+   }
+   printf("  EDF improves p99 latency... ");
+   i = (INTERACTIVE * 99) / 100;
+   if(latency[1][i] < latency[0][i])
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+
+   printf("\nElastic pool load step w/ 1..%d workers - mppool.h;\n",
+      ELASTIC_MAX);
+   printf("  Reaction to load step...   ");
+   pool_init_elastic(&pool, 1, ELASTIC_MAX, GROW_US, IDLE_MS);
+   reaction = settled = -1;
+   peak = 1;
+   ustart = microseconds();
+   /* offer ~2 tasks per millisecond of LOAD_MS blocking duration */
+   while(microelapsed(ustart) < STEP_MS * MILLISECONDS) {
+      pool_submit(&pool, sleep_task, &load_ms);
+      pool_submit(&pool, sleep_task, &load_ms);
+      millisleep(1);
+      if(reaction < 0 && pool_threads(&pool) > 1)
+         reaction = microelapsed(ustart);
+      if(pool_threads(&pool) > peak) {
+         peak = pool_threads(&pool);
+         settled = microelapsed(ustart);
+      }
+   }
+   printf("first growth in %.03fms, %d workers in %.03fms, ",
+      (double) reaction / MILLISECONDS, peak, (double) settled / MILLISECONDS);
+   if(reaction >= 0 && peak > 1)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  Retirement after load...   ");
+   ustart = microseconds();
+   while(pool_threads(&pool) > 1 && microelapsed(ustart) < MICROSECONDS)
+      millisleep(1);
+   retired = microelapsed(ustart);
+   printf("1 worker in %.03fms, ", (double) retired / MILLISECONDS);
+   if(pool_threads(&pool) == 1)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. workers= %d\n", pool_threads(&pool));
+   }
+   pool_free(&pool);
+
+   mutex_free(&pts.lock);
+
+
+   return fail;
+}
@@ -0,0 +1,321 @@
+/* ****************************************************************
+ * Test sampling profiler.
+ *  - mpprof.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Sampling profiler:
+ * - Sample counts proportional to the CPU time of profiled threads
+ * - Attribution of samples to the functions consuming CPU time
+ * - Folded stack output, for flame graphs
+ * - Profiling overhead, within a budget percentage of CPU time
+ * - A single active Profiler across translation units, linked with
+ *   unit/mpprof.c
+ * - Free while profiled threads are sampled; no handler left in flight
+ *
+ * NOTES:
+ * - The overhead budget may be configured at compile time, with
+ *   -DBUDGET=<percent>.
+ * - The profiler is Linux only; the test is skipped elsewhere.
+ *
+ * ****************************************************************/
+
+#define _GNU_SOURCE
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+
+#include "../src/mpprof.h"
+
+#define OUTFILE  "mpprof.folded"
+#define HZ       1000
+#define THREADS  2
+#define SPINS    40000000  /* iterations of the lesser workload */
+#define RUNS     3         /* overhead measurements, best of */
+#define ACCURACY 20        /* sample count tolerance, percent */
+#define FREEHZ   10000     /* sampling frequency of the free test */
+
+/* Profiling overhead budget, percent of CPU time */
+#ifndef BUDGET
+#define BUDGET  5
+#endif
+
+/****************************************************************/
+
+Profiler Prof;
+volatile unsigned long Sink;
+volatile int Stop, Spinning;
+long long Cputime[THREADS];
+
+/* Profiler functions of the second translation unit */
+int unit_prof_init(Profiler *prof, unsigned hz);
+Profiler *unit_prof_active(void);
+
+/* CPU time of the calling thread, in nanoseconds. */
+long long thread_cputime(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return (long long) ts.tv_sec * NANOSECONDS + ts.tv_nsec;
+}
+
+/* Workloads of distinct functions, spinning `n` iterations. */
+__attribute__((noinline)) void spin_a(long n)
+{
+   unsigned long x = Sink;
+
+   while(n--) x = x * 6364136223846793005UL + 1442695040888963407UL;
+   Sink = x;
+}
+
+__attribute__((noinline)) void spin_b(long n)
+{
+   unsigned long x = Sink;
+
+   while(n--) x = x * 6364136223846793005UL + 1442695040888963407UL;
+   Sink = x;
+}
+
+/* Workload spending two thirds of its CPU time in spin_a().
+ * Returns the CPU time consumed, in nanoseconds. */
+long long workload(void)
+{
+   long long start = thread_cputime();
+
+   spin_a(2L * SPINS);
+   spin_b(SPINS);
+
+   return thread_cputime() - start;
+}
+
+/* Thread function profiling a workload. */
+Threaded th_profile(void *arg)
+{
+   long long *cputime = (long long *) arg;
+
+   if(prof_register(&Prof) == 0) {
+      *cputime = workload();
+      prof_unregister(&Prof);
+   }
+
+   return Treturn;
+}
+
+/* Thread function spinning profiled until stopped, never unregistering;
+ * its timer is deleted by prof_free(). */
+Threaded th_spin(void *arg)
+{
+   (void) arg;
+
+   if(prof_register(&Prof) == 0) {
+      __atomic_add_fetch(&Spinning, 1, __ATOMIC_SEQ_CST);
+      while(!__atomic_load_n(&Stop, __ATOMIC_ACQUIRE)) spin_a(1000);
+   }
+
+   return Treturn;
+}
+
+/* Attribute a leaf frame to the nearest preceding workload function.
+ * Returns 0 for spin_a(), 1 for spin_b(), else -1. */
+int leaf_function(void *pc)
+{
+   char *a = (char *) spin_a, *b = (char *) spin_b, *p = (char *) pc;
+   char *start = NULL;
+   int fn = -1;
+
+   if(p >= a && (start == NULL || a > start)) { start = a; fn = 0; }
+   if(p >= b && (start == NULL || b > start)) { start = b; fn = 1; }
+   if(start == NULL || p - start > 4096) return -1;
+
+   return fn;
+}
+
+/* Verify folded stack lines; frames without spaces, joined by ';',
+ * followed by a space and a sample count. Returns the number of
+ * invalid lines, and sets the total of sample counts. */
+int check_folded(FILE *fp, unsigned long *total)
+{
+   char line[PROF_DEPTH * PROF_SYMLEN + 32], *sp, *p;
+   unsigned long count;
+   int bad;
+
+   *total = 0;
+   for(bad = 0; fgets(line, sizeof(line), fp); ) {
+      sp = strrchr(line, ' ');
+      if(sp == NULL || sp == line || sscanf(sp, " %lu\n", &count) != 1 ||
+         count == 0) {
+         bad++;
+         continue;
+      }
+      for(p = line; p < sp; p++) {
+         if(*p == ' ' || (*p == ';' && (p == line || p[-1] == ';'))) break;
+      }
+      if(p < sp || sp[-1] == ';') bad++;
+      *total += count;
+   }
+
+   return bad;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   ThreadID tid[THREADS];
+   Profiler other;
+   PROF_STACK *st;
+   unsigned long fn[2], total;
+   long long cputime, profiled, off, on;
+   double expect, overhead;
+   unsigned i;
+   int res, fail;
+   FILE *fp;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Sampling Profiler tests...\n");
+
+
+   printf("\nSampling w/ %d threads at %dHz - mpprof.h;\n", THREADS, HZ);
+   printf("  Samples per CPU time...  ");
+   res = prof_init(&Prof, HZ);
+   if(res == 0) {
+      for(i = 0; i < THREADS; i++)
+         thread_create(&tid[i], th_profile, &Cputime[i]);
+      thread_multiwait(tid, THREADS);
+      res = prof_collect(&Prof);
+   }
+   for(cputime = i = 0; i < THREADS; i++) cputime += Cputime[i];
+   profiled = cputime;
+   expect = (double) cputime * HZ / NANOSECONDS;
+   printf("%lu/%.0f, ", Prof.samples, expect);
+   if(res == 0 && Prof.dropped == 0 &&
+      Prof.samples > expect * (100 - ACCURACY) / 100 &&
+      Prof.samples < expect * (100 + ACCURACY) / 100)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. dropped= %lu\n", Prof.dropped);
+   }
+
+   printf("  Function attribution...  ");
+   fn[0] = fn[1] = 0;
+   for(i = 0; i < Prof.cap; i++) {
+      st = &Prof.stacks[i];
+      if(st->count == 0) continue;
+      res = leaf_function(st->pc[0]);
+      if(res >= 0) fn[res] += st->count;
+   }
+   printf("%lu:%lu, ", fn[0], fn[1]);
+   /* two thirds of samples in spin_a(), accounting for nearly all */
+   if(fn[0] + fn[1] > Prof.samples * 9 / 10 && fn[1] > 0 &&
+      (double) fn[0] / fn[1] > 1.5 && (double) fn[0] / fn[1] < 2.5)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   printf("  Folded stack output...   ");
+   res = -1;
+   fp = fopen(OUTFILE, "w+");
+   if(fp) {
+      res = prof_write(&Prof, fp) != (long) Prof.nstacks;
+      rewind(fp);
+      res += check_folded(fp, &total);
+      fclose(fp);
+   }
+   remove(OUTFILE);
+   if(res == 0 && total == Prof.samples)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. invalid= %d\n", res);
+   }
+
+
+   printf("\nProfiling overhead, budget= %d%% - mpprof.h;\n", BUDGET);
+   printf("  Workload CPU time...     ");
+   off = on = 0;
+   for(i = 0; i < RUNS; i++) {
+      cputime = workload();
+      if(off == 0 || cputime < off) off = cputime;
+      prof_register(&Prof);
+      cputime = workload();
+      prof_unregister(&Prof);
+      profiled += cputime;
+      if(on == 0 || cputime < on) on = cputime;
+   }
+   prof_collect(&Prof);
+   overhead = 100.0 * (double) (on - off) / (double) off;
+   /* handler time, of all CPU time profiled */
+   printf("%+.2f%% (handler %.2f%%), ", overhead,
+      100.0 * (double) Prof.handler_ns / (double) profiled);
+   if(overhead < BUDGET)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nActive profiler - mpprof.h;\n");
+   printf("  Single across units...   ");
+   res = unit_prof_init(&other, HZ);
+   if(res == EBUSY && unit_prof_active() == &Prof &&
+      prof_init(&other, HZ) == EBUSY) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %d\n", res);
+   }
+   prof_free(&Prof);
+
+   printf("  Free while sampling...   ");
+   res = prof_init(&Prof, FREEHZ);
+   if(res == 0) {
+      for(i = 0; i < THREADS; i++) thread_create(&tid[i], th_spin, NULL);
+      while(__atomic_load_n(&Spinning, __ATOMIC_SEQ_CST) < THREADS)
+         millisleep(1);
+      millisleep(100);
+      res = prof_free(&Prof);
+      __atomic_store_n(&Stop, 1, __ATOMIC_RELEASE);
+      thread_multiwait(tid, THREADS);
+   }
+   if(res == 0 && unit_prof_active() == NULL && Inflight_mpprof == 0 &&
+      unit_prof_init(&other, HZ) == 0 && prof_free(&other) == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %d\n", res);
+   }
+
+
+   return fail;
+}
+
+#else
+
+int main()
+{
+   printf("\nSampling profiler tests skipped, Linux only.\n");
+
+   return 0;
+}
+
+#endif
@@ -0,0 +1,252 @@
+/* ****************************************************************
+ * Test lock-free rate support.
+ *  - mprate.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Sliding window counters and EWMA meters:
+ * - Every event of many threads counted within the window
+ * - Events expire from the window, and stale buckets are reset
+ * - Window and meter rates of steady events near the measured rate
+ * - Meter decay after events stop
+ * - Cost of increments and queries, at 1..N threads, versus a Mutex
+ *   guarded counter
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mprate.h"
+
+#define THREADS    4
+#define EVENTS     200000   /* events per thread, correctness */
+#define STEADY_MS  500      /* duration of steady events */
+#define BENCH_MS   100      /* duration of each benchmark run */
+#define TOLERANCE  0.25     /* relative tolerance of rates */
+
+#define dabs(x)  ( (x) < 0 ? -(x) : (x) )
+
+/****************************************************************/
+
+/* Counting thread arguments; a window, a meter, or a Mutex guarded
+ * counter, incremented for a count, or for BENCH_MS. */
+typedef struct {
+   RateWindow *window;
+   Meter *meter;
+   Mutex *lock;
+   long long *counter;
+   int events;
+   long long ops;
+   long long ns;
+} COUNTER;
+
+/* Thread incrementing a window, meter, or Mutex guarded counter. */
+Threaded thread_count(void *arg)
+{
+   COUNTER *c = (COUNTER *) arg;
+   long long n, nstart;
+   long mstart;
+   int i;
+
+   mstart = milliseconds();
+   nstart = nanoseconds();
+   for(n = 0; c->events ? n < c->events :
+      millielapsed(mstart) < BENCH_MS; n += 64) {
+      for(i = 0; i < 64; i++) {
+         if(c->window) rate_inc(c->window);
+         else if(c->meter) meter_mark(c->meter, 1);
+         else {
+            mutex_lock(c->lock);
+            (*c->counter)++;
+            mutex_unlock(c->lock);
+         }
+      }
+   }
+   c->ns = nanoelapsed(nstart);
+   c->ops = n;
+
+   return Treturn;
+}
+
+/* Run `threads` counting threads of template `c`.
+ * Returns mean nanoseconds per operation per thread, or -1 on error. */
+double run(COUNTER *c, int threads)
+{
+   ThreadID tid[THREADS];
+   COUNTER arg[THREADS];
+   long long ops, ns;
+   int i;
+
+   for(i = 0; i < threads; i++) {
+      arg[i] = *c;
+      if(thread_create(&tid[i], thread_count, &arg[i])) return -1;
+   }
+   for(ops = ns = 0, i = 0; i < threads; i++) {
+      thread_wait(&tid[i]);
+      ops += arg[i].ops;
+      ns += arg[i].ns;
+   }
+   c->ops = ops;
+
+   return ops ? (double) ns / (double) ops : -1;
+}
+
+/* Returns non-zero if `rate` differs from `expect` beyond TOLERANCE. */
+static int differs(double rate, double expect)
+{
+   return dabs(rate - expect) > TOLERANCE * expect;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   RateWindow window;
+   Meter meter;
+   Mutex lock;
+   COUNTER c;
+   long long counter, events;
+   double actual, wrate, mrate, ns[3];
+   long mstart, elapsed;
+   int threads, cpus, i, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Rate Counter tests...\n");
+
+
+   printf("\nSliding window w/ %d threads - mprate.h;\n", THREADS);
+   printf("  Every event counted...          ");
+   memset(&c, 0, sizeof(c));
+   rate_init(&window, 10, 1000);
+   c.window = &window;
+   c.events = EVENTS;
+   run(&c, THREADS);
+   if(rate_count(&window) == (unsigned long long) THREADS * EVENTS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %llu/%d\n", rate_count(&window), THREADS * EVENTS);
+   }
+   printf("  Events expire and reset...      ");
+   rate_init(&window, 5, 10);
+   for(i = 0; i < 1000; i++) rate_inc(&window);
+   events = (long long) rate_count(&window);
+   millisleep(100);
+   if(events == 1000 && rate_count(&window) == 0) {
+      /* buckets of a previous lap are reset by increments */
+      for(i = 0; i < 10; i++) rate_inc(&window);
+      if(rate_count(&window) == 10) printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed. reset count %llu\n", rate_count(&window));
+      }
+   } else {
+      fail++;
+      printf("Failed. %lld, then %llu\n", events, rate_count(&window));
+   }
+   printf("  Invalid buckets or width...     ");
+   if(rate_init(&window, 0, 10) == EINVAL &&
+      rate_init(&window, RATE_BUCKETS + 1, 10) == EINVAL &&
+      rate_init(&window, 1, 0) == EINVAL && meter_init(&meter, 0) == EINVAL)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nSteady events for %dms - mprate.h;\n", STEADY_MS);
+   rate_init(&window, 10, 20);
+   meter_init(&meter, 100);
+   mstart = milliseconds();
+   for(events = 0; (elapsed = millielapsed(mstart)) < STEADY_MS; events++) {
+      rate_inc(&window);
+      meter_mark(&meter, 1);
+      /* query periodically, as a monitor would */
+      if((events & 1023) == 0) meter_rate(&meter);
+   }
+   actual = (double) events * 1000.0 / (double) elapsed;
+   wrate = rate_persecond(&window);
+   mrate = meter_rate(&meter);
+   printf("  measured %.0f/s, window %.0f/s, meter %.0f/s\n",
+      actual, wrate, mrate);
+   printf("  Window rate near measured...    ");
+   if(!differs(wrate, actual)) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  Meter rate near measured...     ");
+   if(!differs(mrate, actual)) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  Meter decays after 3 tau...     ");
+   millisleep(300);
+   mrate = meter_rate(&meter);
+   /* e^-3 is about 5% of the steady rate */
+   if(mrate < actual * 0.10 && mrate > 0.0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %.0f/s\n", mrate);
+   }
+
+
+   cpus = thread_cpucount();
+   if(cpus > THREADS) cpus = THREADS;
+   printf("\nIncrement cost, 1..%d threads - mprate.h;\n", cpus);
+   printf("  threads     window      meter      mutex\n");
+   mutex_init(&lock);
+   for(threads = 1; threads <= cpus; threads *= 2) {
+      for(i = 0; i < 3; i++) {
+         memset(&c, 0, sizeof(c));
+         rate_init(&window, 10, 100);
+         meter_init(&meter, 1000);
+         counter = 0;
+         if(i == 0) c.window = &window;
+         else if(i == 1) c.meter = &meter;
+         else {
+            c.lock = &lock;
+            c.counter = &counter;
+         }
+         ns[i] = run(&c, threads);
+      }
+      printf("  %7d %8.1fns %8.1fns %8.1fns\n", threads, ns[0], ns[1], ns[2]);
+   }
+   mutex_free(&lock);
+   /* query cost of a window, and of a meter decay */
+   mstart = milliseconds();
+   for(events = 0; millielapsed(mstart) < BENCH_MS; events++) {
+      wrate = rate_persecond(&window);
+      mrate = meter_rate(&meter);
+   }
+   printf("  query (window + meter) %8.1fns\n",
+      (double) BENCH_MS * 1000000.0 / (double) events);
+   printf("  Lock-free increments...         ");
+   if(ns[0] > 0 && ns[1] > 0 && ns[1] <= ns[2]) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   return fail;
+}
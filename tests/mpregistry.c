@@ -0,0 +1,154 @@
+/* ****************************************************************
+ * Test the thread registry across translation units.
+ *  - mpregistry.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Process-wide thread registry, linked with unit/mpregistry.c:
+ * - Threads registered in different translation units assigned distinct
+ *   indexes
+ * - A thread registered in one translation unit holds the same index in
+ *   every translation unit, and registering again retains it
+ * - Unregistering in one translation unit is seen by every other
+ * - Enumeration of live threads equal across translation units
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpthread.h"
+
+#define THREADS  32
+
+/* Registry functions of the second translation unit */
+int unit_register(void);
+int unit_index(void);
+int unit_unregister(void);
+int unit_enumerate(void);
+
+/****************************************************************/
+
+/* Registering thread arguments. */
+typedef struct {
+   Mutex *lock;
+   Condition *done;
+   int *registered;
+   int unit;         /* translation unit of registration, 0 or 1 */
+   int idx;          /* index, as registered */
+   int other;        /* index, as seen by the other translation unit */
+   int release;      /* set to release the thread */
+} REGISTRANT;
+
+/* Thread registering in a translation unit, and holding registration
+ * until released. */
+Threaded thread_registrant(void *arg)
+{
+   REGISTRANT *r = (REGISTRANT *) arg;
+
+   r->idx = r->unit ? unit_register() : thread_register();
+   r->other = r->unit ? thread_index() : unit_index();
+   mutex_lock(r->lock);
+   (*r->registered)++;
+   condition_broadcast(r->done);
+   while(!r->release) condition_wait(r->done, r->lock);
+   mutex_unlock(r->lock);
+
+   return Treturn;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   static REGISTRANT reg[THREADS];
+   static unsigned char seen[THREAD_REGISTRY_MAX];
+   ThreadID tid[THREADS];
+   Condition done;
+   Mutex lock;
+   int registered, idx, res, i, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Thread Registry tests...\n");
+
+
+   printf("\nRegistry across translation units - mpthread.h;\n");
+   printf("  Same thread, same index...      ");
+   idx = thread_register();
+   if(idx >= 0 && unit_index() == idx && unit_register() == idx)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %d/%d\n", idx, unit_index());
+   }
+
+   printf("  Distinct indexes w/ %d threads..", THREADS);
+   mutex_init(&lock);
+   condition_init(&done);
+   registered = 0;
+   memset(seen, 0, sizeof(seen));
+   seen[idx] = 1;
+   for(i = 0; i < THREADS; i++) {
+      reg[i].lock = &lock;
+      reg[i].done = &done;
+      reg[i].registered = &registered;
+      reg[i].unit = i & 1;
+      thread_create(&tid[i], thread_registrant, &reg[i]);
+   }
+   mutex_lock(&lock);
+   while(registered < THREADS) condition_wait(&done, &lock);
+   mutex_unlock(&lock);
+   for(res = i = 0; i < THREADS; i++) {
+      if(reg[i].idx < 0 || reg[i].idx != reg[i].other || seen[reg[i].idx])
+         res++;
+      else seen[reg[i].idx] = 1;
+   }
+   if(res == 0) printf(" Pass!\n");
+   else {
+      fail++;
+      printf(" Failed. duplicated= %d\n", res);
+   }
+
+   printf("  Enumeration equal...            ");
+   res = thread_enumerate(NULL, NULL, THREAD_REGISTRY_MAX);
+   if(res == THREADS + 1 && unit_enumerate() == res) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %d/%d\n", res, unit_enumerate());
+   }
+   mutex_lock(&lock);
+   for(i = 0; i < THREADS; i++) reg[i].release = 1;
+   condition_broadcast(&done);
+   mutex_unlock(&lock);
+   thread_multiwait(tid, THREADS);
+
+   printf("  Unregister seen by all...       ");
+   res = unit_unregister();
+   if(res == 0 && thread_index() == -1 && unit_index() == -1 &&
+      thread_unregister() == -1 && unit_enumerate() == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   condition_free(&done);
+   mutex_free(&lock);
+
+
+   return fail;
+}
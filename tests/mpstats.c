@@ -0,0 +1,279 @@
+/* ****************************************************************
+ * Test statistics kernel support.
+ *  - mpstats.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Statistics kernels, at every kernel level supported:
+ * - Summary statistics and histogram counts equal to the scalar kernel,
+ *   across sizes and (mis)alignments
+ * - Exact percentiles equal to those of a sorted copy
+ * - Histogram percentiles near exact percentiles, given dense bins
+ * - Time of summary statistics versus the scalar kernel, failing where
+ *   a vector kernel is slower
+ * - Time of histogram binning, and of a selected percentile versus a
+ *   qsort() percentile
+ *
+ * Usage:
+ *   mpstats [samples]
+ *   (samples of the benchmark, default SAMPLES)
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpstats.h"
+#include "../src/mptime.h"
+
+#define SAMPLES  4000000  /* samples of the benchmark */
+#define CHECKS   100003   /* samples of correctness checks */
+#define BINS     1000
+#define REPEATS  3        /* benchmark runs per kernel, best time taken */
+
+#define dabs(x)  ( (x) < 0 ? -(x) : (x) )
+
+static const char *Levels[] = { "scalar", "sse2", "avx2" };
+
+/****************************************************************/
+
+static unsigned long long Seed = 1;
+
+/* Returns the next pseudo-random number (splitmix64). */
+static unsigned long long rnd(void)
+{
+   unsigned long long z = (Seed += 0x9E3779B97F4A7C15ULL);
+
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   return z ^ (z >> 31);
+}
+
+/* Returns a pseudo-random latency-like sample, in microseconds; mostly
+ * near 100us, with a long tail. */
+static double sample(void)
+{
+   double u = (double) (rnd() >> 11) / 9007199254740992.0;
+
+   return 100.0 + 20.0 * u + (u > 0.99 ? 5000.0 * (u - 0.99) * 100.0 : 0);
+}
+
+int cmp_double(const void *a, const void *b)
+{
+   double x = *(const double *) a, y = *(const double *) b;
+
+   return (x > y) - (x < y);
+}
+
+/* Returns non-zero if `a` and `b` differ beyond a relative `tolerance`. */
+static int differs(double a, double b, double tolerance)
+{
+   return dabs(a - b) > tolerance * (dabs(a) + dabs(b) + 1e-300);
+}
+
+/* Compare summary statistics and histogram counts of `n` samples at `x`
+ * at the selected kernel level, with the scalar kernel.
+ * Returns the number of mismatches. */
+int check_level(const double *x, size_t n, int level)
+{
+   size_t expect[BINS], counts[BINS];
+   Stats a, b;
+   int bad;
+
+   memset(expect, 0, sizeof(expect));
+   memset(counts, 0, sizeof(counts));
+   stats_setlevel(STATS_SCALAR);
+   stats_summary(x, n, &a);
+   stats_histogram(x, n, 90.0, 130.0, expect, BINS);
+   stats_setlevel(level);
+   stats_summary(x, n, &b);
+   stats_histogram(x, n, 90.0, 130.0, counts, BINS);
+   bad = a.count != b.count || a.min != b.min || a.max != b.max;
+   bad += differs(a.mean, b.mean, 1e-12);
+   bad += differs(a.variance, b.variance, 1e-9);
+   bad += memcmp(expect, counts, sizeof(counts)) != 0;
+
+   return bad;
+}
+
+/* Compare exact and histogram percentiles of `n` samples at `x`, with
+ * those of a sorted copy. Returns the number of mismatches. */
+int check_percentiles(const double *x, size_t n)
+{
+   static const double ps[] = { 0, 1, 25, 50, 90, 99, 99.9, 100 };
+   size_t counts[BINS];
+   double *sorted, *work, rank, expect, width;
+   size_t i, k;
+   int bad;
+
+   bad = 0;
+   sorted = (double *) malloc(sizeof(double) * n);
+   work = (double *) malloc(sizeof(double) * n);
+   if(!sorted || !work) bad = 1;
+   else {
+      memcpy(sorted, x, sizeof(double) * n);
+      qsort(sorted, n, sizeof(double), cmp_double);
+      memset(counts, 0, sizeof(counts));
+      stats_histogram(x, n, 100.0, 120.0, counts, BINS);
+      width = 20.0 / BINS;
+      for(i = 0; i < sizeof(ps) / sizeof(*ps); i++) {
+         rank = ps[i] / 100.0 * (double) (n - 1);
+         k = (size_t) rank;
+         expect = sorted[k];
+         if(k + 1 < n) expect += (sorted[k + 1] - sorted[k]) * (rank - k);
+         memcpy(work, x, sizeof(double) * n);
+         bad += differs(stats_percentile(work, n, ps[i]), expect, 1e-12);
+         /* approximate where bins are dense, and within the range (the
+          * tail exceeds the range) */
+         if(n >= 10 * BINS && expect >= 100.0 && expect < 120.0) {
+            bad += dabs(stats_binpercentile(counts, BINS, 100.0, 120.0,
+               ps[i]) - expect) > 2 * width;
+         }
+      }
+   }
+   free(work);
+   free(sorted);
+
+   return bad;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main(int argc, char **argv)
+{
+   static const size_t sizes[] = { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 1000 };
+   size_t counts[BINS];
+   double *x, *work, p99;
+   long long nstart, ns, best, base[3];
+   Stats stats;
+   size_t n, i, j;
+   int res, level, cpu, fail, slower, r;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Statistics Kernel tests...\n");
+
+   cpu = stats_level();
+   x = (double *) malloc(sizeof(double) * (CHECKS + 1));
+   if(x == NULL) {
+      printf("\n  Failed. out of memory\n");
+      return 1;
+   }
+   for(i = 0; i <= CHECKS; i++) x[i] = sample();
+
+
+   printf("\nStatistics kernels w/ %s processor - mpstats.h;\n",
+      Levels[cpu]);
+   for(level = STATS_SSE2; level <= cpu; level++) {
+      printf("  %-6s vs. scalar...        ", Levels[level]);
+      for(res = 0, i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+         /* aligned, and misaligned by one sample */
+         for(j = 0; j < 2; j++) res += check_level(x + j, sizes[i], level);
+      }
+      res += check_level(x + 1, CHECKS, level);
+      if(res == 0) printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed. mismatched= %d\n", res);
+      }
+   }
+   stats_setlevel(cpu);
+   printf("  Percentiles vs. qsort()...   ");
+   res = check_percentiles(x, CHECKS) + check_percentiles(x, 1);
+   res += check_percentiles(x, 2) + check_percentiles(x, 1000);
+   /* heavily duplicated samples */
+   for(i = 0; i < 1000; i++) x[i] = (double) (rnd() % 3);
+   res += check_percentiles(x, 1000);
+   if(res == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d\n", res);
+   }
+   printf("  Invalid histogram range...   ");
+   if(stats_histogram(x, 1, 1.0, 1.0, counts, BINS) == EINVAL &&
+      stats_histogram(x, 1, 0.0, 1.0, counts, 0) == EINVAL) {
+      printf("Pass!\n");
+   } else {
+      fail++;
+      printf("Failed.\n");
+   }
+   free(x);
+
+
+   n = argc > 1 ? (size_t) atol(argv[1]) : SAMPLES;
+   if(n < 1) n = SAMPLES;
+   printf("\nKernel time w/ %lu samples - mpstats.h;\n", (unsigned long) n);
+   x = (double *) malloc(sizeof(double) * n);
+   work = (double *) malloc(sizeof(double) * n);
+   if(!x || !work) {
+      fail++;
+      printf("  Failed. out of memory\n");
+   } else {
+      for(i = 0; i < n; i++) x[i] = sample();
+      memcpy(work, x, sizeof(double) * n);
+      printf("  kernel     summary   speedup\n");
+      for(slower = 0, level = STATS_SCALAR; level <= cpu; level++) {
+         stats_setlevel(level);
+         for(r = 0; r < REPEATS; r++) {
+            nstart = nanoseconds();
+            stats_summary(x, n, &stats);
+            ns = nanoelapsed(nstart);
+            if(r == 0 || ns < best) best = ns;
+         }
+         if(level == STATS_SCALAR) base[0] = best;
+         if(best > base[0]) slower++;
+         printf("  %-6s %8.2fms %8.2fx\n", Levels[level],
+            (double) best / 1000000, (double) base[0] / (double) best);
+      }
+      memset(counts, 0, sizeof(counts));
+      nstart = nanoseconds();
+      stats_histogram(x, n, 100.0, 120.0, counts, BINS);
+      base[1] = nanoelapsed(nstart);
+      printf("  histogram  %8.2fms (scalar)\n",
+         (double) base[1] / 1000000);
+      nstart = nanoseconds();
+      p99 = stats_percentile(work, n, 99.0);
+      ns = nanoelapsed(nstart);
+      printf("  p99 select %8.2fms", (double) ns / 1000000);
+      memcpy(work, x, sizeof(double) * n);
+      nstart = nanoseconds();
+      qsort(work, n, sizeof(double), cmp_double);
+      base[2] = nanoelapsed(nstart);
+      printf(" vs. qsort() %8.2fms %8.2fx\n", (double) base[2] / 1000000,
+         (double) base[2] / (double) ns);
+      printf("  Kernels no slower than scalar...  ");
+      if(slower == 0) printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed. slower= %d\n", slower);
+      }
+      printf("  Summarized, p99= %.1fus...  ", p99);
+      if(stats.count == n && stats.min >= 100.0 && stats.mean > 100.0 &&
+         stats.variance > 0.0 && p99 > stats.min && p99 < stats.max) {
+         printf("Pass!\n");
+      } else {
+         fail++;
+         printf("Failed.\n");
+      }
+   }
+   free(work);
+   free(x);
+
+
+   return fail;
+}
@@ -0,0 +1,256 @@
+/* ****************************************************************
+ * Test multiplatform threading support for C++.
+ *  - mpthread.cpp (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * RAII lock guards and lock policies:
+ * - Release of guards on early return, and on exceptions
+ * - Synchronized counters, under every lock policy
+ * - Cost of guards versus the raw C calls they replace, per policy
+ *
+ * NOTES:
+ * - Compiled with optimization (see makefile), as guards rely on
+ *   inlining to compile to the raw C calls. Identical code may be
+ *   confirmed by comparing the disassembly (objdump -d) of raw_mutex()
+ *   and guard_loop<Mutex>(), etc.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdexcept>
+
+#include "../src/mpthread.hpp"
+#include "../src/mptime.h"
+
+#define THREADS  4
+#define ROUNDS   1000000   /* increments per thread */
+#define BENCH    10000000  /* lock/unlock pairs per measurement */
+#define RUNS     5         /* measurements, best of */
+#define SLACK    10        /* guard cost tolerance, percent */
+
+/* Benchmark loops SHALL NOT be inlined into their callers */
+#ifdef _MSC_VER
+#define NOINLINE  __declspec(noinline)
+#else
+#define NOINLINE  __attribute__((noinline))
+#endif
+
+/****************************************************************/
+
+/* A lock policy counting lock and unlock calls. */
+struct CountingLock {
+   int locks, unlocks;
+   void lock() { locks++; }
+   void unlock() { unlocks++; }
+};
+
+/* Return early from within a guarded scope. */
+int early_return(CountingLock &l, int early)
+{
+   mp::LockGuard<CountingLock> guard(l);
+   if(early) return 1;
+
+   return 0;
+}
+
+/* Throw from within a guarded scope. */
+void throw_guarded(CountingLock &l)
+{
+   mp::SharedGuard<CountingLock> guard(l);
+   throw std::runtime_error("guarded");
+}
+
+/* Thread function incrementing a synchronized counter. */
+template<class L>
+Threaded th_count(void *arg)
+{
+   mp::Synchronized<long, L> *count = (mp::Synchronized<long, L> *) arg;
+   long last = 0;
+
+   for(int i = 0; i < ROUNDS; i++) {
+      count->write([](long &v) { v++; });
+      /* a read SHALL never observe a decrease */
+      long v = count->read([](const long &v) { return v; });
+      if(v < last) abort();
+      last = v;
+   }
+
+   return Treturn;
+}
+
+/* Increment a synchronized counter from THREADS threads.
+ * Returns 0 on success, else non-zero. */
+template<class L>
+int count_policy(void)
+{
+   mp::Synchronized<long, L> count(0);
+   ThreadID tid[THREADS];
+   int i;
+
+   for(i = 0; i < THREADS; i++)
+      thread_create(&tid[i], th_count<L>, &count);
+   thread_multiwait(tid, THREADS);
+
+   return count.read([](const long &v) { return v; }) !=
+      (long) THREADS * ROUNDS;
+}
+
+volatile long Shared;
+
+/* Lock/unlock loops, by raw C calls. */
+NOINLINE void raw_mutex(Mutex *m)
+{
+   for(long i = 0; i < BENCH; i++) {
+      mutex_lock(m);
+      Shared = Shared + 1;
+      mutex_unlock(m);
+   }
+}
+
+NOINLINE void raw_rwlock(RWLock *rw)
+{
+   for(long i = 0; i < BENCH; i++) {
+      rwlock_wrlock(rw);
+      Shared = Shared + 1;
+      rwlock_wrunlock(rw);
+   }
+}
+
+NOINLINE void raw_spinlock(Spinlock *s)
+{
+   for(long i = 0; i < BENCH; i++) {
+      spinlock_lock(s);
+      Shared = Shared + 1;
+      spinlock_unlock(s);
+   }
+}
+
+NOINLINE void raw_nolock(mp::NoLock *)
+{
+   for(long i = 0; i < BENCH; i++) Shared = Shared + 1;
+}
+
+/* Lock/unlock loop, by guards. */
+template<class L>
+NOINLINE void guard_loop(L *l)
+{
+   for(long i = 0; i < BENCH; i++) {
+      mp::LockGuard<L> guard(*l);
+      Shared = Shared + 1;
+   }
+}
+
+/* Measure the best of RUNS loops, in nanoseconds per iteration. */
+template<class L>
+double best(void (*loop)(L *), L *l)
+{
+   long long nstart, ns, min = 0;
+
+   for(int run = 0; run < RUNS; run++) {
+      nstart = nanoseconds();
+      loop(l);
+      ns = nanoelapsed(nstart);
+      if(min == 0 || ns < min) min = ns;
+   }
+
+   return (double) min / BENCH;
+}
+
+/* Compare guard and raw loop costs of a lock policy, printing results.
+ * Returns 0 if the guard cost is within SLACK percent, else 1. */
+template<class L>
+int compare(const char *name, void (*raw)(L *))
+{
+   mp::Lock<L> lock;
+   double r, g;
+
+   printf("  %-10s ", name);
+   r = best<L>(raw, lock.native());
+   g = best<L>(guard_loop<L>, lock.native());
+   printf("raw %5.2fns, guard %5.2fns, ", r, g);
+   if(g <= r * (100 + SLACK) / 100 + 0.5) {
+      printf("Pass!\n");
+      return 0;
+   }
+   printf("Failed.\n");
+
+   return 1;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   CountingLock cl = { 0, 0 };
+   int res, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin C++ Lock Guard tests...\n");
+
+
+   printf("\nGuard release - mpthread.hpp;\n");
+   printf("  Early return and exception... ");
+   res = early_return(cl, 1) != 1;
+   res |= early_return(cl, 0) != 0;
+   try {
+      throw_guarded(cl);
+      res |= 1;
+   } catch(const std::runtime_error &) {}
+   if(res == 0 && cl.locks == 3 && cl.unlocks == 3)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. locks= %d, unlocks= %d\n", cl.locks, cl.unlocks);
+   }
+
+
+   printf("\nSynchronized counters w/ %d threads - mpthread.hpp;\n", THREADS);
+   printf("  Mutex policy...    ");
+   if(count_policy<Mutex>() == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  RWLock policy...   ");
+   if(count_policy<RWLock>() == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  Spinlock policy... ");
+   if(count_policy<Spinlock>() == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nGuard cost vs. raw C calls, best of %d - mpthread.hpp;\n", RUNS);
+   fail += compare<Mutex>("Mutex", raw_mutex);
+   fail += compare<RWLock>("RWLock", raw_rwlock);
+   fail += compare<Spinlock>("Spinlock", raw_spinlock);
+   fail += compare<mp::NoLock>("NoLock", raw_nolock);
+
+
+   return fail;
+}
@@ -0,0 +1,242 @@
+/* ****************************************************************
+ * Test multiplatform high resolution time support for C++.
+ *  - mptime.cpp (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * std::chrono compatible clocks:
+ * - Clock traits and constexpr duration conversions, at compile time
+ * - Monotonic time points, of every clock
+ * - Elapsed time of every clock, versus nanoseconds()
+ * - Cost of now(), of every clock, versus std::chrono::steady_clock
+ * - TscClock time points monotonic across translation units (linked
+ *   with unit/mptime.cpp), and across calls of calibrate()
+ *
+ * NOTES:
+ * - Coarse clock precision is that of the scheduler tick, and
+ *   elapsed time is compared within COARSE milliseconds.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <type_traits>
+
+#include "../src/mptime.hpp"
+
+#define READS   1000000  /* now() calls per measurement */
+#define SLEEP   100      /* elapsed time measured, in milliseconds */
+#define COARSE  20       /* coarse clock tolerance, in milliseconds */
+#define TSCPPM  10000    /* time stamp counter tolerance, parts per million */
+
+/* Clock functions of the second translation unit */
+long long unit_tsc_now();
+long long unit_tsc_calibrate();
+
+/* TrivialClock requirements, checked at compile time. */
+template<class C>
+struct ClockTraits {
+   static_assert(std::is_same<typename C::duration,
+      std::chrono::duration<typename C::rep, typename C::period> >::value,
+      "duration SHALL be duration<rep, period>");
+   static_assert(std::is_same<typename C::time_point::clock, C>::value,
+      "time_point SHALL be of the clock");
+   static_assert(std::is_same<typename C::time_point::duration,
+      typename C::duration>::value, "time_point SHALL be of duration");
+   static_assert(C::is_steady, "clock SHALL be steady");
+   static_assert(noexcept(C::now()), "now() SHALL NOT throw");
+   static const bool ok = true;
+};
+
+static_assert(ClockTraits<mp::MonotonicClock>::ok &&
+   ClockTraits<mp::CoarseClock>::ok && ClockTraits<mp::TscClock>::ok,
+   "clock traits");
+
+/* Duration conversions, checked at compile time. */
+static_assert(mp::to_milliseconds(std::chrono::seconds(3)) == 3000L,
+   "to_milliseconds");
+static_assert(mp::to_microseconds(std::chrono::milliseconds(7)) == 7000L,
+   "to_microseconds");
+static_assert(mp::to_nanoseconds(std::chrono::microseconds(5)) == 5000LL,
+   "to_nanoseconds");
+static_assert(mp::to_milliseconds(mp::Nanoseconds(1999999)) == 1L,
+   "to_milliseconds truncates");
+static_assert(mp::MonotonicClock::from_stamp(42).time_since_epoch().count()
+   == 42, "from_stamp");
+
+/****************************************************************/
+
+volatile long long Sink;
+
+/* Read `READS` time points of clock C, checking each is no earlier
+ * than the last. Returns the number of decreasing time points. */
+template<class C>
+long monotonic(void)
+{
+   typename C::time_point last, t;
+   long bad = 0;
+
+   last = C::now();
+   for(long i = 0; i < READS; i++) {
+      t = C::now();
+      if(t < last) bad++;
+      last = t;
+   }
+
+   return bad;
+}
+
+/* Measure elapsed time of clock C over a SLEEP millisecond sleep, and
+ * of nanoseconds(). Returns the difference, in nanoseconds. */
+template<class C>
+long long elapsed(long long *ns)
+{
+   typename C::time_point start;
+   typename C::duration d;
+   long long nstart;
+
+   start = C::now();
+   nstart = nanoseconds();
+   millisleep(SLEEP);
+   *ns = nanoelapsed(nstart);
+   d = C::now() - start;
+
+   return mp::to_nanoseconds(d) - *ns;
+}
+
+/* Measure the cost of now() of clock C, in nanoseconds per call. */
+template<class C>
+double cost(void)
+{
+   long long nstart, sum = 0;
+
+   nstart = nanoseconds();
+   for(long i = 0; i < READS; i++)
+      sum += C::now().time_since_epoch().count();
+   Sink = sum;
+
+   return (double) nanoelapsed(nstart) / READS;
+}
+
+/* Print a time point check result. Returns 0 on Pass, else 1. */
+int result(long bad)
+{
+   if(bad == 0) {
+      printf("Pass!\n");
+      return 0;
+   }
+   printf("Failed. decreasing= %ld\n", bad);
+
+   return 1;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   long long hz, ns, diff, prev, next;
+   long bad;
+   int i;
+   double steady, mono, coarse, tsc;
+   int fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin C++ Clock tests...\n");
+
+   hz = mp::TscClock::calibrate();
+#ifdef TSC_FALLBACK
+   printf("\n(time stamp counter unavailable, using nanoseconds())\n");
+#endif
+
+
+   printf("\nMonotonic time points w/ %d reads - mptime.hpp;\n", READS);
+   printf("  MonotonicClock... ");
+   fail += result(monotonic<mp::MonotonicClock>());
+   printf("  CoarseClock...    ");
+   fail += result(monotonic<mp::CoarseClock>());
+   printf("  TscClock...       ");
+   fail += result(monotonic<mp::TscClock>());
+
+
+   printf("\nElapsed time over %dms vs. nanoseconds() - mptime.hpp;\n", SLEEP);
+   printf("  MonotonicClock... ");
+   diff = elapsed<mp::MonotonicClock>(&ns);
+   printf("%+lldns, ", diff);
+   /* bracketing readings; within the cost of a reading */
+   if(diff >= 0 && diff < 1000000) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  CoarseClock...    ");
+   diff = elapsed<mp::CoarseClock>(&ns);
+   printf("%+lldus, ", diff / 1000);
+   if(diff > -COARSE * 1000000LL && diff < COARSE * 1000000LL)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+   printf("  TscClock...       ");
+   diff = elapsed<mp::TscClock>(&ns);
+   printf("%+lldns @ %.3fGHz, ", diff, (double) hz / 1e9);
+   if(diff > -(ns / 1000000 * TSCPPM) && diff < ns / 1000000 * TSCPPM)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nCost of now() w/ %d reads - mptime.hpp;\n", READS);
+   steady = cost<std::chrono::steady_clock>();
+   mono = cost<mp::MonotonicClock>();
+   coarse = cost<mp::CoarseClock>();
+   tsc = cost<mp::TscClock>();
+   printf("  steady/monotonic/coarse/tsc= %.1f/%.1f/%.1f/%.1fns, ",
+      steady, mono, coarse, tsc);
+   if(steady > 0 && mono > 0 && coarse > 0 && tsc > 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nTscClock across translation units - mptime.hpp;\n");
+   printf("  Alternating reads...   ");
+   prev = mp::TscClock::now().time_since_epoch().count();
+   for(bad = 0, i = 0; i < READS; i++) {
+      next = (i & 1) ? mp::TscClock::now().time_since_epoch().count()
+         : unit_tsc_now();
+      if(next < prev) bad++;
+      prev = next;
+   }
+   fail += result(bad);
+   printf("  Calibrate between...   ");
+   for(bad = 0, i = 0; i < 100; i++) {
+      prev = mp::TscClock::now().time_since_epoch().count();
+      if(unit_tsc_calibrate() != hz) bad++;
+      next = unit_tsc_now();
+      if(next < prev) bad++;
+      if(mp::TscClock::calibrate() != hz) bad++;
+      if(mp::TscClock::now().time_since_epoch().count() < next) bad++;
+   }
+   fail += result(bad);
+
+
+   return fail;
+}
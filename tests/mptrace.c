@@ -0,0 +1,285 @@
+/* ****************************************************************
+ * Test flight recorder trace events.
+ *  - mptrace.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Flight recorder trace events:
+ * - Offline decoding of the most recent events of every thread ring
+ * - Survival of events through a crash (SIGKILL) of the tracing process
+ * - Rejection of trace files with a corrupt header
+ * - Per-event recording cost, in nanoseconds
+ *
+ * NOTES:
+ * - The crash test requires fork(), and is skipped on Windows.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mptrace.h"
+#include "../src/mptime.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+
+#define TESTFILE  "mptrace.tmp"
+#define DUMPFILE  "mptrace.txt"
+#define THREADS   4
+#define SLOTS     1024
+#define EVENTS    10000    /* per thread, wrapping each ring */
+#define BENCH     1000000  /* events per thread */
+#define BUDGET    100      /* nanoseconds per event */
+
+/****************************************************************/
+
+Tracer Tr;
+Mutex Lock = MUTEX_INITIALIZER;
+volatile int Done;
+int Ids[2];
+
+/* Hold the calling thread until all THREADS threads are done, such
+ * that no ring (registry index) is recycled between threads. */
+void hold(void)
+{
+   mutex_lock(&Lock);
+   Done++;
+   mutex_unlock(&Lock);
+   while(Done < THREADS) millisleep(1);
+}
+
+/* Thread function recording EVENTS events, alternating event ids,
+ * with the event number and its square as arguments. */
+Threaded th_events(void *arg)
+{
+   long long i;
+
+   for(i = 0; i < EVENTS; i++)
+      trace_event(&Tr, Ids[i & 1], i, i * i);
+   hold();
+
+   return Treturn;
+}
+
+/* Thread function recording BENCH events. */
+Threaded th_bench(void *arg)
+{
+   int i;
+
+   for(i = 0; i < BENCH; i++)
+      trace_event(&Tr, Ids[0], i, 0);
+   hold();
+
+   return Treturn;
+}
+
+/* Record EVENTS events from each of THREADS threads. */
+void run_events(void)
+{
+   ThreadID tid[THREADS];
+   int i;
+
+   Done = 0;
+   Ids[0] = trace_define(&Tr, "tick");
+   Ids[1] = trace_define(&Tr, "tock");
+   for(i = 0; i < THREADS; i++)
+      thread_create(&tid[i], th_events, NULL);
+   thread_multiwait(tid, THREADS);
+}
+
+/* Decode the trace file, verifying every ring of a tracing thread holds
+ * exactly its most recent SLOTS events, in order, with valid arguments.
+ * Returns the number of invalid events. */
+int check_events(void)
+{
+   static long long next[THREAD_REGISTRY_MAX];
+   char line[256], name[TRACE_NAMELEN];
+   long long arg0, arg1;
+   unsigned ring;
+   int rings, bad;
+   long count;
+   FILE *fp;
+
+   fp = fopen(DUMPFILE, "w+");
+   if(fp == NULL) return 1;
+   count = trace_dump(TESTFILE, fp);
+   rewind(fp);
+   memset(next, 0, sizeof(next));
+   for(bad = 0; fgets(line, sizeof(line), fp); ) {
+      if(sscanf(line, "[%*[^]]] %u %31s %lld %lld", &ring, name, &arg0,
+         &arg1) != 4 || ring >= THREAD_REGISTRY_MAX) {
+         bad++;
+         continue;
+      }
+      /* first event of a ring is the oldest retained */
+      if(next[ring] == 0) next[ring] = EVENTS - SLOTS;
+      if(arg0 != next[ring] || arg1 != arg0 * arg0 ||
+         strcmp(name, (arg0 & 1) ? "tock" : "tick")) bad++;
+      next[ring] = arg0 + 1;
+   }
+   fclose(fp);
+   remove(DUMPFILE);
+   for(rings = ring = 0; ring < THREAD_REGISTRY_MAX; ring++) {
+      if(next[ring] == 0) continue;
+      if(next[ring] != EVENTS) bad++;
+      rings++;
+   }
+   if(count != (long) THREADS * SLOTS || rings != THREADS) bad++;
+
+   return bad;
+}
+
+/* Overwrite a header field of the trace file with `value`, and decode
+ * it, restoring the field after. Returns the result of trace_dump(),
+ * else -2 on error. */
+long corrupt_dump(size_t offset, unsigned value)
+{
+   unsigned saved;
+   long count;
+   FILE *fp, *out;
+
+   fp = fopen(TESTFILE, "r+b");
+   if(fp == NULL) return -2;
+   fseek(fp, (long) offset, SEEK_SET);
+   if(fread(&saved, sizeof(saved), 1, fp) != 1) saved = 0;
+   fseek(fp, (long) offset, SEEK_SET);
+   fwrite(&value, sizeof(value), 1, fp);
+   fclose(fp);
+   count = -2;
+   out = fopen(DUMPFILE, "w");
+   if(out) {
+      count = trace_dump(TESTFILE, out);
+      fclose(out);
+      remove(DUMPFILE);
+   }
+   fp = fopen(TESTFILE, "r+b");
+   if(fp == NULL) return count;
+   fseek(fp, (long) offset, SEEK_SET);
+   fwrite(&saved, sizeof(saved), 1, fp);
+   fclose(fp);
+
+   return count;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   ThreadID tid[THREADS];
+   long long nstart;
+   double cost;
+   int i, n, res, fail;
+#ifndef _WIN32
+   pid_t pid;
+#endif
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Flight Recorder tests...\n");
+
+
+   printf("\nOffline decoding w/ %d threads, %d slot rings - mptrace.h;\n",
+      THREADS, SLOTS);
+   printf("  Decode after close... ");
+   res = trace_open(&Tr, TESTFILE, THREADS + 1, SLOTS);
+   if(res == 0) {
+      run_events();
+      trace_close(&Tr);
+      res = check_events();
+   }
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. invalid= %d\n", res);
+   }
+
+   printf("  Decode after crash... ");
+#ifndef _WIN32
+   fflush(stdout);
+   pid = fork();
+   if(pid == 0) {
+      /* tracing process, killed without unmapping its trace file */
+      if(trace_open(&Tr, TESTFILE, THREADS + 1, SLOTS) == 0) run_events();
+      raise(SIGKILL);
+   }
+   waitpid(pid, &res, 0);
+   if(!WIFSIGNALED(res) || WTERMSIG(res) != SIGKILL) res = -1;
+   else res = check_events();
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. invalid= %d\n", res);
+   }
+#else
+   printf("Skipped, requires fork().\n");
+#endif
+
+   printf("  Corrupt headers...    ");
+   res = -1;
+   if(trace_open(&Tr, TESTFILE, 2, 4) == 0) {
+      trace_event(&Tr, trace_define(&Tr, "tick"), 1, 1);
+      trace_close(&Tr);
+      res = corrupt_dump(offsetof(TRACE_HEADER, version), TRACE_VERSION) != 1;
+      /* names beyond TRACE_NAMES, slots not a power of 2, or rings
+       * beyond the file, or overflowing the size of the rings */
+      res += corrupt_dump(offsetof(TRACE_HEADER, names), TRACE_NAMES + 1) != -1;
+      res += corrupt_dump(offsetof(TRACE_HEADER, slots), 3) != -1;
+      res += corrupt_dump(offsetof(TRACE_HEADER, slots), 0x80000000u) != -1;
+      res += corrupt_dump(offsetof(TRACE_HEADER, rings), 3) != -1;
+      res += corrupt_dump(offsetof(TRACE_HEADER, rings), 0xffffffffu) != -1;
+   }
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. accepted= %d\n", res);
+   }
+
+
+   printf("\nPer-event cost, budget= %dns - mptrace.h;\n", BUDGET);
+   trace_open(&Tr, TESTFILE, THREADS + 1, SLOTS);
+   Ids[0] = trace_define(&Tr, "bench");
+   for(i = 0; i < 2; i++) {
+      /* a single thread need not be held for others */
+      n = i ? THREADS : 1;
+      Done = THREADS - n;
+      nstart = nanoseconds();
+      for(res = 0; res < n; res++)
+         thread_create(&tid[res], th_bench, NULL);
+      thread_multiwait(tid, n);
+      cost = (double) nanoelapsed(nstart) / ((double) n * BENCH);
+      printf("  %d thread(s) x %d events... %.1fns/event, ", n, BENCH, cost);
+      if(cost < BUDGET)
+         printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed.\n");
+      }
+   }
+   trace_close(&Tr);
+   remove(TESTFILE);
+
+
+   return fail;
+}
@@ -17,8 +17,12 @@
  * ****************************************************************
  * Multiplatform utilities:
  * - Millisecond sleep and milli/microsecond high res time stamps
+ * - Stopwatch laps, stopped time, TimeStats accumulation and lap cost
+ * - Fast wall clock and cached ISO-8601 formatting, versus strftime()
  * - Threading and Mutex locks
  * - Shared read exclusive write locks
+ * - Thread registry with dense thread indexes
+ * - Thread affinity, pinning to each processor
  *
  * NOTES:
  * - The "Timing tests w/ subsecond timing comparisons" are known to
@@ -39,11 +43,14 @@
 #include "../src/mptime.h"
 
 #define THREADS  1000
+#define REGISTRY_THREADS  64
 #define ROUNDS   100000
 #define COUNT    100000000
 
 #define MILLITEST_PRECISION  1
 #define MICROTEST_PRECISION  10
+#define WALLTEST_PRECISION   100000  /* nanoseconds */
+#define STAMPS               100000
 
 /* Checks a value is within tolerance of an expected value. */
 #define WITHIN_TOLERANCE(v,e,t)  ( v > (e - t) && v < (e + t) )
@@ -53,6 +60,7 @@
 /* Struct for passing multiple arugments to thread function. */
 typedef struct {
    Mutex *mutexlock;
+   Spinlock *spinlock;
    int lockmethod;
    int nonvol_count;
    volatile int count;
@@ -76,14 +84,18 @@ Threaded mts_inc(void *arg)
 
    if(mts->lockmethod > 1 && mts->lockmethod < 4)
       mutex_lock(mts->mutexlock);
+   if(mts->lockmethod == 5)
+      spinlock_lock(mts->spinlock);
 
    for(i = 0; i < ROUNDS; i++) {
       if(mts->lockmethod == 0) mts->nonvol_count++;
-      else if(mts->lockmethod < 4) mts->count++;
+      else if(mts->lockmethod < 4 || mts->lockmethod == 5) mts->count++;
    }
 
    if(mts->lockmethod > 1 && mts->lockmethod < 4)
       mutex_unlock(mts->mutexlock);
+   if(mts->lockmethod == 5)
+      spinlock_unlock(mts->spinlock);
 
    if(mts->lockmethod == 4) {
       mutex_lock(mts->mutexlock);
@@ -132,6 +144,48 @@ Threaded rws_wrload(void *arg)
    return Treturn;
 }
 
+/* Struct for passing thread registry arguments to thread function. */
+typedef struct {
+   Mutex lock;
+   unsigned char seen[THREAD_REGISTRY_MAX];
+   int duplicate;
+   volatile int registered;
+} TRState;
+
+/* Thread function testing unique dense index assignment of the thread
+ * registry, holding registration until all threads are registered. */
+Threaded trs_register(void *arg)
+{
+   TRState *trs;
+   int idx;
+
+   trs = (TRState *) arg;
+
+   idx = thread_register();
+   mutex_lock(&trs->lock);
+   if(idx < 0 || idx >= THREAD_REGISTRY_MAX || trs->seen[idx])
+      trs->duplicate++;
+   else trs->seen[idx] = 1;
+   trs->registered++;
+   mutex_unlock(&trs->lock);
+
+   /* exit without unregistering once all threads are registered */
+   while(trs->registered < REGISTRY_THREADS) millisleep(1);
+
+   return Treturn;
+}
+
+/* Format a wall clock time stamp, as an ISO-8601 time stamp with
+ * nanosecond digits, using gmtime() and strftime(). */
+void strftime_stamp(char *buf, long long ns)
+{
+   time_t t = (time_t) (ns / NANOSECONDS);
+   size_t len;
+
+   len = strftime(buf, ISO8601_LEN, "%Y-%m-%dT%H:%M:%S", gmtime(&t));
+   sprintf(buf + len, ".%09dZ", (int) (ns % NANOSECONDS));
+}
+
 /****************************************************************/
 
 /* Returns number of tests failed */
@@ -140,13 +194,26 @@ int main()
    MTState mts;
    Mutex mutex;
    Mutex mutex_static = MUTEX_INITIALIZER;
+   Spinlock spinlock = SPINLOCK_INITIALIZER;
    RWState rws;
    RWLock rwlock;
    RWLock rwlock_static = RWLOCK_INITIALIZER;
+   TRState trs;
    ThreadID threadlist[THREADS];
+   int idxlist[THREAD_REGISTRY_MAX];
    long mstart, mexpected, mresult;
    long ustart, uexpected, uresult;
    float elapsed, elapsed2;
+   static const long long samples[] = { 2, 4, 4, 4, 5, 5, 7, 9 };
+   static long long stamps[] = {
+      0LL, 951782400500000000LL, 951868799999999999LL, 1700000000123456789LL,
+      4107542399000000001LL, 4107542400000000000LL, 32503680000000000LL
+   };
+   char stamp[ISO8601_LEN], expect[ISO8601_LEN];
+   TimeCache cache = TIMECACHE_INITIALIZER;
+   TimeStats ts, half, rest;
+   Stopwatch sw;
+   long long nstart, ns, nslow, nfast;
    time_t begin;
    int i, j, res, min, max, avg, fail;
 
@@ -231,8 +298,145 @@ int main()
    }
 
 
+   printf("\nStopwatch tests - time.c;\n");
+   printf("  Laps cover running time...    ");
+   stopwatch_reset(&sw);
+   nstart = nanoseconds();
+   stopwatch_start(&sw);
+   for(nslow = 0, i = 1; i <= 5; i++) {
+      millisleep(i * 10);
+      nslow += stopwatch_lap(&sw);
+   }
+   ns = stopwatch_stop(&sw);
+   nstart = nanoelapsed(nstart);
+   /* mean of laps is exact to within rounding of the sum */
+   nfast = (long long) (sw.laps.mean * (double) sw.laps.count + 0.5);
+   printf("%d laps of %d..%dms, ", (int) sw.laps.count,
+      (int) (sw.laps.min / 1000000), (int) (sw.laps.max / 1000000));
+   if(sw.laps.count == 5 && sw.laps.min >= 10000000 &&
+      sw.laps.max >= 50000000 && WITHIN_TOLERANCE(nfast, nslow, 2) &&
+      ns >= nslow && WITHIN_TOLERANCE(ns, nstart, 1000000))
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. %lld/%lld/%lldns\n", nslow, ns, nstart);
+   }
+
+   printf("  Stopped time excluded...      ");
+   stopwatch_reset(&sw);
+   stopwatch_start(&sw);
+   millisleep(20);
+   stopwatch_stop(&sw);
+   millisleep(50);
+   stopwatch_start(&sw);
+   millisleep(20);
+   nslow = stopwatch_stop(&sw);
+   /* a lap of a stopped Stopwatch is its running time since reset */
+   ns = stopwatch_lap(&sw);
+   printf("lap= %dms, ", (int) (ns / 1000000));
+   if(ns >= 40000000 && ns < 65000000 && ns == nslow &&
+      stopwatch_elapsed(&sw) == nslow) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   printf("  TimeStats add and merge...    ");
+   memset(&ts, 0, sizeof(ts));
+   memset(&half, 0, sizeof(half));
+   memset(&rest, 0, sizeof(rest));
+   for(i = 0; i < 8; i++) {
+      timestats_add(&ts, samples[i]);
+      timestats_add(i < 3 ? &half : &rest, samples[i]);
+   }
+   /* mean 5, sample variance 32/7 */
+   res = ts.count != 8 || ts.min != 2 || ts.max != 9 || ts.mean != 5.0;
+   res += !WITHIN_TOLERANCE(timestats_variance(&ts), 32.0 / 7, 1e-12);
+   memset(&ts, 0, sizeof(ts));
+   timestats_merge(&ts, &half);
+   timestats_merge(&ts, &rest);
+   res += ts.count != 8 || ts.min != 2 || ts.max != 9;
+   res += !WITHIN_TOLERANCE(ts.mean, 5.0, 1e-12);
+   res += !WITHIN_TOLERANCE(timestats_variance(&ts), 32.0 / 7, 1e-12);
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d\n", res);
+   }
+
+   printf("  Lap cost (ns)...              ");
+   stopwatch_reset(&sw);
+   stopwatch_start(&sw);
+   for(i = 0; i < STAMPS; i++) stopwatch_lap(&sw);
+   nfast = stopwatch_stop(&sw) / STAMPS;
+   printf("mean/min/max= %.1f/%d/%d, ", sw.laps.mean, (int) sw.laps.min,
+      (int) sw.laps.max);
+   if(sw.laps.count == STAMPS && nfast < 1000)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nWall clock and ISO-8601 tests - time.c;\n");
+   printf("  Fast wall clock vs. realtime... ");
+   for(max = i = 0; i < STAMPS; i++) {
+      /* error outside of the bracketing realtime readings */
+      nstart = realnanoseconds();
+      ns = walltime();
+      if(ns < nstart) ns = nstart - ns;
+      else if(ns > (nstart = realnanoseconds())) ns -= nstart;
+      else ns = 0;
+      if(max < ns) max = (int) ns;
+   }
+   printf("max= %dns, ", max);
+   if(max < WALLTEST_PRECISION)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+   printf("  ISO-8601 vs. strftime()...      ");
+   for(res = i = 0; i < (int) (sizeof(stamps) / sizeof(*stamps)); i++) {
+      strftime_stamp(expect, stamps[i]);
+      iso8601(&cache, stamp, stamps[i], 9);
+      if(strcmp(stamp, expect)) res++;
+   }
+   /* fractional digits, within a cached second */
+   iso8601(&cache, stamp, stamps[3], 3);
+   if(strcmp(stamp, "2023-11-14T22:13:20.123Z")) res++;
+   iso8601(&cache, stamp, stamps[3] + 1, 0);
+   if(strcmp(stamp, "2023-11-14T22:13:20Z")) res++;
+   if(res == 0)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. mismatched= %d\n", res);
+   }
+
+   printf("  Time stamp cost (ns)...         ");
+   nstart = nanoseconds();
+   for(i = 0; i < STAMPS; i++)
+      strftime_stamp(stamp, realnanoseconds());
+   nslow = nanoelapsed(nstart) / STAMPS;
+   nstart = nanoseconds();
+   for(i = 0; i < STAMPS; i++)
+      iso8601(&cache, stamp, walltime(), 9);
+   nfast = nanoelapsed(nstart) / STAMPS;
+   printf("strftime/iso8601= %d/%d, ", (int) nslow, (int) nfast);
+   if(nfast < nslow)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
    printf("\nThreading and mutex tests w/ %d threads - thread.c;\n", THREADS);
-   for(i = 0; i < 5; i++) {
+   for(i = 0; i < 6; i++) {
       mts.count = 0;
       mts.nonvol_count = 0;
       mts.lockmethod = i;
@@ -255,17 +459,22 @@ int main()
          case 4:
             printf("  Intermediate counter, Mutex guard...  ");
             break;
+         case 5:
+            printf("  Statically initialized Spinlock...    ");
+            mts.spinlock = &spinlock;
+            break;
          default:
             printf("Unknown Threading and Mutex test...\n");
             continue;
       }
 
-      ustart = microseconds();
+      stopwatch_reset(&sw);
+      stopwatch_start(&sw);
       for(j = 0; j < THREADS; j++)
          thread_create(&threadlist[j], mts_inc, &mts);
       thread_wait(threadlist);
       thread_multiwait(threadlist, THREADS);
-      elapsed = (float) microelapsed(ustart) / MICROSECONDS;
+      elapsed = (float) stopwatch_seconds(&sw);
 
       printf("%9d in %.03fs, ", mts.count, elapsed);
       if(mts.count == COUNT)
@@ -289,7 +498,8 @@ int main()
          rwlock_init(&rwlock);
          rws.lock = &rwlock;
       }
-      ustart = microseconds();
+      stopwatch_reset(&sw);
+      stopwatch_start(&sw);
       thread_create(threadlist, rws_wrload, &rws);
       for(res = 0; res == 0; ) {
          rwlock_rdlock((RWLock *) rws.lock);
@@ -297,7 +507,7 @@ int main()
          rwlock_rdunlock((RWLock *) rws.lock);
       }
       thread_wait(threadlist);
-      elapsed = (float) microelapsed(ustart) / MICROSECONDS;
+      elapsed = (float) stopwatch_seconds(&sw);
       printf("%.03fs, ", elapsed);
 
       if(res == COUNT)
@@ -314,21 +524,23 @@ int main()
    printf("mutex: ");
    rws.lock = &mutex;
    rws.lockmethod = 0;
-   ustart = microseconds();
+   stopwatch_reset(&sw);
+   stopwatch_start(&sw);
    for(j = 0; j < 4; j++)
       thread_create(&threadlist[j], rws_rdload, &rws);
    thread_multiwait(threadlist, 4);
-   elapsed = (float) microelapsed(ustart) / MICROSECONDS;
+   elapsed = (float) stopwatch_seconds(&sw);
    printf("%.03fs", elapsed);
 
    printf(" / rwlock: ");
    rws.lock = &rwlock;
    rws.lockmethod = 1;
-   ustart = microseconds();
+   stopwatch_reset(&sw);
+   stopwatch_start(&sw);
    for(j = 0; j < 4; j++)
       thread_create(&threadlist[j], rws_rdload, &rws);
    thread_multiwait(threadlist, 4);
-   elapsed2 = (float) microelapsed(ustart) / MICROSECONDS;
+   elapsed2 = (float) stopwatch_seconds(&sw);
    printf("%.03fs", elapsed2);
 
    if(elapsed > elapsed2)
@@ -339,5 +551,63 @@ int main()
    }
 
 
+   printf("\nThread registry tests w/ %d threads - thread.c;\n",
+      REGISTRY_THREADS);
+   printf("  Dense index assignment... ");
+   memset(&trs, 0, sizeof(trs));
+   mutex_init(&trs.lock);
+   res = thread_register();
+   for(j = 0; j < REGISTRY_THREADS; j++)
+      thread_create(&threadlist[j], trs_register, &trs);
+   thread_multiwait(threadlist, REGISTRY_THREADS);
+   for(i = j = 0; i <= REGISTRY_THREADS; i++) j += trs.seen[i];
+   if(res == 0 && trs.duplicate == 0 && j == REGISTRY_THREADS)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. main= %d, duplicates= %d\n", res, trs.duplicate);
+   }
+   mutex_free(&trs.lock);
+
+   printf("  Index recycling on exit... ");
+   res = thread_enumerate(NULL, idxlist, THREAD_REGISTRY_MAX);
+   if(res == 1 && idxlist[0] == thread_index())
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. live= %d\n", res);
+   }
+
+   printf("  Unregister and re-register... ");
+   res = thread_unregister();
+   if(res == 0 && thread_index() == -1 && thread_register() == 0 &&
+      thread_unregister() == 0 && thread_unregister() == -1)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   printf("\nThread affinity tests w/ %d processors - thread.c;\n",
+      thread_cpucount());
+   printf("  Pin to each processor... ");
+   res = thread_setaffinity(0);
+   if(res == ENOTSUP)
+      printf("Skipped, unsupported.\n");
+   else {
+      for(i = 1; res == 0 && i < thread_cpucount(); i++)
+         res = thread_setaffinity(i);
+      /* release the pin, and reject an invalid processor */
+      if(res == 0) res = thread_setaffinity(-1);
+      if(res == 0 && thread_setaffinity(1 << 30) != 0)
+         printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed. ecode= %d\n", res);
+      }
+   }
+
+
    return fail;
 }
@@ -0,0 +1,300 @@
+/* ****************************************************************
+ * Test watchdog support.
+ *  - mpwatch.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Watchdog:
+ * - A lock held beyond the threshold reported once, by name and thread
+ * - Short lock holds never reported
+ * - Nested locks released out of order; only the long hold reported
+ * - A stalled task reported, while a task with heartbeats, and an idle
+ *   worker, are not
+ * - Threads watched in different translation units, linked with
+ *   unit/mpwatch.c, held in distinct slots and reported by their own
+ *   registry index
+ * - Cost of watched Mutex and Spinlock lock/unlock, versus unwatched
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpwatch.h"
+
+#define THRESHOLD  40      /* milliseconds */
+#define STALL      200     /* milliseconds of a stall */
+#define REPORTS    16
+#define ROUNDS     1000000 /* lock/unlock rounds of the benchmark */
+#define UNITS      4       /* threads holding locks across units */
+
+/* Watchdog functions of the second translation unit */
+int unit_register(void);
+int unit_mutex_lock(Watchdog *wd, Mutex *mutex, const char *name);
+int unit_mutex_unlock(Watchdog *wd, Mutex *mutex);
+
+/****************************************************************/
+
+/* Reports recorded by the watchdog thread, read after watch_free(). */
+typedef struct {
+   WatchReport report[REPORTS];
+   int count;
+} RECORD;
+
+/* Worker thread arguments. */
+typedef struct {
+   Watchdog *wd;
+   Mutex *mutex;
+   int work;         /* 0 = stall a task, 1 = beat a task, 2 = stay idle */
+   int unit;         /* translation unit of the hold, 0 or 1 */
+   int thread;       /* registry index of the worker */
+} WORKER;
+
+/* Report function recording reports. */
+void record(void *ctx, const WatchReport *report)
+{
+   RECORD *r = (RECORD *) ctx;
+
+   if(r->count < REPORTS) r->report[r->count] = *report;
+   r->count++;
+}
+
+/* Thread holding a watched Mutex for STALL milliseconds. */
+Threaded thread_hold(void *arg)
+{
+   WORKER *w = (WORKER *) arg;
+
+   if(w->unit) {
+      w->thread = unit_register();
+      unit_mutex_lock(w->wd, w->mutex, "unit");
+      millisleep(STALL);
+      unit_mutex_unlock(w->wd, w->mutex);
+   } else {
+      w->thread = thread_register();
+      watch_mutex_lock(w->wd, w->mutex, "slow");
+      millisleep(STALL);
+      watch_mutex_unlock(w->wd, w->mutex);
+   }
+
+   return Treturn;
+}
+
+/* Worker thread running a task for STALL milliseconds; either stalled,
+ * with heartbeats, or idle throughout. */
+Threaded thread_work(void *arg)
+{
+   WORKER *w = (WORKER *) arg;
+   int i;
+
+   w->thread = thread_register();
+   if(w->work == 0) {
+      watch_task(w->wd, "stuck");
+      millisleep(STALL);
+   } else if(w->work == 1) {
+      watch_task(w->wd, "busy");
+      for(i = 0; i < STALL / 10; i++) {
+         millisleep(10);
+         watch_beat(w->wd);
+      }
+   } else millisleep(STALL);
+   watch_idle(w->wd);
+
+   return Treturn;
+}
+
+/* Returns mean nanoseconds per lock/unlock round of a Mutex (`spin` = 0)
+ * or Spinlock, watched by `wd` (or unwatched, where NULL). */
+double bench(Watchdog *wd, int spin)
+{
+   static Mutex mutex = MUTEX_INITIALIZER;
+   static Spinlock spinlock = SPINLOCK_INITIALIZER;
+   long long nstart;
+   int i;
+
+   nstart = nanoseconds();
+   for(i = 0; i < ROUNDS; i++) {
+      if(spin) {
+         watch_spin_lock(wd, &spinlock, "bench");
+         watch_spin_unlock(wd, &spinlock);
+      } else {
+         watch_mutex_lock(wd, &mutex, "bench");
+         watch_mutex_unlock(wd, &mutex);
+      }
+   }
+
+   return (double) nanoelapsed(nstart) / ROUNDS;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   static const char *kinds[] = { "mutex", "spinlock" };
+   Watchdog wd;
+   RECORD r;
+   Mutex mutex, a, b;
+   ThreadID tid[UNITS];
+   WORKER w[UNITS];
+   Mutex m[UNITS];
+   double base, watched;
+   int i, j, idx, res, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Watchdog tests...\n");
+
+
+   printf("\nLock holds w/ %dms threshold - mpwatch.h;\n", THRESHOLD);
+   printf("  Long hold reported once...      ");
+   memset(&r, 0, sizeof(r));
+   memset(w, 0, sizeof(w));
+   mutex_init(&mutex);
+   if(watch_init(&wd, THRESHOLD, record, &r)) {
+      printf("Failed. watch_init()\n");
+      return 1;
+   }
+   w[0].wd = &wd;
+   w[0].mutex = &mutex;
+   thread_create(&tid[0], thread_hold, &w[0]);
+   thread_wait(&tid[0]);
+   watch_free(&wd);
+   if(r.count == 1 && r.report[0].kind == WATCH_LOCK &&
+      r.report[0].lock == &mutex && strcmp(r.report[0].name, "slow") == 0 &&
+      r.report[0].thread == w[0].thread && r.report[0].ms > THRESHOLD &&
+      r.report[0].ms <= STALL + THRESHOLD) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. reports= %d\n", r.count);
+   }
+
+   printf("  Short holds not reported...     ");
+   memset(&r, 0, sizeof(r));
+   watch_init(&wd, THRESHOLD, record, &r);
+   for(i = 0; i < STALL; i++) {
+      watch_mutex_lock(&wd, &mutex, "fast");
+      watch_mutex_unlock(&wd, &mutex);
+      millisleep(1);
+   }
+   watch_free(&wd);
+   if(r.count == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. reports= %d\n", r.count);
+   }
+
+   printf("  Out of order release...         ");
+   memset(&r, 0, sizeof(r));
+   mutex_init(&a);
+   mutex_init(&b);
+   watch_init(&wd, THRESHOLD, record, &r);
+   idx = thread_register();
+   watch_mutex_lock(&wd, &a, "a");
+   watch_mutex_lock(&wd, &b, "b");
+   watch_mutex_unlock(&wd, &a);
+   millisleep(STALL);
+   watch_mutex_unlock(&wd, &b);
+   watch_free(&wd);
+   if(r.count == 1 && r.report[0].lock == &b && r.report[0].thread == idx)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. reports= %d\n", r.count);
+   }
+
+   printf("  Holds across units...           ");
+   memset(&r, 0, sizeof(r));
+   memset(w, 0, sizeof(w));
+   watch_init(&wd, THRESHOLD, record, &r);
+   for(i = 0; i < UNITS; i++) {
+      mutex_init(&m[i]);
+      w[i].wd = &wd;
+      w[i].mutex = &m[i];
+      w[i].unit = i & 1;
+      thread_create(&tid[i], thread_hold, &w[i]);
+   }
+   thread_multiwait(tid, UNITS);
+   watch_free(&wd);
+   /* one report per hold, naming the thread and unit of the hold */
+   for(res = i = 0; i < r.count && i < REPORTS; i++) {
+      j = (int) ((Mutex *) r.report[i].lock - m);
+      if(j < 0 || j >= UNITS || r.report[i].thread != w[j].thread ||
+         strcmp(r.report[i].name, (j & 1) ? "unit" : "slow") != 0) continue;
+      res |= 1 << j;
+   }
+   for(i = 0; i < UNITS; i++) {
+      for(j = 0; j < i; j++) if(w[i].thread == w[j].thread) res = 0;
+      mutex_free(&m[i]);
+   }
+   if(r.count == UNITS && res == (1 << UNITS) - 1)
+      printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. reports= %d\n", r.count);
+   }
+   mutex_free(&b);
+   mutex_free(&a);
+
+
+   printf("\nWorker heartbeats w/ %dms threshold - mpwatch.h;\n", THRESHOLD);
+   printf("  Only the stalled task reported..");
+   memset(&r, 0, sizeof(r));
+   memset(w, 0, sizeof(w));
+   watch_init(&wd, THRESHOLD, record, &r);
+   for(i = 0; i < 3; i++) {
+      w[i].wd = &wd;
+      w[i].work = i;
+      thread_create(&tid[i], thread_work, &w[i]);
+   }
+   thread_multiwait(tid, 3);
+   watch_free(&wd);
+   if(r.count == 1 && r.report[0].kind == WATCH_TASK &&
+      strcmp(r.report[0].name, "stuck") == 0 &&
+      r.report[0].thread == w[0].thread) printf(" Pass!\n");
+   else {
+      fail++;
+      printf(" Failed. reports= %d\n", r.count);
+   }
+   printf("  Report format...\n");
+   for(i = 0; i < r.count && i < REPORTS; i++) {
+      printf("    ");
+      watch_print(stdout, &r.report[i]);
+   }
+
+
+   printf("\nLock/unlock cost - mpwatch.h;\n");
+   printf("  lock        unwatched    watched\n");
+   memset(&r, 0, sizeof(r));
+   watch_init(&wd, 1000, record, &r);
+   for(i = 0; i < 2; i++) {
+      base = bench(NULL, i);
+      watched = bench(&wd, i);
+      printf("  %-9s %9.1fns %9.1fns\n", kinds[i], base, watched);
+   }
+   watch_free(&wd);
+   printf("  Watched locks released...       ");
+   /* a fast path leaving holds recorded would be reported */
+   if(r.count == 0) printf("Pass!\n");
+   else {
+      fail++;
+      printf("Failed. reports= %d\n", r.count);
+   }
+   mutex_free(&mutex);
+
+
+   return fail;
+}
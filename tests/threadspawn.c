@@ -0,0 +1,228 @@
+/* ****************************************************************
+ * Thread creation and join cost benchmark.
+ *  - threadspawn.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Thread creation and join cost:
+ * - Cost per thread (create and join), sequentially and in bursts, and
+ *   start latency (create to first instruction) of thread_create_stack(),
+ *   at various stack sizes; latency samples are reduced to their mean,
+ *   median and 99th percentile (mpstats.h)
+ * - Likewise, of pre-spawned threads of a ThreadReserve
+ * - Bursts of threads, started together and joined together
+ *
+ * NOTES:
+ * - Start latency includes scheduling of the new (or parked) thread,
+ *   and so depends on the number of idle processors.
+ *
+ * ****************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mpstats.h"
+#include "../src/mpthread.h"
+#include "../src/mptime.h"
+
+#define SPAWNS   2000  /* sequential spawns per measurement */
+#define BURST    16    /* threads per burst, and reserve size */
+#define BURSTS   200   /* bursts per measurement */
+
+/****************************************************************/
+
+/* Spawn time stamps of a thread, for start latency. */
+typedef struct {
+   long long created;
+   long long started;
+} SPAWN;
+
+/* Thread function recording its start time. */
+Threaded th_start(void *arg)
+{
+   SPAWN *sp = (SPAWN *) arg;
+
+   sp->started = nanoseconds();
+
+   return Treturn;
+}
+
+/* Spawn cost results, in nanoseconds per thread. */
+typedef struct {
+   double total;     /* sequential spawn and join */
+   double burst;     /* spawn and join, in bursts */
+   double latency;   /* sequential spawn to start, mean */
+   double p50, p99;  /* sequential spawn to start, percentiles */
+   int ecode;
+} COST;
+
+/* Start latency samples of sequential spawns, in nanoseconds. */
+double Latency[SPAWNS];
+
+/* Reduce `n` start latency samples into the latency of `cost`. */
+void cost_latency(COST *cost, size_t n)
+{
+   Stats stats;
+
+   stats_summary(Latency, n, &stats);
+   cost->latency = stats.mean;
+   cost->p50 = stats_percentile(Latency, n, 50);
+   cost->p99 = stats_percentile(Latency, n, 99);
+}
+
+/* Measure sequential create/join of threads with `stacksize` stacks. */
+COST cost_create(size_t stacksize)
+{
+   static SPAWN sp[BURST];
+   ThreadID tid[BURST];
+   long long nstart;
+   COST cost;
+   int i, j;
+
+   memset(&cost, 0, sizeof(cost));
+   nstart = nanoseconds();
+   for(i = 0; i < SPAWNS && !cost.ecode; i++) {
+      sp[0].created = nanoseconds();
+      cost.ecode = thread_create_stack(&tid[0], th_start, &sp[0], stacksize);
+      if(cost.ecode == 0) cost.ecode = thread_wait(&tid[0]);
+      Latency[i] = (double) (sp[0].started - sp[0].created);
+   }
+   cost.total = (double) nanoelapsed(nstart) / SPAWNS;
+   cost_latency(&cost, (size_t) i);
+
+   nstart = nanoseconds();
+   for(i = 0; i < BURSTS && !cost.ecode; i++) {
+      for(j = 0; j < BURST && !cost.ecode; j++)
+         cost.ecode = thread_create_stack(&tid[j], th_start, &sp[j], stacksize);
+      thread_multiwait(tid, j);
+   }
+   cost.burst = (double) nanoelapsed(nstart) / (BURSTS * BURST);
+
+   return cost;
+}
+
+/* Measure sequential spawn/wait of threads of a ThreadReserve. */
+COST cost_reserve(ThreadReserve *res, long *runs)
+{
+   static SPAWN sp[BURST];
+   int slot[BURST];
+   long long nstart;
+   size_t n;
+   COST cost;
+   int i, j;
+
+   memset(&cost, 0, sizeof(cost));
+   nstart = nanoseconds();
+   for(n = i = 0; i < SPAWNS && !cost.ecode; i++) {
+      sp[0].created = nanoseconds();
+      sp[0].started = 0;
+      cost.ecode = reserve_spawn(res, &slot[0], th_start, &sp[0]);
+      if(cost.ecode == 0) cost.ecode = reserve_wait(res, slot[0]);
+      if(sp[0].started == 0) continue;
+      Latency[n++] = (double) (sp[0].started - sp[0].created);
+      (*runs)++;
+   }
+   cost.total = (double) nanoelapsed(nstart) / SPAWNS;
+   cost_latency(&cost, n);
+
+   nstart = nanoseconds();
+   for(i = 0; i < BURSTS && !cost.ecode; i++) {
+      for(j = 0; j < BURST && !cost.ecode; j++) {
+         sp[j].started = 0;
+         cost.ecode = reserve_spawn(res, &slot[j], th_start, &sp[j]);
+      }
+      while(j-- > 0) {
+         if(reserve_wait(res, slot[j]) == 0 && sp[j].started) (*runs)++;
+      }
+   }
+   cost.burst = (double) nanoelapsed(nstart) / (BURSTS * BURST);
+
+   return cost;
+}
+
+/****************************************************************/
+
+/* Returns number of tests failed */
+int main()
+{
+   static const size_t stacks[] = { 0, 16384, 65536, 262144, 1048576 };
+   ThreadReserve res;
+   COST cost, create, reserve;
+   long runs;
+   int i, fail;
+
+   fail = 0;
+   printf("\n___________________\n");
+   printf("Begin Thread Spawn benchmark...\n");
+
+
+   printf("\nThread create/join, %d sequential + %d bursts of %d;\n",
+      SPAWNS, BURSTS, BURST);
+   memset(&create, 0, sizeof(create));
+   for(i = 0; i < (int) (sizeof(stacks) / sizeof(*stacks)); i++) {
+      if(stacks[i] == 0) printf("  default stack... ");
+      else printf("  %4luKiB stack... ", (unsigned long) stacks[i] / 1024);
+      cost = cost_create(stacks[i]);
+      if(i == 0) create = cost;
+      if(cost.ecode) {
+         fail++;
+         printf("Failed. ecode= %d\n", cost.ecode);
+      } else printf("%5.1fus seq, %5.1fus burst, %5.1fus latency "
+         "(p50/p99 %.1f/%.1fus), Pass!\n", cost.total / 1000,
+         cost.burst / 1000, cost.latency / 1000, cost.p50 / 1000,
+         cost.p99 / 1000);
+   }
+
+
+   printf("\nThread reserve of %d pre-spawned threads, likewise;\n", BURST);
+   printf("  default stack... ");
+   runs = 0;
+   memset(&reserve, 0, sizeof(reserve));
+   reserve.ecode = reserve_init(&res, BURST, 0);
+   if(reserve.ecode == 0) {
+      reserve = cost_reserve(&res, &runs);
+      reserve_free(&res);
+   }
+   if(reserve.ecode == 0 && runs == SPAWNS + BURSTS * BURST)
+      printf("%5.1fus seq, %5.1fus burst, %5.1fus latency "
+         "(p50/p99 %.1f/%.1fus), Pass!\n", reserve.total / 1000,
+         reserve.burst / 1000, reserve.latency / 1000, reserve.p50 / 1000,
+         reserve.p99 / 1000);
+   else {
+      fail++;
+      printf("Failed. ecode= %d, runs= %ld\n", reserve.ecode, runs);
+   }
+
+   printf("  Versus create/join... ");
+   if(reserve.ecode == 0 && reserve.burst > 0 && reserve.latency > 0) {
+      printf("%.1fx seq, %.1fx burst, %.1fx latency, ",
+         create.total / reserve.total, create.burst / reserve.burst,
+         create.latency / reserve.latency);
+      if(reserve.total < create.total && reserve.burst < create.burst)
+         printf("Pass!\n");
+      else {
+         fail++;
+         printf("Failed.\n");
+      }
+   } else {
+      fail++;
+      printf("Failed.\n");
+   }
+
+
+   return fail;
+}
@@ -0,0 +1,31 @@
+/* ****************************************************************
+ * Second translation unit of the thread pool test.
+ *  - unit/mppool.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Task functions, submitted from the test's first translation unit,
+ * observing the task token as seen by this translation unit.
+ *
+ * ****************************************************************/
+
+#include "../../src/mppool.h"
+
+/* Task function recording its task token, at `arg`. */
+int unit_task_token(void *arg)
+{
+   *((CancelToken **) arg) = task_token();
+
+   return 0;
+}
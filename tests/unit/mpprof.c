@@ -0,0 +1,39 @@
+/* ****************************************************************
+ * Second translation unit of the sampling profiler test.
+ *  - unit/mpprof.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Profiler functions, called from the test's first translation unit,
+ * operating on the active Profiler as seen by this translation unit.
+ *
+ * ****************************************************************/
+
+#ifdef __linux__
+
+#include "../../src/mpprof.h"
+
+/* Initialize a Profiler. Returns 0 on success, else error code. */
+int unit_prof_init(Profiler *prof, unsigned hz)
+{
+   return prof_init(prof, hz);
+}
+
+/* Returns the active Profiler, or NULL. */
+Profiler *unit_prof_active(void)
+{
+   return Active_mpprof;
+}
+
+#endif
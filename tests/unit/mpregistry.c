@@ -0,0 +1,47 @@
+/* ****************************************************************
+ * Second translation unit of the thread registry test.
+ *  - unit/mpregistry.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Registry functions, called from the test's first translation unit,
+ * operating on the thread registry as seen by this translation unit.
+ *
+ * ****************************************************************/
+
+#include "../../src/mpthread.h"
+
+/* Register the current thread. Returns thread index, or -1. */
+int unit_register(void)
+{
+   return thread_register();
+}
+
+/* Returns the index of the current thread, or -1. */
+int unit_index(void)
+{
+   return thread_index();
+}
+
+/* Unregister the current thread. Returns 0 on success, else -1. */
+int unit_unregister(void)
+{
+   return thread_unregister();
+}
+
+/* Returns the number of live registered threads. */
+int unit_enumerate(void)
+{
+   return thread_enumerate(NULL, NULL, THREAD_REGISTRY_MAX);
+}
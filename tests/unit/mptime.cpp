@@ -0,0 +1,35 @@
+/* ****************************************************************
+ * Second translation unit of the C++ clock test.
+ *  - unit/mptime.cpp (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Clock functions, called from the test's first translation unit,
+ * reading the time stamp counter as calibrated by this translation unit.
+ *
+ * ****************************************************************/
+
+#include "../../src/mptime.hpp"
+
+/* Returns a TscClock time point, in nanoseconds. */
+long long unit_tsc_now()
+{
+   return mp::TscClock::now().time_since_epoch().count();
+}
+
+/* Calibrate the time stamp counter. Returns ticks per second. */
+long long unit_tsc_calibrate()
+{
+   return mp::TscClock::calibrate();
+}
@@ -0,0 +1,41 @@
+/* ****************************************************************
+ * Second translation unit of the watchdog test.
+ *  - unit/mpwatch.c (18 October 2026)
+ *
+ * Original work Copyright (c) 2026 Zalamanda
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * ****************************************************************
+ * Watchdog functions, called from the test's first translation unit,
+ * recording into thread slots as seen by this translation unit.
+ *
+ * ****************************************************************/
+
+#include "../../src/mpwatch.h"
+
+/* Register the current thread. Returns thread index, or -1. */
+int unit_register(void)
+{
+   return thread_register();
+}
+
+/* Lock a watched Mutex. Returns 0 on success, else error code. */
+int unit_mutex_lock(Watchdog *wd, Mutex *mutex, const char *name)
+{
+   return watch_mutex_lock(wd, mutex, name);
+}
+
+/* Unlock a watched Mutex. Returns 0 on success, else error code. */
+int unit_mutex_unlock(Watchdog *wd, Mutex *mutex)
+{
+   return watch_mutex_unlock(wd, mutex);
+}